@@ -0,0 +1,143 @@
+#include "Webserv.hpp"
+#include "ConfigParser.hpp"
+#include "Response.hpp"
+#include "ClientPool.hpp"
+#include <new>
+#include <cstdio>
+
+/**
+ * Allocation-count benchmark for the request → response pipeline
+ *
+ * Every operator new is counted. For configs with 1 to 500 extra
+ * locations, the same static GET is parsed and answered REQUESTS times,
+ * once with a fresh Client per request and once on a single keep-alive
+ * Client, and the average number of allocations per request is printed.
+ *
+ * Example: make bench && ./alloc_bench
+ * locations=   1  allocs/request: new connection=10  keep-alive=10
+ * locations= 500  allocs/request: new connection=10  keep-alive=10
+ * (must not grow with the number of locations)
+ *
+ * Run from the WebServ directory (config paths are relative to it)
+ */
+
+static unsigned long g_allocs = 0;
+
+void* operator new(size_t size) throw(std::bad_alloc)
+{
+	++g_allocs;
+	void* p = malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size) throw(std::bad_alloc)
+{
+	return operator new(size);
+}
+
+void operator delete(void* p) throw()
+{
+	free(p);
+}
+
+void operator delete[](void* p) throw()
+{
+	free(p);
+}
+
+#define REQUESTS 2000
+
+/**
+ * Writes a config with `extra` additional locations to path
+ *
+ * Example: extra=2 → "location /bench0 {...}" and "location /bench1 {...}"
+ * next to the "/" and "/42-webserv" locations the request hits
+ */
+static void writeConfig(const std::string& path, int extra)
+{
+	std::ofstream out(path.c_str());
+	out << "server {\n\tlisten 18080;\n\tserver_name localhost;\n\thost 127.0.0.1;\n"
+		<< "\troot docs/;\n\tindex index.html;\n\terror_page 404 error_pages/404.html;\n"
+		<< "\tlocation / {\n\t\tallow_methods GET POST DELETE;\n\t}\n"
+		<< "\tlocation /42-webserv {\n\t\tallow_methods GET;\n\t\tautoindex on;\n\t}\n";
+	for (int i = 0; i < extra; ++i)
+		out << "\tlocation /bench" << i << " {\n\t\tallow_methods GET;\n\t}\n";
+	out << "}\n";
+}
+
+static const std::string g_raw = "GET /42-webserv/page1.html HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+/**
+ * Answers one request the way ServerManager::processRequest does
+ *
+ * Example: request and response belong to the same Client;
+ * after the call both are cleared, ready for the next keep-alive request
+ */
+static void serveOne(HttpRequest& request, Response& response, ServerConfig& server)
+{
+	std::string buffer(g_raw);
+
+	request.feed(&buffer[0], buffer.size());
+	response.setRequest(request);
+	response.setServer(server);
+	response.buildResponse();
+	if (response.getCode() != 200)
+	{
+		std::cerr << "unexpected status " << response.getCode() << std::endl;
+		exit(1);
+	}
+	response.clear();
+	request.clear();
+}
+
+/**
+ * Average allocations per request
+ *
+ * Example: per_connection=1 → every request comes on a new connection
+ * (Connection: close); per_connection=REQUESTS → one keep-alive client.
+ * Clients come from a ClientPool, as in ServerManager::acceptNewConnection
+ */
+static unsigned long allocsPerRequest(ServerConfig& server, int per_connection)
+{
+	ClientPool pool;
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+
+	// Warm-up: fills the static file cache and the pool
+	Client* client = pool.acquire(-1, addr);
+	serveOne(client->request, client->response, server);
+	pool.release(client);
+
+	unsigned long before = g_allocs;
+	for (int done = 0; done < REQUESTS; )
+	{
+		client = pool.acquire(-1, addr);
+		for (int i = 0; i < per_connection && done < REQUESTS; ++i, ++done)
+			serveOne(client->request, client->response, server);
+		pool.release(client);
+	}
+	return (g_allocs - before) / REQUESTS;
+}
+
+int main()
+{
+	const int sizes[] = {1, 10, 100, 500};
+	const std::string path = "/tmp/webserv_alloc_bench.conf";
+
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+	{
+		writeConfig(path, sizes[i]);
+		ConfigParser parser;
+		std::streambuf* saved = std::cout.rdbuf(NULL);	// parser is chatty
+		parser.createCluster(path);
+		std::cout.rdbuf(saved);
+		std::vector<ServerConfig> servers = parser.getServers();
+
+		printf("locations=%4d  allocs/request: new connection=%lu  keep-alive=%lu\n", sizes[i],
+			allocsPerRequest(servers[0], 1), allocsPerRequest(servers[0], REQUESTS));
+	}
+	remove(path.c_str());
+	return 0;
+}
@@ -0,0 +1,164 @@
+#include "Webserv.hpp"
+#include "ConfigParser.hpp"
+#include "CgiHandler.hpp"
+#include "HttpRequest.hpp"
+#include <sys/time.h>
+#include <cstdio>
+
+/**
+ * CGI environment benchmark
+ *
+ * Builds the envp/argv of GET /cgi-bin/time.py (browser request, 9 headers)
+ * ROUNDS times on one keep-alive CgiHandler and prints the time per request:
+ * - initEnv    : /cgi-bin location (fixed part copied from CgiEnvTemplate)
+ * - initEnvCgi : cgi_ext location (same, plus one HTTP_* per header)
+ * - std::map   : the former way, every variable through a std::map, then
+ *                joined into the arena, for comparison
+ *
+ * Example: make bench && ./cgi_env_bench
+ * initEnv    : 1.60 us/request (19 variables)
+ * initEnvCgi : 3.00 us/request (23 variables)
+ * std::map   : 8.60 us/request (19 variables)
+ *
+ * Run from the WebServ directory (config/default.conf is relative to it)
+ */
+
+#define ROUNDS 200000
+
+static const char g_raw[] =
+	"GET /cgi-bin/time.py?city=Lausanne%20VD HTTP/1.1\r\n"
+	"Host: localhost:8002\r\n"
+	"User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:128.0) Gecko/20100101 Firefox/128.0\r\n"
+	"Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+	"Accept-Language: fr-CH,fr;q=0.8,en-US;q=0.5,en;q=0.3\r\n"
+	"Accept-Encoding: gzip, deflate, br\r\n"
+	"Connection: keep-alive\r\n"
+	"Cookie: session=4f2a9c\r\n"
+	"Upgrade-Insecure-Requests: 1\r\n"
+	"Cache-Control: max-age=0\r\n"
+	"\r\n";
+
+static double nowUs()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (tv.tv_sec * 1000000.0 + tv.tv_usec);
+}
+
+static size_t countEnv(char* const* envp)
+{
+	size_t n = 0;
+	while (envp && envp[n])
+		++n;
+	return n;
+}
+
+/**
+ * The environment as it was built before CgiEnvTemplate: a std::map
+ * filled for every request, then copied into the arena
+ *
+ * Example: 19 map insertions, 19 joins, then argv
+ */
+static char** mapEnv(HttpRequest& req, const Location& location, Arena& arena)
+{
+	std::map<std::string, std::string> env;
+	std::string host = req.getHeader("host");
+	size_t poz = host.find(':');
+
+	env["AUTH_TYPE"] = "Basic";
+	env["CONTENT_LENGTH"] = req.getHeader("content-length");
+	env["CONTENT_TYPE"] = req.getHeader("content-type");
+	env["GATEWAY_INTERFACE"] = "CGI/1.1";
+	env["SCRIPT_NAME"] = "cgi-bin/time.py";
+	env["SCRIPT_FILENAME"] = "time.py";
+	env["PATH_INFO"] = "";
+	env["PATH_TRANSLATED"] = location.getRootLocation() + "/";
+	env["QUERY_STRING"] = req.getQuery();
+	env["REMOTE_ADDR"] = host;
+	env["SERVER_NAME"] = host.substr(0, poz);
+	env["SERVER_PORT"] = host.substr(poz + 1);
+	env["REQUEST_METHOD"] = req.getMethodStr();
+	env["HTTP_COOKIE"] = req.getHeader("cookie");
+	env["DOCUMENT_ROOT"] = location.getRootLocation();
+	env["REQUEST_URI"] = req.getPath() + req.getQuery();
+	env["SERVER_PROTOCOL"] = "HTTP/1.1";
+	env["REDIRECT_STATUS"] = "200";
+	env["SERVER_SOFTWARE"] = "LETSGO";
+
+	char** envp = static_cast<char**>(arena.alloc((env.size() + 1) * sizeof(char*)));
+	size_t i = 0;
+	for (std::map<std::string, std::string>::const_iterator it = env.begin(); it != env.end(); ++it)
+		envp[i++] = arena.join(it->first, '=', it->second);
+	envp[i] = NULL;
+
+	char** argv = static_cast<char**>(arena.alloc(3 * sizeof(char*)));
+	argv[0] = arena.copy(location.getExtensionPath().find(".py")->second);
+	argv[1] = arena.copy("cgi-bin/time.py");
+	argv[2] = NULL;
+	return envp;
+}
+
+/**
+ * Microseconds per environment build, `mode` picking the builder
+ *
+ * Example: mode=0 → CgiHandler::clear(), setCgiPath(), initEnv(), as
+ * Response::handleCgi does for every CGI request
+ */
+static double usPerRequest(HttpRequest& req, const Location& location, int mode, size_t& variables)
+{
+	CgiHandler cgi;
+	Arena arena;
+
+	double start = nowUs();
+	for (int round = 0; round < ROUNDS; ++round)
+	{
+		if (mode == 2)
+		{
+			arena.reset();
+			variables = countEnv(mapEnv(req, location, arena));
+			continue;
+		}
+		cgi.clear();
+		cgi.setCgiPath("cgi-bin/time.py");
+		if (mode == 0)
+			cgi.initEnv(req, location);
+		else
+			cgi.initEnvCgi(req, location);
+		variables = countEnv(cgi.getEnv());
+	}
+	return ((nowUs() - start) / ROUNDS);
+}
+
+int main()
+{
+	ConfigParser parser;
+	std::streambuf* saved = std::cout.rdbuf(NULL);	// parser is chatty
+	parser.createCluster("config/default.conf");
+	std::cout.rdbuf(saved);
+	std::vector<ServerConfig> servers = parser.getServers();
+	const Location* location = servers[0].matchLocation("/cgi-bin/time.py");
+
+	if (!location || location->getPath() != "/cgi-bin")
+	{
+		std::cerr << "no /cgi-bin location in config/default.conf" << std::endl;
+		return 1;
+	}
+
+	std::string buffer(g_raw);
+	HttpRequest request;
+	request.feed(&buffer[0], buffer.size());
+	if (!request.parsingCompleted() || request.errorCode())
+	{
+		std::cerr << "parse failed" << std::endl;
+		return 1;
+	}
+
+	const char* names[] = {"initEnv   ", "initEnvCgi", "std::map  "};
+	for (int mode = 0; mode < 3; ++mode)
+	{
+		size_t variables = 0;
+		double us = usPerRequest(request, *location, mode, variables);
+		printf("%s : %.2f us/request (%lu variables)\n", names[mode], us, (unsigned long)variables);
+	}
+	return 0;
+}
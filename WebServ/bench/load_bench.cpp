@@ -0,0 +1,662 @@
+#include "Webserv.hpp"
+#include <sys/epoll.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <netinet/tcp.h>
+#include <cstdio>
+
+/**
+ * HTTP load generator and regression gate
+ *
+ * Starts ./webserv with config/default.conf (or the config given), then
+ * drives it from one epoll loop with `-c` connections for `-d` seconds per
+ * scenario. Each scenario reports requests/sec, p50/p99/p99.9 latency, errors
+ * (non-2xx/3xx, resets, malformed responses), and the server's RSS and peak
+ * RSS (VmHWM) after the run:
+ *
+ * static        GET /42-webserv/page1.html, keep-alive
+ * static-close  the same with Connection: close (one connection per request)
+ * large         GET of an 8 MB file created for the run
+ * autoindex     GET /42-webserv/ (directory listing)
+ * cgi           GET /cgi-bin/time.py
+ * upload        POST of 256 KB to /42-webserv/messages/
+ *
+ * Example: make && make bench && ./load_bench
+ * scenario      conns  requests     req/s   p50 us   p99 us p99.9 us errors  rss KB  hwm KB
+ * static           32    245107   49021.4      610     1350     2480      0    5120    5380
+ * ...
+ *
+ * Regression gate: `-o base.txt` saves req/s and p99 per scenario; a later
+ * `-b base.txt` compares against it and exits with status 1 if a scenario
+ * had errors, lost more than `-t` percent of req/s (default 15) or its p99
+ * grew by more than that:
+ * ./load_bench -o base.txt            (before the upgrade)
+ * ./load_bench -b base.txt && deploy  (after)
+ *
+ * Options: -c connections (32), -d seconds (5), -s scenario (all), -p port
+ * of the config (8080), -t tolerance percent (15)
+ *
+ * Run from the WebServ directory, with no other server on the port
+ */
+
+#define LOAD_CONNECTIONS 32
+#define LOAD_SECONDS 5
+#define LOAD_PORT 8080
+#define LOAD_TOLERANCE 15
+#define LOAD_READ_SIZE 65536
+#define LOAD_HEAD_MAX 65536
+#define LOAD_LARGE_FILE "docs/42-webserv/load_bench.bin"
+#define LOAD_LARGE_SIZE (8 * 1024 * 1024)
+#define LOAD_UPLOAD_URI "/42-webserv/messages/load_bench_upload.bin"
+#define LOAD_UPLOAD_FILE "docs/42-webserv/messages/load_bench_upload.bin"
+#define LOAD_UPLOAD_SIZE (256 * 1024)
+
+struct Scenario
+{
+	const char* name;
+	const char* method;
+	const char* uri;
+	size_t body;		// POST body size, 0 for GET
+	bool keep_alive;
+};
+
+static const Scenario g_scenarios[] = {
+	{"static", "GET", "/42-webserv/page1.html", 0, true},
+	{"static-close", "GET", "/42-webserv/page1.html", 0, false},
+	{"large", "GET", "/42-webserv/load_bench.bin", 0, true},
+	{"autoindex", "GET", "/42-webserv/", 0, true},
+	{"cgi", "GET", "/cgi-bin/time.py", 0, true},
+	{"upload", "POST", LOAD_UPLOAD_URI, LOAD_UPLOAD_SIZE, true}
+};
+
+enum BodyMode { BODY_LENGTH, BODY_CHUNKED, BODY_EOF };
+enum ChunkState { CHUNK_SIZE, CHUNK_DATA, CHUNK_DATA_END, CHUNK_TRAILER };
+
+/**
+ * One client connection and the response it is reading
+ *
+ * Bodies are counted, never stored: an 8 MB response costs no memory
+ */
+struct Conn
+{
+	int fd;
+	bool connected;
+	size_t sent;
+	double start;
+	std::string head;		// status line and headers, until the blank line
+	bool in_body;
+	BodyMode mode;
+	ChunkState chunk;
+	size_t left;			// body bytes (BODY_LENGTH) or chunk bytes still expected
+	std::string line;		// chunk-size or trailer line being read
+	int status;
+	bool server_close;
+};
+
+struct Result
+{
+	unsigned long requests;
+	unsigned long errors;
+	double rps;
+	unsigned p50;
+	unsigned p99;
+	unsigned p999;
+	long rss;
+	long hwm;
+};
+
+static double nowUs()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (tv.tv_sec * 1000000.0 + tv.tv_usec);
+}
+
+/**
+ * "VmRSS:" or "VmHWM:" of pid from /proc, in KB, -1 if unknown
+ */
+static long procStatus(pid_t pid, const char* key)
+{
+	char path[64];
+	sprintf(path, "/proc/%d/status", (int)pid);
+	std::ifstream in(path);
+	std::string line;
+
+	while (std::getline(in, line))
+	{
+		if (line.compare(0, strlen(key), key) == 0)
+			return strtol(line.c_str() + strlen(key), NULL, 10);
+	}
+	return -1;
+}
+
+static void resetResponse(Conn& c)
+{
+	c.sent = 0;
+	c.head.clear();
+	c.in_body = false;
+	c.mode = BODY_LENGTH;
+	c.chunk = CHUNK_SIZE;
+	c.left = 0;
+	c.line.clear();
+	c.status = 0;
+	c.server_close = false;
+}
+
+/**
+ * Status, framing and Connection: close from the response head
+ *
+ * Example: "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+ * → status 200, BODY_CHUNKED
+ */
+static bool parseHead(Conn& c)
+{
+	std::string lower(c.head);
+	for (size_t i = 0; i < lower.size(); ++i)
+		lower[i] = std::tolower(lower[i]);
+	if (lower.compare(0, 7, "http/1.") != 0 || lower.size() < 12)
+		return false;
+	c.status = atoi(lower.c_str() + 9);
+
+	size_t pos = lower.find("\r\nconnection:");
+	c.server_close = pos != std::string::npos && lower.find("close", pos) < lower.find("\r\n", pos + 2);
+	if (c.status == 204 || c.status == 304 || (c.status >= 100 && c.status < 200))
+	{
+		c.mode = BODY_LENGTH;
+		c.left = 0;
+		return true;
+	}
+	pos = lower.find("\r\ntransfer-encoding:");
+	if (pos != std::string::npos && lower.find("chunked", pos) < lower.find("\r\n", pos + 2))
+	{
+		c.mode = BODY_CHUNKED;
+		return true;
+	}
+	pos = lower.find("\r\ncontent-length:");
+	if (pos != std::string::npos)
+	{
+		c.mode = BODY_LENGTH;
+		c.left = strtoul(lower.c_str() + pos + 17, NULL, 10);
+		return true;
+	}
+	c.mode = BODY_EOF;
+	c.server_close = true;
+	return true;
+}
+
+/**
+ * Reads one line ending in '\n' into c.line, byte by byte
+ * Returns the bytes used; `done` is set once the line is complete
+ */
+static size_t readLine(Conn& c, const char* data, size_t len, bool& done)
+{
+	size_t i = 0;
+	done = false;
+	while (i < len && !done)
+	{
+		if (data[i] == '\n')
+			done = true;
+		else if (data[i] != '\r')
+			c.line += data[i];
+		++i;
+	}
+	return i;
+}
+
+/**
+ * Feeds received bytes to the response parser
+ * Returns 1 when the response is complete, 0 if more is needed, -1 if malformed
+ *
+ * Example: "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nhel" → 0, then "lo" → 1
+ */
+static int feedResponse(Conn& c, const char* data, size_t len)
+{
+	size_t i = 0;
+	bool done;
+
+	while (i < len)
+	{
+		if (!c.in_body)
+		{
+			size_t old = c.head.size();
+			c.head.append(data + i, len - i);
+			size_t end = c.head.find("\r\n\r\n", old >= 3 ? old - 3 : 0);
+			if (end == std::string::npos)
+				return c.head.size() > LOAD_HEAD_MAX ? -1 : 0;
+			i += end + 4 - old;
+			c.head.resize(end + 4);
+			if (!parseHead(c))
+				return -1;
+			c.in_body = true;
+			if (c.mode == BODY_LENGTH && c.left == 0)
+				return 1;
+			continue;
+		}
+		if (c.mode == BODY_EOF)
+			return 0;
+		if (c.mode == BODY_LENGTH || c.chunk == CHUNK_DATA || c.chunk == CHUNK_DATA_END)
+		{
+			size_t n = std::min(c.left, len - i);
+			c.left -= n;
+			i += n;
+			if (c.left > 0)
+				continue;
+			if (c.mode == BODY_LENGTH)
+				return 1;
+			if (c.chunk == CHUNK_DATA)
+			{
+				c.chunk = CHUNK_DATA_END;
+				c.left = 2;
+			}
+			else
+				c.chunk = CHUNK_SIZE;
+			continue;
+		}
+		i += readLine(c, data + i, len - i, done);
+		if (!done)
+			continue;
+		if (c.chunk == CHUNK_TRAILER)
+		{
+			if (c.line.empty())
+				return 1;
+		}
+		else
+		{
+			char* end;
+			c.left = strtoul(c.line.c_str(), &end, 16);
+			if (end == c.line.c_str())
+				return -1;
+			c.chunk = c.left ? CHUNK_DATA : CHUNK_TRAILER;
+		}
+		c.line.clear();
+	}
+	return 0;
+}
+
+/**
+ * Non-blocking connect to 127.0.0.1:port, registered in epfd
+ */
+static bool openConn(Conn& c, int epfd, int port, unsigned index)
+{
+	struct sockaddr_in addr;
+	struct epoll_event ev;
+	int one = 1;
+
+	resetResponse(c);
+	c.connected = false;
+	c.start = nowUs();
+	c.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (c.fd < 0)
+		return false;
+	setsockopt(c.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (connect(c.fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS)
+	{
+		close(c.fd);
+		c.fd = -1;
+		return false;
+	}
+	ev.events = EPOLLIN | EPOLLOUT;
+	ev.data.u32 = index;
+	epoll_ctl(epfd, EPOLL_CTL_ADD, c.fd, &ev);
+	return true;
+}
+
+static void closeConn(Conn& c)
+{
+	if (c.fd >= 0)
+		close(c.fd);		// also removes it from the epoll set
+	c.fd = -1;
+}
+
+/**
+ * Sends what is left of the request; watches EPOLLOUT only while some is left
+ */
+static bool sendRequest(Conn& c, int epfd, unsigned index, const std::string& request)
+{
+	while (c.sent < request.size())
+	{
+		ssize_t n = send(c.fd, request.data() + c.sent, request.size() - c.sent, MSG_NOSIGNAL);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			return true;
+		if (n <= 0)
+			return false;
+		c.sent += n;
+	}
+	struct epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.u32 = index;
+	epoll_ctl(epfd, EPOLL_CTL_MOD, c.fd, &ev);
+	return true;
+}
+
+static std::string buildRequest(const Scenario& s, int port)
+{
+	std::ostringstream out;
+
+	out << s.method << " " << s.uri << " HTTP/1.1\r\n"
+		<< "Host: localhost:" << port << "\r\n"
+		<< "User-Agent: load_bench\r\n";
+	if (!s.keep_alive)
+		out << "Connection: close\r\n";
+	if (s.body)
+		out << "Content-Type: application/octet-stream\r\n"
+			<< "Content-Length: " << s.body << "\r\n";
+	out << "\r\n";
+	std::string request = out.str();
+	request.append(s.body, 'x');
+	return request;
+}
+
+static unsigned percentile(const std::vector<unsigned>& sorted, double q)
+{
+	if (sorted.empty())
+		return 0;
+	size_t i = (size_t)(q * sorted.size());
+	return sorted[std::min(i, sorted.size() - 1)];
+}
+
+/**
+ * Runs one scenario for `seconds`, `conns` connections always busy
+ *
+ * Example: keep-alive → a connection sends its next request as soon as the
+ * response is complete; close → it reconnects (latency includes connect)
+ * Requests still in flight when the time is up are not counted
+ */
+static Result runScenario(const Scenario& s, int conns, double seconds, int port, pid_t server)
+{
+	std::string request = buildRequest(s, port);
+	std::vector<Conn> pool(conns);
+	std::vector<unsigned> latencies;
+	std::vector<char> buffer(LOAD_READ_SIZE);
+	struct epoll_event events[256];
+	Result r;
+	int epfd = epoll_create1(EPOLL_CLOEXEC);
+
+	memset(&r, 0, sizeof(r));
+	latencies.reserve(1 << 20);
+	for (int i = 0; i < conns; ++i)
+		if (!openConn(pool[i], epfd, port, i))
+			r.errors++;
+
+	double begin = nowUs();
+	double end = begin + seconds * 1000000.0;
+	while (nowUs() < end)
+	{
+		int ready = epoll_wait(epfd, events, 256, 100);
+		for (int k = 0; k < ready; ++k)
+		{
+			unsigned index = events[k].data.u32;
+			Conn& c = pool[index];
+			int state = 0;		// 1 complete, -1 failed
+
+			if (c.fd < 0)
+				continue;
+			if (!c.connected)
+			{
+				int err = 0;
+				socklen_t len = sizeof(err);
+				getsockopt(c.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+				if (err)
+					state = -1;
+				c.connected = (err == 0);
+			}
+			if (state == 0 && c.sent < request.size() && (events[k].events & EPOLLOUT))
+				state = sendRequest(c, epfd, index, request) ? 0 : -1;
+			if (state == 0 && (events[k].events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+			{
+				while (state == 0)
+				{
+					ssize_t n = recv(c.fd, &buffer[0], buffer.size(), 0);
+					if (n < 0 && errno == EINTR)
+						continue;
+					if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+						break;
+					if (n <= 0)
+						state = (n == 0 && c.in_body && c.mode == BODY_EOF) ? 1 : -1;
+					else
+						state = feedResponse(c, &buffer[0], n);
+				}
+			}
+			if (state == 0)
+				continue;
+
+			if (state == 1 && c.status >= 200 && c.status < 400)
+			{
+				r.requests++;
+				latencies.push_back((unsigned)(nowUs() - c.start));
+			}
+			else
+				r.errors++;
+			if (state == 1 && s.keep_alive && !c.server_close)
+			{
+				resetResponse(c);
+				c.start = nowUs();
+				if (sendRequest(c, epfd, index, request))
+				{
+					if (c.sent < request.size())
+					{
+						struct epoll_event ev;
+						ev.events = EPOLLIN | EPOLLOUT;
+						ev.data.u32 = index;
+						epoll_ctl(epfd, EPOLL_CTL_MOD, c.fd, &ev);
+					}
+					continue;
+				}
+				r.errors++;
+			}
+			closeConn(c);
+			if (!openConn(c, epfd, port, index))
+				r.errors++;
+		}
+	}
+	double elapsed = (nowUs() - begin) / 1000000.0;
+
+	for (int i = 0; i < conns; ++i)
+		closeConn(pool[i]);
+	close(epfd);
+	std::sort(latencies.begin(), latencies.end());
+	r.rps = r.requests / elapsed;
+	r.p50 = percentile(latencies, 0.50);
+	r.p99 = percentile(latencies, 0.99);
+	r.p999 = percentile(latencies, 0.999);
+	r.rss = procStatus(server, "VmRSS:");
+	r.hwm = procStatus(server, "VmHWM:");
+	return r;
+}
+
+static bool portAnswers(int port)
+{
+	struct sockaddr_in addr;
+	int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	bool ok = connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0;
+	close(fd);
+	return ok;
+}
+
+/**
+ * Forks ./webserv config (output to /dev/null) and waits for port to answer
+ * Returns its pid, -1 if it did not come up within 5 seconds
+ */
+static pid_t startServer(const char* config, int port)
+{
+	pid_t pid = fork();
+
+	if (pid == 0)
+	{
+		int null = open("/dev/null", O_WRONLY);
+		dup2(null, STDOUT_FILENO);
+		dup2(null, STDERR_FILENO);
+		execl("./webserv", "./webserv", config, (char*)NULL);
+		_exit(127);
+	}
+	for (int i = 0; pid > 0 && i < 50; ++i)
+	{
+		usleep(100000);
+		if (portAnswers(port))
+			return pid;
+		if (waitpid(pid, NULL, WNOHANG) == pid)
+			return -1;
+	}
+	if (pid > 0)
+	{
+		kill(pid, SIGTERM);
+		waitpid(pid, NULL, 0);
+	}
+	return -1;
+}
+
+static bool writeFile(const char* path, size_t size)
+{
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	std::string block(65536, 'b');
+
+	for (size_t done = 0; out && done < size; done += block.size())
+		out.write(block.data(), std::min(block.size(), size - done));
+	return out.good();
+}
+
+/**
+ * Baseline file: one "name req/s p99" line per scenario
+ */
+static std::map<std::string, std::pair<double, unsigned> > readBaseline(const char* path)
+{
+	std::map<std::string, std::pair<double, unsigned> > base;
+	std::ifstream in(path);
+	std::string name;
+	double rps;
+	unsigned p99;
+
+	while (in >> name >> rps >> p99)
+		base[name] = std::make_pair(rps, p99);
+	return base;
+}
+
+static void usage()
+{
+	fprintf(stderr, "usage: ./load_bench [-c conns] [-d seconds] [-s scenario] [-p port]"
+		" [-o save.txt] [-b baseline.txt] [-t percent] [config]\n");
+	exit(2);
+}
+
+int main(int argc, char** argv)
+{
+	int conns = LOAD_CONNECTIONS;
+	double seconds = LOAD_SECONDS;
+	int port = LOAD_PORT;
+	int tolerance = LOAD_TOLERANCE;
+	const char* only = NULL;
+	const char* save = NULL;
+	const char* baseline = NULL;
+	const char* config = "config/default.conf";
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg(argv[i]);
+		if (arg[0] != '-')
+			config = argv[i];
+		else if (i + 1 >= argc || arg.size() != 2)
+			usage();
+		else if (arg == "-c")
+			conns = atoi(argv[++i]);
+		else if (arg == "-d")
+			seconds = atof(argv[++i]);
+		else if (arg == "-s")
+			only = argv[++i];
+		else if (arg == "-p")
+			port = atoi(argv[++i]);
+		else if (arg == "-o")
+			save = argv[++i];
+		else if (arg == "-b")
+			baseline = argv[++i];
+		else if (arg == "-t")
+			tolerance = atoi(argv[++i]);
+		else
+			usage();
+	}
+	if (conns <= 0 || seconds <= 0 || port <= 0)
+		usage();
+	if (access("./webserv", X_OK) != 0)
+	{
+		fprintf(stderr, "./webserv not found: run make first, from the WebServ directory\n");
+		return 2;
+	}
+	if (portAnswers(port))
+	{
+		fprintf(stderr, "port %d already answers: stop the running server first\n", port);
+		return 2;
+	}
+	if (!writeFile(LOAD_LARGE_FILE, LOAD_LARGE_SIZE))
+	{
+		fprintf(stderr, "cannot create %s\n", LOAD_LARGE_FILE);
+		return 2;
+	}
+	pid_t server = startServer(config, port);
+	if (server < 0)
+	{
+		fprintf(stderr, "./webserv %s did not answer on port %d\n", config, port);
+		remove(LOAD_LARGE_FILE);
+		return 2;
+	}
+
+	std::map<std::string, std::pair<double, unsigned> > base;
+	std::ofstream out;
+	int regressions = 0;
+
+	if (baseline)
+		base = readBaseline(baseline);
+	if (save)
+		out.open(save);
+	printf("%-13s %5s %9s %9s %8s %8s %8s %6s %7s %7s\n", "scenario", "conns", "requests",
+		"req/s", "p50 us", "p99 us", "p99.9 us", "errors", "rss KB", "hwm KB");
+	for (size_t i = 0; i < sizeof(g_scenarios) / sizeof(g_scenarios[0]); ++i)
+	{
+		const Scenario& s = g_scenarios[i];
+		if (only && s.name != std::string(only))
+			continue;
+		Result r = runScenario(s, conns, seconds, port, server);
+		printf("%-13s %5d %9lu %9.1f %8u %8u %8u %6lu %7ld %7ld\n", s.name, conns, r.requests,
+			r.rps, r.p50, r.p99, r.p999, r.errors, r.rss, r.hwm);
+		fflush(stdout);
+		if (save)
+			out << s.name << " " << r.rps << " " << r.p99 << "\n";
+		if (baseline && r.errors)
+		{
+			printf("  regression: %lu errors\n", r.errors);
+			regressions++;
+		}
+		if (base.count(s.name))
+		{
+			double rps = base[s.name].first;
+			unsigned p99 = base[s.name].second;
+			if (r.rps < rps * (100 - tolerance) / 100)
+			{
+				printf("  regression: %.1f req/s, baseline %.1f\n", r.rps, rps);
+				regressions++;
+			}
+			if (r.p99 > p99 * (100 + tolerance) / 100.0)
+			{
+				printf("  regression: p99 %u us, baseline %u us\n", r.p99, p99);
+				regressions++;
+			}
+		}
+	}
+
+	kill(server, SIGTERM);
+	waitpid(server, NULL, 0);
+	remove(LOAD_LARGE_FILE);
+	remove(LOAD_UPLOAD_FILE);
+	if (baseline)
+		printf("%s\n", regressions ? "REGRESSION" : "baseline OK");
+	return regressions ? 1 : 0;
+}
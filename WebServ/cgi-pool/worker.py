@@ -0,0 +1,167 @@
+#!/usr/bin/python3
+"""Interpréteur persistant du pool CGI de webserv (directive cgi_pool).
+
+Lit des requêtes FastCGI sur stdin (BEGIN_REQUEST, PARAMS, STDIN), exécute le
+script demandé dans ce processus et renvoie sa sortie en enregistrements
+STDOUT, puis END_REQUEST avec le code de sortie du script. Le démarrage de
+Python et les imports des scripts ne sont payés qu'une fois par interpréteur.
+
+Pour le script, rien ne change : os.environ, sys.stdin, sys.stdout et
+sys.argv sont ceux qu'il aurait en CGI classique ; exit() termine la requête,
+pas l'interpréteur. EOF sur stdin : le serveur nous retire, on s'arrête.
+"""
+
+import io
+import os
+import struct
+import sys
+import traceback
+
+FCGI_VERSION_1 = 1
+FCGI_BEGIN_REQUEST = 1
+FCGI_END_REQUEST = 3
+FCGI_PARAMS = 4
+FCGI_STDIN = 5
+FCGI_STDOUT = 6
+FCGI_MAX_CONTENT = 65535
+HEADER = struct.Struct("!BBHHBB")
+
+
+def read_exact(stream, size):
+    data = b""
+    while len(data) < size:
+        chunk = stream.read(size - len(data))
+        if not chunk:
+            raise EOFError
+        data += chunk
+    return data
+
+
+def read_record(stream):
+    _, kind, request_id, length, padding, _ = HEADER.unpack(read_exact(stream, HEADER.size))
+    content = read_exact(stream, length)
+    read_exact(stream, padding)
+    return kind, request_id, content
+
+
+def write_record(stream, kind, request_id, content):
+    for start in range(0, max(len(content), 1), FCGI_MAX_CONTENT):
+        chunk = content[start:start + FCGI_MAX_CONTENT]
+        stream.write(HEADER.pack(FCGI_VERSION_1, kind, request_id, len(chunk), 0, 0) + chunk)
+
+
+def parse_params(data):
+    params = {}
+    pos = 0
+
+    def length():
+        nonlocal pos
+        if data[pos] < 128:
+            pos += 1
+            return data[pos - 1]
+        pos += 4
+        return struct.unpack("!I", data[pos - 4:pos])[0] & 0x7FFFFFFF
+
+    while pos < len(data):
+        name_len = length()
+        value_len = length()
+        name = data[pos:pos + name_len].decode("latin-1")
+        pos += name_len
+        params[name] = data[pos:pos + value_len].decode("latin-1")
+        pos += value_len
+    return params
+
+
+class RecordWriter(io.RawIOBase):
+    """sys.stdout.buffer du script : chaque écriture devient un enregistrement STDOUT."""
+
+    def __init__(self, stream, request_id):
+        super().__init__()
+        self.stream = stream
+        self.request_id = request_id
+
+    def writable(self):
+        return True
+
+    def write(self, data):
+        if data:
+            write_record(self.stream, FCGI_STDOUT, self.request_id, bytes(data))
+        return len(data)
+
+
+def read_request(stream):
+    """(id, paramètres, corps) de la requête suivante."""
+    kind, request_id, _ = read_record(stream)
+    while kind != FCGI_BEGIN_REQUEST:
+        kind, request_id, _ = read_record(stream)
+    params = b""
+    body = b""
+    while True:
+        kind, _, content = read_record(stream)
+        if kind == FCGI_PARAMS:
+            params += content
+        elif kind == FCGI_STDIN:
+            if not content:
+                break
+            body += content
+    return request_id, parse_params(params), body
+
+
+_compiled = {}
+
+
+def load(script):
+    """Code compilé du script, recompilé s'il a changé sur le disque."""
+    mtime = os.stat(script).st_mtime
+    cached = _compiled.get(script)
+    if cached is None or cached[0] != mtime:
+        with open(script, "rb") as source:
+            cached = (mtime, compile(source.read(), script, "exec"))
+        _compiled[script] = cached
+    return cached[1]
+
+
+def run(script, params, body, out, request_id):
+    """Exécute le script comme un CGI ; renvoie son code de sortie."""
+    base_env = dict(os.environ)
+    os.environ.update(params)
+    sys.argv = [script]
+    sys.stdin = io.TextIOWrapper(io.BytesIO(body))
+    sys.stdout = io.TextIOWrapper(io.BufferedWriter(RecordWriter(out, request_id), FCGI_MAX_CONTENT))
+    status = 0
+    try:
+        exec(load(script), {"__name__": "__main__", "__file__": script, "__builtins__": __builtins__})
+    except SystemExit as exit_request:
+        code = exit_request.code
+        status = code if isinstance(code, int) else (0 if code is None else 1)
+    except BaseException:
+        traceback.print_exc()
+        status = 1
+    finally:
+        try:
+            sys.stdout.flush()
+        except Exception:
+            status = status or 1
+        sys.stdout = sys.__stdout__
+        sys.stdin = sys.__stdin__
+        os.environ.clear()
+        os.environ.update(base_env)
+    return status
+
+
+def main():
+    requests = sys.stdin.buffer
+    out = sys.stdout.buffer
+    while True:
+        try:
+            request_id, params, body = read_request(requests)
+        except EOFError:
+            return
+        script = params.pop("WEBSERV_SCRIPT", "")
+        status = run(script, params, body, out, request_id)
+        write_record(out, FCGI_END_REQUEST, request_id, struct.pack("!IB3x", status & 0xFFFFFFFF, 0))
+        out.flush()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,49 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#define ARENA_BLOCK_SIZE 4096	// taille d'un bloc ; une demande plus grande a son propre bloc
+
+/*
+  Classe Arena : allocation par incrément de pointeur, libération en une seule fois
+  - alloc() découpe le bloc courant ; un nouveau bloc n'est pris que s'il est plein
+  - reset() rend tout d'un coup et garde le premier bloc pour la requête suivante :
+    une connexion qui enchaîne les requêtes ne repasse plus par malloc()
+  - aucun destructeur n'est appelé : uniquement pour des données brutes (char, pointeurs)
+  Une copie d'Arena est une arène vide : la mémoire n'est jamais partagée
+*/
+class Arena
+{
+	public:
+		Arena(size_t block_size = ARENA_BLOCK_SIZE);
+		Arena(const Arena &other);
+		Arena &operator=(const Arena &other);
+		~Arena();
+
+		void	*alloc(size_t size);
+		char	*copy(const std::string &str);
+		char	*join(const std::string &key, char sep, const std::string &value);
+		char	*join(const char *key, char sep, const std::string &value);
+		void	reset();
+		size_t	used() const;
+
+	private:
+		struct Block
+		{
+			char	*data;
+			size_t	size;
+		};
+
+		std::vector<Block>	_blocks;
+		size_t				_block_size;
+		size_t				_current;	// bloc en cours de découpe
+		size_t				_offset;	// octets déjà donnés dans ce bloc
+		size_t				_used;
+
+		void	release(size_t from);
+};
+
+#endif
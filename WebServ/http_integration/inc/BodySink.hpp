@@ -0,0 +1,67 @@
+#ifndef BODY_SINK_HPP
+#define BODY_SINK_HPP
+
+#include <string>
+#include <sys/types.h>
+
+/* Corps gardé en mémoire par défaut (directive client_body_buffer_size) :
+	au-delà, il part dans un fichier temporaire. */
+#define CLIENT_BODY_BUFFER_SIZE 65536
+
+/* Répertoire des fichiers temporaires par défaut (directive client_body_temp_path).
+	Sur le même système de fichiers que les uploads, saveAs() n'est qu'un rename(). */
+#define CLIENT_BODY_TEMP_PATH "/tmp"
+
+/* Tranche lue dans le fichier temporaire pour un write() (entrée du CGI, copie) */
+#define BODY_SINK_CHUNK 65536
+
+/*
+  Classe BodySink : corps d'une requête, reçu au fil du parsing
+  - jusqu'au seuil, les octets restent en mémoire
+  - au-delà, tout part dans un fichier temporaire (mkstemp) : la mémoire d'un
+    upload ne dépend plus de sa taille
+  - il est relu par offset (writeTo) sans jamais être recopié : l'entrée du CGI
+    avance un curseur au lieu de raccourcir une string
+  - saveAs() le dépose à destination : rename() du fichier temporaire, copie par
+    tranches s'il est sur un autre système de fichiers
+  Exemple : POST de 50 Mo, seuil 64 Ko
+  append() x4 de 16 Ko → mémoire ; append suivant → /tmp/webserv-body-Ab12Cd
+  (les 64 Ko y sont écrits), puis chaque append() est un write() ;
+  saveAs("www/upload/big.bin") → rename()
+*/
+class BodySink
+{
+    public:
+        BodySink();
+        ~BodySink();
+
+        void                configure(size_t threshold, const std::string &temp_dir);
+        bool                append(const char *data, size_t len);   // false : fichier temporaire inutilisable
+        size_t              size() const;
+        bool                inMemory() const;
+        const std::string   &memory() const;    // le corps, tant qu'il est en mémoire
+        ssize_t             writeTo(int fd, size_t offset, size_t len) const;
+        ssize_t             read(size_t offset, char *buffer, size_t len) const;
+        bool                saveAs(const std::string &path);
+        void                clear();
+
+        static void         captureUmask();     // au démarrage, avant les threads
+        static mode_t       fileMode();         // droits d'un fichier créé : 0666 moins l'umask
+
+    private:
+        static mode_t       _umask;
+        std::string         _memory;
+        std::string         _temp_dir;
+        std::string         _temp_path;     // vide : pas de fichier temporaire
+        size_t              _threshold;
+        size_t              _size;
+        int                 _fd;
+
+        bool                _spill();
+        bool                _copyTo(int fd) const;
+
+        BodySink(const BodySink &);
+        BodySink &operator=(const BodySink &);
+};
+
+#endif
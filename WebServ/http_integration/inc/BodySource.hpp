@@ -0,0 +1,92 @@
+#ifndef BODY_SOURCE_HPP
+#define BODY_SOURCE_HPP
+
+#include "Webserv.hpp"
+#include "DirectoryCache.hpp"
+
+/*	Producteur de corps de réponse.
+	Le corps n'est plus construit en entier avant l'envoi : handleClientWrite()
+	tire des tranches de taille fixe (pull) à mesure que le socket accepte des données.
+	- BODY_DATA  : des octets ont été ajoutés à out, il peut en venir d'autres
+	- BODY_AGAIN : rien pour l'instant (le producteur attend, ex. script CGI)
+	- BODY_END   : corps terminé (out peut contenir les derniers octets)
+	- BODY_ERROR : le corps ne peut pas être terminé, la connexion doit être fermée */
+class BodySource
+{
+public:
+	enum Status { BODY_DATA, BODY_AGAIN, BODY_END, BODY_ERROR };
+
+	virtual ~BodySource() {}
+	virtual Status	pull(std::string &out, size_t max) = 0;
+};
+
+/* Partie d'un listing autoindex à produire : format et page demandés
+	(page_size 0 : tout le dossier en une page) */
+struct ListingView
+{
+	bool	json;
+	size_t	page;		// à partir de 1
+	size_t	page_size;
+};
+
+/* Listing autoindex : tiré du listing en cache (DirectoryCache), épinglé jusqu'à la
+	destruction de la source, une entrée formatée à la fois au lieu de construire
+	la page complète en mémoire. HTML, ou JSON :
+	{"path":"/up/","total":2,"page":1,"pages":1,"entries":[
+	{"name":"..","type":"directory","mtime":1760616000},
+	{"name":"a.txt","type":"file","mtime":1760616000,"size":12}]} */
+class DirectorySource : public BodySource
+{
+private:
+	DirectoryCache		&_cache;
+	const CachedListing	*_listing;
+	std::string			_dir_name;	// dossier sur disque (clé du cache)
+	std::string			_uri;		// chemin demandé, seul exposé en JSON
+	ListingView			_view;
+	size_t				_pages;
+	size_t				_first;		// entrées [_first, _end) de la page
+	size_t				_next;
+	size_t				_end;
+	int					_state;		// 0 : en-tête, 1 : entrées, 2 : terminé
+
+	void	appendHead(std::string &out);
+	void	appendTail(std::string &out);
+	void	appendEntry(std::string &out, const DirectoryEntry &entry);
+	DirectorySource(const DirectorySource &);
+	DirectorySource &operator=(const DirectorySource &);
+
+public:
+	DirectorySource(DirectoryCache &cache, const std::string &dir_name, const std::string &uri, const ListingView &view);
+	~DirectorySource();
+
+	bool	isOpen() const;
+	Status	pull(std::string &out, size_t max);
+};
+
+/*	File d'octets remplie par un producteur externe (sortie d'un script CGI)
+	et vidée par pull(). Le producteur consulte buffered() pour ne pas
+	dépasser le plafond mémoire : il arrête de lire tant que le client n'a pas consommé. */
+class StreamSource : public BodySource
+{
+private:
+	std::string	_data;
+	size_t		_offset;	// début des octets pas encore tirés
+	bool		_finished;	// le producteur a tout écrit
+	bool		_pulled;	// au moins une tranche est partie vers le client
+
+	StreamSource(const StreamSource &);
+	StreamSource &operator=(const StreamSource &);
+
+public:
+	StreamSource();
+
+	void	append(const char *data, size_t len);
+	void	finish();
+	size_t	buffered() const;
+	bool	finished() const;
+	bool	pulled() const;
+	size_t	find(const char *pattern) const;
+	Status	pull(std::string &out, size_t max);
+};
+
+#endif
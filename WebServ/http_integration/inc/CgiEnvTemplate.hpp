@@ -0,0 +1,38 @@
+#ifndef CGI_ENV_TEMPLATE_HPP
+#define CGI_ENV_TEMPLATE_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include "Arena.hpp"
+
+/*
+  Classe CgiEnvTemplate : partie fixe de l'environnement CGI d'une location
+  - calculée une fois à la lecture de la configuration : GATEWAY_INTERFACE,
+    SERVER_SOFTWARE, DOCUMENT_ROOT... et le chemin de chaque interpréteur (argv[0])
+  - gardée en un seul bloc "NOM=valeur\0NOM=valeur\0...\0/usr/bin/python3\0"
+  - par requête, instantiate() le copie d'un memcpy dans l'arène du CgiHandler,
+    avec le tableau envp devant : il ne reste qu'à écrire les variables propres
+    à la requête (QUERY_STRING, CONTENT_LENGTH, HTTP_*) dans les places libres
+  Exemple : root "./", cgi_path /usr/bin/python3 /bin/bash, cgi_ext .py .sh
+  instantiate(arena, 13, ".py", interpreter) → envp[0..5] fixes, envp[6..18]
+  libres, envp[19] = NULL à poser par l'appelant ; interpreter = "/usr/bin/python3"
+*/
+class CgiEnvTemplate
+{
+	public:
+		CgiEnvTemplate();
+
+		void	build(const std::string &root, const std::map<std::string, std::string> &interpreters);
+		char	**instantiate(Arena &arena, size_t dynamic, const std::string &extension, char *&interpreter) const;
+		size_t	count() const;		// variables fixes, en tête d'envp
+
+	private:
+		std::string						_block;
+		std::vector<size_t>				_offsets;		// début de chaque variable dans _block
+		std::map<std::string, size_t>	_interpreters;	// extension → début du chemin dans _block
+
+		void	add(const std::string &entry);
+};
+
+#endif
@@ -14,17 +14,22 @@
 #define CGIHANDLER_HPP
 
 #include "Webserv.hpp"
+#include "Arena.hpp"
 
 class HttpRequest;
 #include "Location.hpp"
 class CgiHandler {
 	private:
-		std::map<std::string, std::string>	_env;
 		char**								_ch_env;
 		char**								_argv;
 		int									_exit_status;
 		std::string							_cgi_path;
 		pid_t								_cgi_pid;
+		Arena								_arena;		// _ch_env et _argv, remis à zéro par clear()
+		size_t								_pool_size;	// > 0 : exécuté par un interpréteur du pool (CgiPool)
+		size_t								_pool_max_requests;
+
+		void buildArgv(const char *exec);
 
 	public:
 		int	pipe_in[2];
@@ -36,17 +41,22 @@ class CgiHandler {
 		CgiHandler(CgiHandler const &other);
 		CgiHandler &operator=(CgiHandler const &rhs);
 
-		void initEnv(HttpRequest& req, const std::vector<Location>::iterator it_loc);
-		void initEnvCgi(HttpRequest& req, const std::vector<Location>::iterator it_loc);
+		void initEnv(HttpRequest& req, const Location &location);
+		void initEnvCgi(HttpRequest& req, const Location &location);
 		void execute(short &error_code);
+		void usePool(size_t size, size_t max_requests);
 		void clear();
 
 		void setCgiPid(pid_t cgi_pid);
 		void setCgiPath(const std::string &cgi_path);
 
-		const std::map<std::string, std::string> &getEnv() const;
+		char *const *getEnv() const;
 		const pid_t &getCgiPid() const;
 		const std::string &getCgiPath() const;
+		std::string getInterpreter() const;
+		bool pooled() const;
+		size_t getPoolSize() const;
+		size_t getPoolMaxRequests() const;
 
 		std::string	getPathInfo(std::string& path, std::vector<std::string> extensions);
 		int findStart(const std::string path, const std::string delim);
@@ -0,0 +1,79 @@
+#ifndef DIRECTORY_CACHE_HPP
+#define DIRECTORY_CACHE_HPP
+
+#include "Webserv.hpp"
+#include <list>
+#include <set>
+#include <pthread.h>
+
+#define DIRECTORY_CACHE_MAX 64					// listings gardés au maximum
+#define DIRECTORY_CACHE_MAX_ENTRIES 262144		// somme des entrées de tous les listings
+#define DIRECTORY_CACHE_VALID 60				// secondes avant de relire un listing même inchangé
+
+/* Une entrée du dossier, telle que stat() l'a vue au moment de la lecture */
+struct DirectoryEntry
+{
+	std::string	name;
+	bool		is_dir;
+	off_t		size;
+	time_t		mtime;
+	char		modified[26];	// date locale au format de ctime() ("Thu Oct 16 12:00:00 2025\n")
+};
+
+/* Entrée du cache : contenu d'un dossier, trié par nom (".." en tête)
+	Une entrée ne change plus une fois lue : une nouvelle version est une autre entrée */
+struct CachedListing
+{
+	time_t						mtime;		// du dossier lui-même
+	ino_t						ino;
+	dev_t						dev;
+	time_t						scanned;	// début de la lecture
+	int							refs;		// réponses en cours qui utilisent l'entrée (épinglée)
+	bool						retired;	// sortie du cache, libérée au dernier release()
+	std::vector<DirectoryEntry>	entries;
+	std::list<std::string>::iterator	lru_pos;
+};
+
+/*
+  Classe DirectoryCache : cache LRU des listings autoindex, clé = chemin du dossier
+  - acquire() revalide le listing par un stat() du dossier : créer, supprimer ou renommer
+    une entrée change son mtime, le dossier n'est alors relu (readdir + stat) qu'une fois
+  - un dossier modifié dans la seconde de sa lecture n'est pas gardé tel quel (le mtime
+    à la seconde ne verrait pas une seconde modification) ; un fichier réécrit sur place
+    ne change pas le dossier : invalidate() après un POST/DELETE, sinon
+    DIRECTORY_CACHE_VALID secondes au plus
+  - comme FileCache : acquire() épingle, release() rend, un verrou protège les tables
+    (boucle d'événements et threads de FilePool), jamais tenu pendant la lecture
+*/
+class DirectoryCache
+{
+	public:
+		DirectoryCache(size_t max_listings = DIRECTORY_CACHE_MAX, size_t max_entries = DIRECTORY_CACHE_MAX_ENTRIES);
+		~DirectoryCache();
+
+		const CachedListing	*acquire(const std::string &path);
+		void				release(const CachedListing *listing);
+		void				invalidate(const std::string &file);
+
+	private:
+		size_t									_max_listings;
+		size_t									_max_entries;
+		size_t									_count;		// entrées de tous les listings en cache
+		std::map<std::string, CachedListing *>	_listings;	// dossier -> listing
+		std::list<std::string>					_lru;		// plus récent en tête
+		std::set<CachedListing *>				_retired;	// hors du cache, encore épinglés
+		pthread_mutex_t							_lock;
+
+		DirectoryCache(const DirectoryCache &);
+		DirectoryCache &operator=(const DirectoryCache &);
+
+		static bool		scan(const std::string &path, CachedListing &l);
+		static bool		fresh(const CachedListing &l, const struct stat &st, time_t now);
+		CachedListing	*pin(const std::string &path, const struct stat &st, time_t now);
+		CachedListing	*insert(const std::string &path, CachedListing *l, time_t now);
+		void			drop(std::map<std::string, CachedListing *>::iterator it);
+		void			touch(CachedListing &l);
+		void			evict();
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef FILE_CACHE_HPP
+#define FILE_CACHE_HPP
+
+#include "Webserv.hpp"
+#include "Mime.hpp"
+#include <list>
+#include <set>
+#include <pthread.h>
+
+#define OPEN_FILE_CACHE_MAX 1024				// entrées (fichiers) gardées au maximum
+#define FILE_CACHE_SMALL_FILE 65536				// au-delà, le contenu reste sur disque (sendfile)
+#define FILE_CACHE_MAX_BYTES (16 * 1024 * 1024)	// somme des contenus gardés en mémoire
+
+/* Partie nanosecondes du mtime : deux réécritures dans la même seconde, à la même
+	taille, ne se distinguent que par elle */
+#ifdef __APPLE__
+# define ST_MTIME_NSEC(st) ((st).st_mtimespec.tv_nsec)
+#else
+# define ST_MTIME_NSEC(st) ((st).st_mtim.tv_nsec)
+#endif
+
+/* Entrée du cache : un fichier statique et l'état qu'il avait à l'ouverture
+	- petit fichier : content contient les octets, fd = -1 (aucun fd gardé)
+	- gros fichier  : fd ouvert, envoyé par sendfile()
+	headers et validators sont construits une seule fois, à l'insertion
+	Une entrée ne change plus une fois chargée : une nouvelle version est une autre entrée */
+struct CachedFile
+{
+	int			fd;
+	off_t		size;
+	time_t		mtime;
+	long		mtime_nsec;
+	ino_t		ino;
+	dev_t		dev;
+	int			refs;			// réponses en cours qui utilisent l'entrée (épinglée)
+	bool		in_memory;
+	bool		retired;		// sortie du cache, libérée au dernier release()
+	std::string	content;
+	std::string	etag;			// "<mtime hex>.<ns hex>-<taille hex>"
+	std::string	last_modified;	// date HTTP (RFC 7231)
+	std::string	validators;		// "ETag: ...\r\nLast-Modified: ...\r\n" (réponse 304)
+	std::string	headers;		// Content-Type + Content-Length + validators (réponse 200)
+	std::list<std::string>::iterator	lru_pos;
+};
+
+/*
+  Classe FileCache : cache LRU des fichiers statiques, clé = chemin résolu (_target_file)
+  - acquire() revalide l'entrée par stat() (inode, taille, mtime à la ns) et la recharge si besoin
+  - les petits fichiers sont servis depuis la mémoire, les gros depuis un fd partagé
+    (sendfile() lit avec son propre offset, sans toucher celui du fd)
+  - acquire() épingle l'entrée, release() la rend : une entrée évincée ou périmée
+    (et son fd) n'est libérée qu'une fois rendue par toutes les réponses
+  - partagé par la boucle d'événements et les threads de FilePool (aio_threads) :
+    un verrou protège les tables, jamais tenu pendant un accès disque
+*/
+class FileCache
+{
+	public:
+		FileCache(Mime &mime, size_t max_entries = OPEN_FILE_CACHE_MAX, size_t max_bytes = FILE_CACHE_MAX_BYTES);
+		~FileCache();
+
+		const CachedFile	*acquire(const std::string &path);
+		void				release(const CachedFile *file);
+		void				invalidate(const std::string &path);
+
+	private:
+		Mime								&_mime;
+		size_t								_max_entries;
+		size_t								_max_bytes;
+		size_t								_bytes;		// octets de contenu en mémoire
+		std::map<std::string, CachedFile *>	_entries;	// chemin -> fichier
+		std::list<std::string>				_lru;		// plus récent en tête
+		std::set<CachedFile *>				_retired;	// hors du cache, encore épinglées
+		pthread_mutex_t						_lock;
+
+		FileCache(const FileCache &);
+		FileCache &operator=(const FileCache &);
+
+		bool		load(const std::string &path, CachedFile &f);
+		void		buildHeaders(const std::string &path, CachedFile &f);
+		CachedFile	*pin(const std::string &path, const struct stat &st);
+		CachedFile	*insert(const std::string &path, CachedFile *f);
+		void		drop(std::map<std::string, CachedFile *>::iterator it);
+		void		discard(CachedFile *f);
+		void		touch(CachedFile &f);
+		void		evict();
+};
+
+#endif
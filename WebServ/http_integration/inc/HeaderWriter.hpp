@@ -0,0 +1,49 @@
+#ifndef HEADER_WRITER_HPP
+#define HEADER_WRITER_HPP
+
+#include <string>
+#include <ctime>
+#include <stdint.h>
+
+#define RESPONSE_HEAD_BUFFER 2048	// en-têtes d'une réponse ; au-delà (longue Location, CGI bavard), repli sur _spill
+
+/*
+  Classe HeaderWriter : ligne d'état + en-têtes d'une réponse, sans allocation
+  - écrits dans un tampon fixe propre à la connexion (la Response du Client),
+    réutilisé d'une requête à l'autre ; seuls des en-têtes hors norme passent
+    par une std::string
+  - ligne d'état précalculée pour chaque code ("HTTP/1.1 404 Not Found\r\n")
+  - Date reformatée au plus une fois par seconde pour tout le processus
+  - nombres écrits à la main, sans stringstream
+  Le corps n'y est jamais copié : il part à côté, dans le même writev()
+  Exemple : statusLine(200); append("Content-Length: "); number(512); crlf();
+  date(); crlf() → "HTTP/1.1 200 OK\r\nContent-Length: 512\r\nDate: ...\r\n\r\n"
+*/
+class HeaderWriter
+{
+	public:
+		HeaderWriter();
+		HeaderWriter(const HeaderWriter &other);
+		HeaderWriter &operator=(const HeaderWriter &other);
+
+		void			clear();
+		HeaderWriter	&append(const char *str, size_t len);
+		HeaderWriter	&append(const char *str);
+		HeaderWriter	&append(const std::string &str);
+		HeaderWriter	&number(uint64_t value);
+		HeaderWriter	&crlf();
+		HeaderWriter	&statusLine(short code);
+		HeaderWriter	&date();
+
+		const char		*data() const;
+		size_t			size() const;
+		bool			empty() const;
+
+	private:
+		char		_fixed[RESPONSE_HEAD_BUFFER];
+		size_t		_length;
+		std::string	_spill;		// utilisé seulement si _fixed déborde
+		bool		_spilled;
+};
+
+#endif
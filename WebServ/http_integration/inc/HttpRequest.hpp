@@ -2,6 +2,9 @@
 #define HTTP_REQUEST_HPP
 
 #include "Webserv.hpp"
+#include "RequestScanner.hpp"
+#include "BodySink.hpp"
+#include "MultipartParser.hpp"
 
 /* Méthodes HTTP supportées (enum pour numerotation)*/
 enum HttpMethod
@@ -56,6 +59,11 @@ enum ParsingState
 /*
   Classe HttpRequest : Parse et stocke les requêtes HTTP
   - Reçoit la requête caractère par caractère (feed)
+  - Chemin rapide : si le premier appel à feed() contient l'en-tête complet,
+    il est découpé d'un bloc par scanRequest() ; les headers restent des vues (view())
+  - Le corps est ajouté par blocs à un BodySink (mémoire, puis fichier temporaire),
+    ou découpé au fil de la réception par un MultipartParser (setUpload) : feed()
+    s'arrête juste après l'en-tête pour que l'appelant choisisse avant le premier octet
   - Déclenche un flag quand le parsing est terminé
   - En cas d'erreur, _error_code contient le code HTTP approprié (400, 404, etc.)
 */
@@ -70,9 +78,11 @@ class HttpRequest
         std::string                                 &getQuery(); // query string de la requête
         std::string                                 &getFragment(); // fragment de la requête
         std::string                                 getHeader(std::string const &); // header de la requête
-		const std::map<std::string, std::string>    &getHeaders() const; // headers de la requête
+        bool                                        getHeader(std::string const &, std::string &); // false si le header est absent
+		const std::map<std::string, std::string>    &getHeaders(); // headers de la requête
 		std::string                                 getMethodStr(); // méthode HTTP en string (GET, POST, DELETE, etc.)
-        std::string                                 &getBody(); // body de la requête
+        BodySink                                    &getBody(); // body de la requête (mémoire ou fichier temporaire)
+        size_t                                      getBodySize(); // octets du corps reçus (BodySink ou upload)
         std::string                                 getServerName(); // nom du serveur
         std::string                                 &getBoundary(); // boundary de la requête
         bool                                        getMultiformFlag(); // flag pour le multipart/form-data
@@ -82,22 +92,28 @@ class HttpRequest
         void        setHeader(std::string &, std::string &);
         void        setMaxBodySize(size_t);
         void        setBody(std::string name);
+        void        setBodyBuffer(size_t threshold, const std::string &temp_dir); // seuil mémoire, répertoire temporaire
+        void        setUpload(MultipartParser *upload); // corps multipart découpé à la réception, NULL : BodySink
 
         /* méthodes pour le parsing */
-        void        feed(char *data, size_t size);  // reçoit la requête caractère par caractère
+        size_t      feed(char *data, size_t size);  // reçoit la requête caractère par caractère, retourne les octets consommés
         bool        parsingCompleted(); 
+        bool        headersCompleted();     // ligne de requête et en-têtes lus, le corps peut suivre
         void        printMessage(); 
         void        clear();        
         short       errorCode();    
         bool        keepAlive();    
-        void        cutReqBody(int bytes);  
+        bool        isHttp11();     // HTTP/1.1 : le client comprend Transfer-Encoding: chunked
+        const RequestView   &view() const;  // vues du chemin rapide (vide sinon), valables jusqu'à clear()
 
     private:
         std::string                         _path;
         std::string                         _query;
         std::string                         _fragment;
         std::map<std::string, std::string>  _request_headers;
-        std::vector<u_int8_t>               _body; 
+        BodySink                            _body;
+        MultipartParser                     *_upload;   // emprunté à Response, jusqu'à clear()
+        size_t                              _body_received;
         std::string                         _boundary;
         HttpMethod                          _method;
         std::map<u_int8_t, std::string>     _method_str;
@@ -112,7 +128,9 @@ class HttpRequest
         u_int8_t                            _ver_major;
         u_int8_t                            _ver_minor;
         std::string                         _server_name;
-        std::string                         _body_str;
+        std::string                         _head;      // copie de l'en-tête (chemin rapide), cible des vues de _view
+        RequestView                         _view;
+        bool                                _headers_built; // _request_headers remplie à partir de _view
         /* flags */
         bool                                _fields_done_flag;
         bool                                _body_flag;
@@ -122,6 +140,9 @@ class HttpRequest
         bool                                _multiform_flag;
 
         void            _handle_headers();
+        void            _fields_end();
+        bool            _append_body(const char *data, size_t len);
+        size_t          _fast_parse(char *data, size_t size);
 
 };
 
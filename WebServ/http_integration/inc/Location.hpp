@@ -14,6 +14,10 @@
 #define LOCATION_HPP
 
 #include "Webserv.hpp"
+#include "CgiEnvTemplate.hpp"
+
+#define CGI_POOL_MAX_SIZE 64			// cgi_pool : interpréteurs persistants au plus
+#define CGI_POOL_MAX_REQUESTS 1000		// cgi_pool_max_requests par défaut
 
 class Location
 {
@@ -21,6 +25,8 @@ class Location
 		std::string					_path;
 		std::string					_root;
 		bool						_autoindex;
+		bool						_autoindex_json;		// autoindex_format json (html par défaut)
+		size_t						_autoindex_page_size;	// 0 : tout le dossier sur une page
 		std::string					_index;
 		std::vector<short>			_methods; // GET+ POST- DELETE-
 		std::string					_return;
@@ -28,6 +34,9 @@ class Location
 		std::vector<std::string>	_cgi_path;
 		std::vector<std::string>	_cgi_ext;
 		unsigned long				_client_max_body_size;
+		size_t						_cgi_pool;				// 0 : un processus par requête CGI
+		size_t						_cgi_pool_max_requests;	// requêtes servies avant de recycler un interpréteur
+		CgiEnvTemplate				_cgi_env;				// partie fixe de l'environnement CGI, voir buildCgiEnv()
 
 	public:
 		std::map<std::string, std::string> _ext_path;
@@ -41,6 +50,8 @@ class Location
 		void setRootLocation(std::string parametr);
 		void setMethods(std::vector<std::string> methods);
 		void setAutoindex(std::string parametr);
+		void setAutoindexFormat(std::string parametr);
+		void setAutoindexPageSize(std::string parametr);
 		void setIndexLocation(std::string parametr);
 		void setReturn(std::string parametr);
 		void setAlias(std::string parametr);
@@ -48,11 +59,16 @@ class Location
 		void setCgiExtension(std::vector<std::string> extension);
 		void setMaxBodySize(std::string parametr);
 		void setMaxBodySize(unsigned long parametr);
+		void setCgiPool(std::string parametr);
+		void setCgiPoolMaxRequests(std::string parametr);
+		void buildCgiEnv();
 
 		const std::string &getPath() const;
 		const std::string &getRootLocation() const;
 		const std::vector<short> &getMethods() const;
 		const bool &getAutoindex() const;
+		bool getAutoindexJson() const;
+		size_t getAutoindexPageSize() const;
 		const std::string &getIndexLocation() const;
 		const std::string &getReturn() const;
 		const std::string &getAlias() const;
@@ -60,6 +76,9 @@ class Location
 		const std::vector<std::string> &getCgiExtension() const;
 		const std::map<std::string, std::string> &getExtensionPath() const;
 		const unsigned long &getMaxBodySize() const;
+		size_t getCgiPool() const;
+		size_t getCgiPoolMaxRequests() const;
+		const CgiEnvTemplate &getCgiEnv() const;
 
 		std::string getPrintMethods() const; // pour contôle uniquement
 
@@ -0,0 +1,38 @@
+#ifndef LOCATION_TRIE_HPP
+#define LOCATION_TRIE_HPP
+
+#include <string>
+#include <vector>
+
+/* Noeud du trie : un caractère par arête, arêtes triées pour une recherche dichotomique */
+struct LocationTrieNode
+{
+	std::vector<char>	keys;		// caractères des arêtes sortantes (triés)
+	std::vector<int>	next;		// index du noeud enfant pour chaque arête
+	int					location;	// index dans ServerConfig::_locations, -1 si aucun chemin ne finit ici
+};
+
+/*
+  Classe LocationTrie : trie des chemins de location, construit au chargement de la config
+  - match() parcourt l'URI une seule fois, sans copier ni comparer chaque location
+  - règle de correspondance inchangée : "/" correspond à tout, sinon le chemin de la
+    location doit être l'URI entière ou être suivi d'un '/' ("/img" -> "/img/a.png", pas "/imgs")
+  - la plus longue correspondance gagne
+  Les noeuds sont dans un vector (indices, pas de pointeurs) : copie de ServerConfig sans risque
+*/
+class LocationTrie
+{
+	public:
+		LocationTrie();
+
+		void	insert(const std::string &path, int location);
+		int		match(const std::string &uri) const;
+		void	clear();
+
+	private:
+		std::vector<LocationTrieNode>	_nodes;	// _nodes[0] = racine (chemin vide)
+
+		int		child(int node, char c) const;
+};
+
+#endif
@@ -25,7 +25,7 @@ public:
 
 	Mime();
 
-	std::string getMimeType(std::string extension);
+	const std::string &getMimeType(const std::string &extension) const;
 
 };
 
@@ -0,0 +1,99 @@
+#ifndef MULTIPART_PARSER_HPP
+#define MULTIPART_PARSER_HPP
+
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+#define MULTIPART_HEADER_MAX 8192	// en-têtes d'une partie, au-delà : 400
+
+/*
+  Classe Horspool : recherche Boyer-Moore-Horspool d'un motif fixe
+  - la table de sauts est calculée une fois pour le motif
+  - à chaque position, on compare le dernier octet de la fenêtre puis le reste ;
+    en cas d'échec, on saute de _shift[dernier octet] (jusqu'à la longueur du motif)
+  Exemple : motif "\r\n--XyZ" (7 octets) dans un corps binaire, la plupart des
+  octets ne sont pas dans le motif : on avance de 7 octets par comparaison
+*/
+class Horspool
+{
+    public:
+        Horspool();
+
+        void        assign(const std::string &pattern);
+        size_t      find(const char *text, size_t len) const;  // std::string::npos si absent
+        size_t      size() const;
+        const std::string   &pattern() const;
+
+    private:
+        std::string _pattern;
+        size_t      _shift[256];
+};
+
+/* États du découpage multipart/form-data (RFC 7578) */
+enum MultipartState
+{
+    Multipart_Delimiter_End,    // après un délimiteur : "--" (fin) ou CRLF (partie suivante)
+    Multipart_Headers,          // en-têtes de la partie, jusqu'à la ligne vide
+    Multipart_Data,             // contenu de la partie, jusqu'au délimiteur suivant
+    Multipart_Done              // délimiteur final lu, l'épilogue est ignoré
+};
+
+/*
+  Classe MultipartParser : découpe un corps multipart/form-data en un seul passage
+  - feed() reçoit le corps par tranches de taille quelconque ; seuls les octets
+    qui pourraient commencer un délimiteur coupé en deux sont gardés d'une tranche
+    à l'autre (moins que la longueur du délimiteur), plus les en-têtes d'une partie
+  - le délimiteur "\r\n--boundary" est cherché avec Horspool
+  - chaque partie qui porte un filename est écrite au fur et à mesure dans un
+    fichier temporaire à côté de sa destination ; les champs sans fichier sont
+    ignorés. finish() les renomme tous une fois le corps entier valide : une
+    erreur (ou un corps tronqué) supprime les temporaires et ne touche à aucun
+    fichier existant
+  - destination : vers un répertoire, chaque fichier sous son nom (sans chemin) ;
+    vers un fichier, le premier fichier du formulaire le remplace, les suivants
+    vont à côté, sous leur nom
+  Exemple : boundary "XyZ", cible "www/upload/"
+  "--XyZ\r\nContent-Disposition: form-data; name=\"a\"; filename=\"a.png\"\r\n\r\n<png>"
+  "\r\n--XyZ\r\n...filename=\"b.txt\"\r\n\r\nhello\r\n--XyZ--\r\n"
+  → www/upload/a.png, www/upload/b.txt ; finish() → true
+*/
+class MultipartParser
+{
+    public:
+        MultipartParser(const std::string &boundary, const std::string &target, bool to_directory);
+        ~MultipartParser();
+
+        bool        feed(const char *data, size_t len);    // false : erreur, voir errorCode()
+        bool        finish();                               // false si le délimiteur final manque
+        short       errorCode() const;                      // 400 malformé, 403 fichier refusé, 500 écriture
+        bool        created() const;                        // au moins un fichier n'existait pas avant
+        const std::vector<std::string>  &files() const;     // fichiers écrits, dans l'ordre
+
+    private:
+        Horspool                    _delimiter;     // "\r\n--" + boundary
+        std::string                 _buffer;        // octets reçus pas encore traités
+        std::string                 _target;
+        bool                        _to_directory;
+        MultipartState              _state;
+        int                         _fd;            // fichier de la partie en cours, -1 : ignorée
+        short                       _error_code;
+        bool                        _created;
+        std::vector<std::string>    _files;         // destinations, dans l'ordre
+        std::vector<std::string>    _temps;         // temporaire de chaque destination, vide une fois renommé
+
+        size_t      _parse(const char *data, size_t len);
+        size_t      _delimiterEnd(const char *data, size_t len);
+        size_t      _headers(const char *data, size_t len);
+        size_t      _data(const char *data, size_t len);
+        bool        _openPart(const std::string &filename);
+        bool        _write(const char *data, size_t len);
+        void        _closePart();
+        bool        _fail(short code);
+        void        _discard();
+
+        MultipartParser(const MultipartParser &);
+        MultipartParser &operator=(const MultipartParser &);
+};
+
+#endif
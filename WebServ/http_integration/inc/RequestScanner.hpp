@@ -0,0 +1,56 @@
+#ifndef REQUEST_SCANNER_HPP
+#define REQUEST_SCANNER_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#define MAX_FAST_HEADERS 64		// au-delà, la requête passe par la machine à états
+
+/* Tranche d'un buffer : pointe dans les octets reçus (Client::read_buffer), aucune copie */
+struct StrView
+{
+	const char	*data;
+	size_t		len;
+
+	StrView() : data(NULL), len(0) {}
+	StrView(const char *d, size_t l) : data(d), len(l) {}
+	std::string	str() const { return (std::string(data, len)); }
+};
+
+struct HeaderView
+{
+	StrView	name;		// tel que reçu (casse d'origine)
+	StrView	value;		// sans les espaces de début et de fin
+};
+
+/* Requête découpée par scanRequest() : uniquement des vues sur le buffer,
+	valables tant que ce buffer n'est ni modifié ni réalloué */
+struct RequestView
+{
+	StrView					method;
+	StrView					path;
+	StrView					query;
+	StrView					fragment;
+	char					ver_minor;		// '0' ou '1'
+	size_t					head_length;	// ligne de requête + headers + CRLF final
+	std::vector<HeaderView>	headers;
+
+	RequestView() : ver_minor(0), head_length(0) {}
+	void	clear();
+};
+
+/*
+  Découpage rapide d'une requête reçue en entier (ligne de requête + headers)
+  - les délimiteurs (' ', '\r', ':') sont cherchés 16 octets à la fois (SSE2),
+    repli octet par octet sur les autres architectures
+  - la validité des caractères (URI, nom de header) est vérifiée par table
+  - renvoie false pour tout ce qui sort du cas courant (en-tête incomplet, méthode
+    inconnue, version autre que 1.0/1.1, caractère invalide...) : l'appelant repasse
+    alors par la machine à états de HttpRequest, qui produit le bon code d'erreur
+*/
+const char	*scanByte(const char *p, const char *end, char c);
+const char	*scanHeadEnd(const char *p, const char *end);
+bool		scanRequest(const char *data, size_t size, RequestView &view);
+
+#endif
@@ -17,13 +17,23 @@
 # include "Mime.hpp"
 # include "CgiHandler.hpp"
 # include "ServerConfig.hpp"
+# include "FileCache.hpp"
+# include "BodySource.hpp"
+# include "MultipartParser.hpp"
+# include "HeaderWriter.hpp"
+# include <sys/uio.h>
 
-/*	Création et stockage de la réponse. Une fois prête, elle
-	sera stockée dans _response_content et pourra être utilisée par la fonction getRes(). */
+# define PHASE_UNTIMED ((uint64_t)-1)
+
+/*	Création et stockage de la réponse. Une fois prête, ses en-têtes sont dans _head
+	et son corps en mémoire dans _response_body, ou directement dans l'entrée du
+	cache (_cached_body) : getVector() les donne tels quels au writev() de la
+	connexion, sans les concaténer ni les copier. */
 class Response
 {
 private:
-	ServerConfig		_server;
+	const ServerConfig	*_server;		// Config du serveur choisi, empruntée (jamais copiée)
+	HttpRequest			*_request;		// Requête du Client, empruntée
 	std::string			_target_file;
 	std::vector<uint8_t>_body;
 	size_t				_body_length;
@@ -34,53 +44,89 @@ private:
 	int					_cgi_fd[2];
 	size_t				_cgi_response_length;
 	bool				_auto_index;
+	ListingView			_listing_view;	// Autoindex : format et page demandés (location + ?format=&page=)
+	int					_file_fd;		// GET statique : corps envoyé par sendfile() depuis ce fd
+	off_t				_file_size;
+	const CachedFile	*_cached;		// Entrée du cache pour ce GET, épinglée jusqu'à releaseFile()
+	const std::string	*_cached_body;	// Son contenu (petit fichier), envoyé sans copie ; NULL : _response_body
+	BodySource			*_source;		// Corps produit en flux (autoindex, CGI), tiré par pullBody()
+	StreamSource		*_stream;		// = _source pour un CGI : alimenté par la sortie du script
+	MultipartParser		*_upload;		// POST multipart découpé pendant la réception (streamUpload())
+	bool				_chunked;		// Longueur inconnue en HTTP/1.1 : Transfer-Encoding: chunked
+	bool				_source_done;
+	HeaderWriter		_head;			// Ligne d'état + en-têtes, tampon fixe réutilisé par la connexion
+	bool				_with_body;		// _response_body part après _head (pas pour un POST réussi)
+	uint64_t			_resolve_us;	// Durées mesurées par resolveBody(), enregistrées par buildHead()
+	uint64_t			_read_us;		// (PHASE_UNTIMED : phase pas exécutée)
 
 	int		buildBody();
 	void	setStatusLine();
 	void	setHeaders();
 	void	setServerDefaultErrorPages(); 
 	int		readFile();
+	int		openFile();
+	bool	notModified();
 	void	contentType();
 	void	contentLength();
 	void	connection();
 	void	server();	
 	void	location();	
 	void	date();
+	void	attachBody(BodySource *source);
+	const std::string	&bodyInMemory() const;
 	int		handleTarget();
+	void	listingView(const Location &location);
+	int		saveMultipart();
 	void	buildErrorBody();
 	bool	reqError();
-	int		handleCgi(std::string &);
-	int		handleCgiTemp(std::string &);
+	int		handleCgi(const Location &);
+	int		handleCgiTemp(const Location &);
+	size_t	cgiHeaderEnd();
+	bool	cgiHead(std::string &out);
 
 public:
 	static	Mime 	mime;    // Objet Mime pour la gestion des types de contenu.
+	static	FileCache	files;	// Cache des fichiers statiques ouverts.
+	static	DirectoryCache	directories;	// Cache des listings autoindex.
 	CgiHandler		cgi_obj; // Objet CgiHandler pour la gestion des CGI.
-	HttpRequest		request; // Objet HttpRequest pour la gestion des requêtes.
 
 	 Response();
 	~Response();
 	Response(HttpRequest&);
+	Response(const Response &);
+	Response &operator=(const Response &);
 
 /* getters */
-	std::string	getRes();
 	size_t		getLen() const;
+	int			getVector(struct iovec *iov, size_t offset) const;
 	int			getCode() const;
+	bool		keepAlive();
+	int			getFileFd() const;
+	off_t		getFileSize() const;
+	size_t		getBufferSize();
+	bool		hasBodySource() const;
+	StreamSource	*cgiStream();
+	bool		cgiReady();
 
 /* setters */
 	void	setRequest(HttpRequest &);
-	void	setServer(ServerConfig &);
+	void	setServer(const ServerConfig &);
 
 /* construction de la réponse */
+	void	streamUpload();
 	void	buildResponse();
+	bool	offloadable() const;
+	void	resolveBody();
+	void	buildHead();
 	void	clear();
-	void	cutRes(size_t);
+	void	releaseFile();
+	void	releaseBody();
+	void	releaseUpload();
+	BodySource::Status	pullBody(std::string &out, size_t max);
 	int		getCgiState();
 	void	setCgiState(int);
 	void	setErrorResponse(short code);
-
-/* gestion des CGI */
-	std::string	removeBoundary(std::string &body, std::string &boundary);
-	std::string	response_content;
+	void	setGeneratedResponse(const std::string &body, const std::string &name);
 
 };
 
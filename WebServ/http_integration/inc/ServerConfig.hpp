@@ -14,6 +14,25 @@
 #define SERVERCONFIG_H
 
 #include "Webserv.hpp"
+#include "LocationTrie.hpp"
+#include "Timeouts.hpp"
+#include "SocketOptions.hpp"
+#include "BodySink.hpp"
+
+/* Taille par défaut du tampon de sortie d'une connexion (directive output_buffer_size).
+	C'est à la fois la taille d'une tranche envoyée et le plafond de ce qui est
+	gardé en mémoire pour un corps produit au fil de l'eau (sortie CGI). */
+#define OUTPUT_BUFFER_SIZE 65536
+
+/* Sortie maximale d'un script CGI par défaut (directive cgi_max_output) :
+	au-delà, le script est tué et la réponse abandonnée. */
+#define CGI_MAX_OUTPUT 104857600
+
+/* Threads d'E/S fichier par défaut (directive aio_threads) : 0, tout reste dans la
+	boucle d'événements. Le pool est commun au processus, sa taille est la plus
+	grande valeur des blocs server. */
+#define AIO_THREADS_OFF 0
+#define AIO_THREADS_MAX 64
 
 static std::string	serverParametrs[] = {"server_name", "listen", "root", "index", "allow_methods", "client_body_buffer_size"};
 
@@ -27,10 +46,19 @@ class ServerConfig
 		std::string						_server_name;
 		std::string						_root;
 		unsigned long					_client_max_body_size;
+		size_t							_output_buffer_size;
+		size_t							_cgi_max_output;	// octets, au-delà le CGI est tué
+		size_t							_aio_threads;	// 0 : disque lu et écrit par la boucle d'événements
+		size_t							_client_body_buffer_size;	// corps en mémoire jusque-là, puis fichier temporaire
+		std::string						_client_body_temp_path;
+		time_t							_timeouts[TIMEOUT_PHASES];	// secondes, indexé par TimeoutPhase
+		int								_socket_options[SOCKET_OPTIONS];	// indexé par SocketOption
 		std::string						_index;
 		bool							_autoindex;
+		bool							_status_page;	// GET /__status : compteurs et latences (Metrics)
 		std::map<short, std::string>	_error_pages;
 		std::vector<Location> 			_locations;
+		LocationTrie					_location_trie;
 		struct sockaddr_in 				_server_address;
 		int								_listen_fd;
 
@@ -48,32 +76,50 @@ class ServerConfig
 		void setFd(int);
 		void setPort(std::string parametr);
 		void setClientMaxBodySize(std::string parametr);
+		void setOutputBufferSize(std::string parametr);
+		void setCgiMaxOutput(std::string parametr);
+		void setAioThreads(std::string parametr);
+		void setClientBodyBufferSize(std::string parametr);
+		void setClientBodyTempPath(std::string parametr);
+		void setTimeout(TimeoutPhase phase, std::string parametr);
+		void setSocketOption(SocketOption option, std::string parametr);
 		void setErrorPages(std::vector<std::string> &parametr);
 		void setIndex(std::string index);
 		void setLocation(std::string nameLocation, std::vector<std::string> parametr);
 		void setAutoindex(std::string autoindex);
+		void setStatusPage(std::string status_page);
 
 		bool isValidHost(std::string host) const;
 		bool isValidErrorPages();
 		int	 isValidLocation(Location &location) const;
 
-		const std::string &getServerName();
-		const uint16_t &getPort();
-		const in_addr_t &getHost();
-		const size_t &getClientMaxBodySize();
-		const std::vector<Location> &getLocations();
-		const std::string &getRoot();
-		const std::map<short, std::string> &getErrorPages();
-		const std::string &getIndex();
-		const bool &getAutoindex();
-		const std::string &getPathErrorPage(short key);
-		const std::vector<Location>::iterator getLocationKey(std::string key);
+		const std::string &getServerName() const;
+		const uint16_t &getPort() const;
+		const in_addr_t &getHost() const;
+		const size_t &getClientMaxBodySize() const;
+		const size_t &getOutputBufferSize() const;
+		const size_t &getCgiMaxOutput() const;
+		size_t getAioThreads() const;
+		const size_t &getClientBodyBufferSize() const;
+		const std::string &getClientBodyTempPath() const;
+		time_t getTimeout(TimeoutPhase phase) const;
+		int getSocketOption(SocketOption option) const;
+		const std::vector<Location> &getLocations() const;
+		const std::string &getRoot() const;
+		const std::map<short, std::string> &getErrorPages() const;
+		const std::string &getIndex() const;
+		const bool &getAutoindex() const;
+		bool getStatusPage() const;
+		const std::string &getPathErrorPage(short key) const;
+		const Location *matchLocation(const std::string &uri) const;
 
 		static void checkToken(std::string &parametr);
+		static int	timeoutDirective(const std::string &name);
+		static int	socketOptionDirective(const std::string &name);
 		bool		checkLocations() const;
 
-		void	setupServer();
-		int		getFd();
+		void	setupServer(bool reuse_port = false);
+		int		getFd() const;
 
 		class ErrorException : public std::exception
 		{
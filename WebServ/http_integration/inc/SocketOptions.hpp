@@ -0,0 +1,30 @@
+#ifndef SOCKET_OPTIONS_HPP
+#define SOCKET_OPTIONS_HPP
+
+/* Options des sockets par défaut (directives du bloc server du même nom) */
+#define LISTEN_BACKLOG 4096		// connexions en attente d'accept() ; le noyau plafonne à net.core.somaxconn
+#define TCP_NODELAY_ON 1		// réponses envoyées sans attendre (pas d'algorithme de Nagle)
+#define TCP_DEFER_ACCEPT_OFF 0	// accept() dès la connexion, sans attendre la requête
+#define SOCKET_BUFFER_SYSTEM 0	// tampons d'émission / réception réglés par le noyau
+#define TCP_FASTOPEN_OFF 0		// pas de données dans le SYN
+
+/* Option d'un socket d'écoute : posée avant listen(), héritée par les connexions
+	acceptées (aucun appel système de plus par connexion)
+	- BACKLOG : file des connexions établies pas encore acceptées
+	- NODELAY : on / off
+	- DEFER_ACCEPT : secondes pendant lesquelles le noyau garde une connexion
+	  sans données avant de la présenter à accept() ; 0 : désactivé
+	- RCVBUF, SNDBUF : octets ; 0 : réglage automatique du noyau
+	- FASTOPEN : SYN avec données en attente au plus ; 0 : désactivé */
+enum SocketOption
+{
+	SOCKET_BACKLOG,
+	SOCKET_NODELAY,
+	SOCKET_DEFER_ACCEPT,
+	SOCKET_RCVBUF,
+	SOCKET_SNDBUF,
+	SOCKET_FASTOPEN,
+	SOCKET_OPTIONS
+};
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef TIMEOUTS_HPP
+#define TIMEOUTS_HPP
+
+/* Délais par défaut, en secondes (directives du bloc server du même nom) */
+#define CLIENT_HEADER_TIMEOUT 60	// ligne de requête + en-têtes, depuis le premier octet
+#define CLIENT_BODY_TIMEOUT 60		// entre deux lectures du corps
+#define SEND_TIMEOUT 60				// entre deux écritures de la réponse
+#define KEEPALIVE_TIMEOUT 15		// connexion inactive entre deux requêtes
+#define CGI_TIMEOUT 60				// exécution d'un script, depuis son lancement
+
+/* Phase d'une connexion : chacune a son propre délai
+	- HEADER, CGI, KEEPALIVE : délai fixé à l'entrée dans la phase (un client lent
+	  qui envoie un octet par seconde n'allonge pas son délai d'en-têtes)
+	- BODY, SEND : délai repoussé à chaque lecture / écriture */
+enum TimeoutPhase
+{
+	TIMEOUT_HEADER,
+	TIMEOUT_BODY,
+	TIMEOUT_SEND,
+	TIMEOUT_KEEPALIVE,
+	TIMEOUT_CGI,
+	TIMEOUT_PHASES
+};
+
+#endif
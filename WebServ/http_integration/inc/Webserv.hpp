@@ -39,6 +39,7 @@
 /* Network */
 # include <sys/socket.h>
 # include <netinet/in.h>
+# include <netinet/tcp.h>
 # include <sys/select.h>
 # include <arpa/inet.h>
 
@@ -51,7 +52,6 @@
 # include "Mime.hpp"
 
 
-#define CONNECTION_TIMEOUT 60
 #ifdef TESTER
     #define MESSAGE_BUFFER 40000 
 #else
@@ -74,9 +74,10 @@ std::string toString(const T val)
 
 std::string statusCodeString(short); // transforme le code numérique en texte descriptif : 200 -> "ok"
 std::string getErrorPage(short); // construit le chemin d'un fichier d'erreur : 404 -> "error_pages/404.html"   
-int buildHtmlIndex(std::string &, std::vector<uint8_t> &, size_t &); // construit l'index HTML d'un dossier : "index.html"
 int ft_stoi(std::string str); // convertit une chaîne de caractères en entier : "123" -> 123
 unsigned int fromHexToDec(const std::string& nb); // convertit une chaîne de caractères en nombre hexadécimal : "1A" -> 26
+time_t parseHttpDate(const std::string &date); // date HTTP "Sun, 06 Nov 1994 08:49:37 GMT" -> time_t UTC, -1 si invalide
+uint64_t monotonicMicros(); // horloge monotone en microsecondes, pour mesurer des durées
 
 
 #endif
@@ -0,0 +1,107 @@
+#include "Arena.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#define ARENA_ALIGN 16
+
+Arena::Arena(size_t block_size) : _block_size(block_size), _current(0), _offset(0), _used(0) {}
+
+Arena::Arena(const Arena &other) : _block_size(other._block_size), _current(0), _offset(0), _used(0) {}
+
+/* Les blocs restent à leur propriétaire : rien n'est copié */
+Arena &Arena::operator=(const Arena &other)
+{
+	(void)other;
+	return (*this);
+}
+
+Arena::~Arena()
+{
+	release(0);
+}
+
+/* size octets alignés sur ARENA_ALIGN, valables jusqu'au prochain reset() */
+void	*Arena::alloc(size_t size)
+{
+	size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+	while (_current < _blocks.size() && _offset + size > _blocks[_current].size)
+	{
+		_current++;
+		_offset = 0;
+	}
+	if (_current == _blocks.size())
+	{
+		Block	block;
+		block.size = (size > _block_size ? size : _block_size);
+		block.data = static_cast<char *>(malloc(block.size));
+		if (block.data == NULL)
+			throw std::bad_alloc();
+		_blocks.push_back(block);
+		_offset = 0;
+	}
+	void	*ptr = _blocks[_current].data + _offset;
+	_offset += size;
+	_used += size;
+	return (ptr);
+}
+
+/* Copie terminée par '\0' */
+char	*Arena::copy(const std::string &str)
+{
+	char	*dst = static_cast<char *>(alloc(str.size() + 1));
+
+	memcpy(dst, str.data(), str.size());
+	dst[str.size()] = '\0';
+	return (dst);
+}
+
+/* "key<sep>value" terminé par '\0', sans chaîne temporaire (ex. "NAME=valeur" pour envp) */
+char	*Arena::join(const std::string &key, char sep, const std::string &value)
+{
+	char	*dst = static_cast<char *>(alloc(key.size() + value.size() + 2));
+
+	memcpy(dst, key.data(), key.size());
+	dst[key.size()] = sep;
+	memcpy(dst + key.size() + 1, value.data(), value.size());
+	dst[key.size() + 1 + value.size()] = '\0';
+	return (dst);
+}
+
+/* Même chose pour un nom littéral ("QUERY_STRING") : pas de std::string construite pour la clé */
+char	*Arena::join(const char *key, char sep, const std::string &value)
+{
+	size_t	key_len = strlen(key);
+	char	*dst = static_cast<char *>(alloc(key_len + value.size() + 2));
+
+	memcpy(dst, key, key_len);
+	dst[key_len] = sep;
+	memcpy(dst + key_len + 1, value.data(), value.size());
+	dst[key_len + 1 + value.size()] = '\0';
+	return (dst);
+}
+
+/* Tout ce qui a été alloué devient invalide. Le premier bloc est gardé s'il a la
+	taille standard ; les blocs supplémentaires (pic ponctuel) sont rendus au système */
+void	Arena::reset()
+{
+	if (!_blocks.empty() && _blocks[0].size == _block_size)
+		release(1);
+	else
+		release(0);
+	_current = 0;
+	_offset = 0;
+	_used = 0;
+}
+
+size_t	Arena::used() const
+{
+	return (_used);
+}
+
+void	Arena::release(size_t from)
+{
+	for (size_t i = from; i < _blocks.size(); ++i)
+		free(_blocks[i].data);
+	_blocks.resize(from);
+}
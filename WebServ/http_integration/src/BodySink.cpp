@@ -0,0 +1,204 @@
+#include "BodySink.hpp"
+#include "Webserv.hpp"
+
+mode_t  BodySink::_umask = 022;
+
+/* Lu une fois au démarrage, avant tout thread : umask() ne se lit qu'en le
+   modifiant, et le modifier depuis un thread de FilePool donnerait des droits
+   0666/0777 à un fichier créé au même instant par un autre thread */
+void    BodySink::captureUmask()
+{
+    _umask = umask(0);
+    umask(_umask);
+}
+
+mode_t  BodySink::fileMode()
+{
+    return (0666 & ~_umask);
+}
+
+BodySink::BodySink() : _temp_dir(CLIENT_BODY_TEMP_PATH), _threshold(CLIENT_BODY_BUFFER_SIZE), _size(0), _fd(-1)
+{
+}
+
+BodySink::~BodySink()
+{
+    clear();
+}
+
+/* Seuil et répertoire du serveur de la connexion, gardés d'une requête à l'autre */
+void    BodySink::configure(size_t threshold, const std::string &temp_dir)
+{
+    _threshold = threshold;
+    _temp_dir = temp_dir;
+}
+
+/* Passe en fichier temporaire : ce qui était en mémoire y est écrit, puis libéré.
+   Le fd est close-on-exec (les CGI ne l'héritent pas) */
+bool    BodySink::_spill()
+{
+    std::string path = _temp_dir + "/webserv-body-XXXXXX";
+    std::vector<char> name(path.begin(), path.end());
+
+    name.push_back('\0');
+    _fd = mkstemp(&name[0]);
+    if (_fd < 0)
+        return (false);
+    _temp_path = &name[0];
+    fcntl(_fd, F_SETFD, FD_CLOEXEC);
+    for (size_t done = 0; done < _memory.size(); )
+    {
+        ssize_t n = write(_fd, _memory.data() + done, _memory.size() - done);
+        if (n < 0)
+            return (false);
+        done += n;
+    }
+    std::string().swap(_memory);
+    return (true);
+}
+
+/* Ajoute des octets du corps ; false si le fichier temporaire ne peut être écrit
+   (répertoire absent, disque plein) : la requête échoue en 500 */
+bool    BodySink::append(const char *data, size_t len)
+{
+    if (_fd < 0 && _size + len > _threshold && !_spill())
+        return (false);
+    if (_fd < 0)
+        _memory.append(data, len);
+    else
+    {
+        for (size_t done = 0; done < len; )
+        {
+            ssize_t n = write(_fd, data + done, len - done);
+            if (n < 0)
+                return (false);
+            done += n;
+        }
+    }
+    _size += len;
+    return (true);
+}
+
+size_t  BodySink::size() const
+{
+    return (_size);
+}
+
+bool    BodySink::inMemory() const
+{
+    return (_fd < 0);
+}
+
+const std::string   &BodySink::memory() const
+{
+    return (_memory);
+}
+
+/* Comme write(fd, ...) pour les octets [offset, offset + len) du corps
+   En mémoire : un write() direct ; sur disque : pread() d'une tranche puis write().
+   Une écriture partielle relira la fin de la tranche au prochain appel */
+ssize_t BodySink::writeTo(int fd, size_t offset, size_t len) const
+{
+    if (_fd < 0)
+        return (write(fd, _memory.data() + offset, len));
+
+    char    buffer[BODY_SINK_CHUNK];
+    ssize_t n = pread(_fd, buffer, std::min(len, sizeof(buffer)), offset);
+
+    if (n <= 0)
+    {
+        if (n == 0)
+            errno = EIO;
+        return (-1);
+    }
+    return (write(fd, buffer, n));
+}
+
+/* Comme pread() : jusqu'à len octets du corps depuis offset, dans buffer
+   (le découpage multipart lit le corps tranche par tranche) */
+ssize_t BodySink::read(size_t offset, char *buffer, size_t len) const
+{
+    if (_fd >= 0)
+        return (pread(_fd, buffer, len, offset));
+    if (offset >= _size)
+        return (0);
+    len = std::min(len, _size - offset);
+    memcpy(buffer, _memory.data() + offset, len);
+    return (len);
+}
+
+/* Copie le fichier temporaire dans fd, par tranches */
+bool    BodySink::_copyTo(int fd) const
+{
+    for (size_t done = 0; done < _size; )
+    {
+        ssize_t n = writeTo(fd, done, _size - done);
+        if (n < 0)
+            return (false);
+        done += n;
+    }
+    return (true);
+}
+
+/* Dépose le corps dans path (upload)
+   - en mémoire : un seul write()
+   - fichier temporaire : rename(), aucune copie ; copie par tranches si path est
+     sur un autre système de fichiers (EXDEV)
+   Comme avec un open() : un fichier existant non inscriptible est refusé, et le
+   fichier créé a les droits habituels (0666 moins l'umask lu au démarrage) */
+bool    BodySink::saveAs(const std::string &path)
+{
+    if (access(path.c_str(), F_OK) == 0 && access(path.c_str(), W_OK) != 0)
+        return (false);
+    if (_fd >= 0)
+    {
+        fchmod(_fd, fileMode());
+        if (rename(_temp_path.c_str(), path.c_str()) == 0)
+        {
+            _temp_path.clear();
+            return (true);
+        }
+        if (errno != EXDEV)
+            return (false);
+    }
+
+    int     fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    bool    done = true;
+
+    if (fd < 0)
+        return (false);
+    if (_fd >= 0)
+        done = _copyTo(fd);
+    else
+    {
+        for (size_t written = 0; done && written < _memory.size(); )
+        {
+            ssize_t n = write(fd, _memory.data() + written, _memory.size() - written);
+            done = n >= 0;
+            written += n;
+        }
+    }
+    close(fd);
+    return (done);
+}
+
+/* Requête suivante : le fichier temporaire est supprimé, la mémoire gardée
+   sauf si elle a beaucoup grossi */
+void    BodySink::clear()
+{
+    if (_fd >= 0)
+    {
+        close(_fd);
+        _fd = -1;
+    }
+    if (!_temp_path.empty())
+    {
+        unlink(_temp_path.c_str());
+        _temp_path.clear();
+    }
+    if (_memory.capacity() > _threshold)
+        std::string().swap(_memory);
+    else
+        _memory.clear();
+    _size = 0;
+}
@@ -0,0 +1,273 @@
+#include "BodySource.hpp"
+
+/* ---------------------------- DirectorySource ---------------------------- */
+
+DirectorySource::DirectorySource(DirectoryCache &cache, const std::string &dir_name, const std::string &uri, const ListingView &view)
+	: _cache(cache), _dir_name(dir_name), _uri(uri), _view(view), _pages(1), _first(0), _next(0), _end(0), _state(0)
+{
+	_listing = cache.acquire(dir_name);
+	if (_listing == NULL)
+		return ;
+	_end = _listing->entries.size();
+	if (_view.page_size && _end)
+		_pages = (_end + _view.page_size - 1) / _view.page_size;
+	if (_view.page < 1)
+		_view.page = 1;
+	if (_view.page_size)
+	{
+		_first = std::min((_view.page - 1) * _view.page_size, _end);	// au-delà de la dernière page : vide
+		_end = std::min(_first + _view.page_size, _end);
+	}
+	_next = _first;
+}
+
+DirectorySource::~DirectorySource()
+{
+	_cache.release(_listing);
+}
+
+bool	DirectorySource::isOpen() const
+{
+	return (_listing != NULL);
+}
+
+/* Nombre écrit à la main : un stringstream par entrée coûte plus que l'entrée elle-même */
+static void	appendNumber(std::string &out, long value)
+{
+	char			digits[24];
+	size_t			i = sizeof(digits);
+	unsigned long	n = value < 0 ? -(unsigned long)value : value;
+
+	do
+	{
+		digits[--i] = '0' + n % 10;
+		n /= 10;
+	} while (n);
+	if (value < 0)
+		digits[--i] = '-';
+	out.append(digits + i, sizeof(digits) - i);
+}
+
+/* Nom de fichier dans une page HTML ou une chaîne JSON : un upload peut s'appeler
+	"<script>.txt" ou contenir des guillemets */
+static void	appendEscaped(std::string &out, const std::string &str, bool json)
+{
+	size_t	plain = 0;
+
+	for (size_t i = 0; i < str.size(); ++i)
+	{
+		unsigned char	c = str[i];
+		const char		*escaped = NULL;
+		char			control[7];
+
+		if (json && (c == '"' || c == '\\'))
+			escaped = (c == '"') ? "\\\"" : "\\\\";
+		else if (json && c < 0x20)
+		{
+			control[0] = '\\';
+			control[1] = 'u';
+			control[2] = '0';
+			control[3] = '0';
+			control[4] = "0123456789abcdef"[c >> 4];
+			control[5] = "0123456789abcdef"[c & 15];
+			control[6] = '\0';
+			escaped = control;
+		}
+		else if (!json && (c == '<' || c == '>' || c == '&' || c == '"'))
+			escaped = (c == '<') ? "&lt;" : (c == '>') ? "&gt;" : (c == '&') ? "&amp;" : "&quot;";
+		if (!escaped)
+			continue ;
+		out.append(str, plain, i - plain);
+		out.append(escaped);
+		plain = i + 1;
+	}
+	out.append(str, plain, std::string::npos);
+}
+
+/* Une ligne du tableau (lien, date de modification, taille vide pour un dossier)
+	ou un objet JSON, depuis l'entrée en cache : ni stat() ni ctime() par requête */
+void	DirectorySource::appendEntry(std::string &out, const DirectoryEntry &entry)
+{
+	if (_view.json)
+	{
+		out.append(_next == _first ? "\n{\"name\":\"" : ",\n{\"name\":\"");
+		appendEscaped(out, entry.name, true);
+		out.append(entry.is_dir ? "\",\"type\":\"directory\",\"mtime\":" : "\",\"type\":\"file\",\"mtime\":");
+		appendNumber(out, entry.mtime);
+		if (!entry.is_dir)
+		{
+			out.append(",\"size\":");
+			appendNumber(out, entry.size);
+		}
+		out.append("}");
+		return ;
+	}
+	const char *slash = entry.is_dir ? "/" : "";
+
+	out.append("<tr>\n<td>\n<a href=\"");
+	appendEscaped(out, entry.name, false);
+	out.append(slash);
+	out.append("\">");
+	appendEscaped(out, entry.name, false);
+	out.append(slash);
+	out.append("</a>\n</td>\n<td>\n");
+	out.append(entry.modified);
+	out.append("</td>\n<td>\n");
+	if (!entry.is_dir)
+		appendNumber(out, entry.size);
+	out.append("</td>\n</tr>\n");
+}
+
+void	DirectorySource::appendHead(std::string &out)
+{
+	if (_view.json)
+	{
+		out.append("{\"path\":\"");
+		appendEscaped(out, _uri, true);
+		out.append("\",\"total\":");
+		appendNumber(out, _listing->entries.size());
+		out.append(",\"page\":");
+		appendNumber(out, _view.page);
+		out.append(",\"pages\":");
+		appendNumber(out, _pages);
+		out.append(",\"entries\":[");
+		return ;
+	}
+	out.append("<html>\n<head>\n<title> Index of");
+	appendEscaped(out, _dir_name, false);
+	out.append("</title>\n</head>\n<body >\n<h1> Index of ");
+	appendEscaped(out, _dir_name, false);
+	out.append("</h1>\n");
+	if (_view.page_size)
+	{
+		out.append("<p> Page ");
+		appendNumber(out, _view.page);
+		out.append(" / ");
+		appendNumber(out, _pages);
+		out.append(" (");
+		appendNumber(out, _listing->entries.size());
+		out.append(" entries) </p>\n");
+	}
+	out.append("<table style=\"width:80%; font-size: 15px\">\n<hr>\n"
+		"<th style=\"text-align:left\"> File Name </th>\n"
+		"<th style=\"text-align:left\"> Last Modification  </th>\n"
+		"<th style=\"text-align:left\"> File Size </th>\n");
+}
+
+/* Pied de page ; liens relatifs vers les pages voisines ("?page=3") */
+void	DirectorySource::appendTail(std::string &out)
+{
+	if (_view.json)
+	{
+		out.append("\n]}\n");
+		return ;
+	}
+	out.append("</table>\n<hr>\n");
+	if (_view.page > 1 && _view.page <= _pages)
+	{
+		out.append("<a href=\"?page=");
+		appendNumber(out, _view.page - 1);
+		out.append("\">&laquo; previous</a>\n");
+	}
+	if (_view.page < _pages)
+	{
+		out.append("<a href=\"?page=");
+		appendNumber(out, _view.page + 1);
+		out.append("\">next &raquo;</a>\n");
+	}
+	out.append("</body>\n</html>\n");
+}
+
+/* Produit l'en-tête, puis les entrées de la page jusqu'à remplir max octets
+	(approximativement : une entrée n'est jamais coupée), puis le pied de page */
+BodySource::Status	DirectorySource::pull(std::string &out, size_t max)
+{
+	size_t	start = out.size();
+
+	if (_listing == NULL)
+		return (BODY_ERROR);
+	if (_state == 0)
+	{
+		appendHead(out);
+		_state = 1;
+	}
+	while (_state == 1 && out.size() - start < max)
+	{
+		if (_next == _end)
+		{
+			appendTail(out);
+			_state = 2;
+			break ;
+		}
+		appendEntry(out, _listing->entries[_next]);
+		++_next;
+	}
+	if (_state == 2)
+		return (BODY_END);
+	return (BODY_DATA);
+}
+
+/* ----------------------------- StreamSource ----------------------------- */
+
+StreamSource::StreamSource() : _offset(0), _finished(false), _pulled(false) {}
+
+void	StreamSource::append(const char *data, size_t len)
+{
+	_data.append(data, len);
+}
+
+void	StreamSource::finish()
+{
+	_finished = true;
+}
+
+size_t	StreamSource::buffered() const
+{
+	return (_data.size() - _offset);
+}
+
+bool	StreamSource::finished() const
+{
+	return (_finished);
+}
+
+bool	StreamSource::pulled() const
+{
+	return (_pulled);
+}
+
+/* Position de pattern parmi les octets pas encore tirés (npos si absent) */
+size_t	StreamSource::find(const char *pattern) const
+{
+	size_t	pos = _data.find(pattern, _offset);
+
+	return (pos == std::string::npos ? pos : pos - _offset);
+}
+
+/* Donne au plus max octets. La partie déjà tirée est effacée quand elle dépasse
+	la moitié du tampon : la mémoire reste bornée par ce que le producteur a ajouté */
+BodySource::Status	StreamSource::pull(std::string &out, size_t max)
+{
+	size_t	len = buffered();
+
+	if (len == 0)
+		return (_finished ? BODY_END : BODY_AGAIN);
+	if (len > max)
+		len = max;
+	out.append(_data, _offset, len);
+	_offset += len;
+	_pulled = true;
+	if (_offset == _data.size())
+	{
+		_data.clear();
+		_offset = 0;
+	}
+	else if (_offset * 2 >= _data.size())
+	{
+		_data.erase(0, _offset);
+		_offset = 0;
+	}
+	if (_finished && buffered() == 0)
+		return (BODY_END);
+	return (BODY_DATA);
+}
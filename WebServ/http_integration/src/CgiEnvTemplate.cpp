@@ -0,0 +1,55 @@
+#include "CgiEnvTemplate.hpp"
+#include "Webserv.hpp"
+
+CgiEnvTemplate::CgiEnvTemplate()
+{
+}
+
+void	CgiEnvTemplate::add(const std::string &entry)
+{
+	_offsets.push_back(_block.size());
+	_block.append(entry);
+	_block.push_back('\0');
+}
+
+/* Variables identiques pour toutes les requêtes de la location, puis les interpréteurs */
+void	CgiEnvTemplate::build(const std::string &root, const std::map<std::string, std::string> &interpreters)
+{
+	_block.clear();
+	_offsets.clear();
+	_interpreters.clear();
+	add("AUTH_TYPE=Basic");
+	add("GATEWAY_INTERFACE=CGI/1.1");
+	add("DOCUMENT_ROOT=" + root);
+	add("SERVER_PROTOCOL=HTTP/1.1");
+	add("REDIRECT_STATUS=200");
+	add("SERVER_SOFTWARE=LETSGO");
+	for (std::map<std::string, std::string>::const_iterator it = interpreters.begin(); it != interpreters.end(); ++it)
+	{
+		_interpreters[it->first] = _block.size();
+		_block.append(it->second);
+		_block.push_back('\0');
+	}
+}
+
+/* Une seule allocation dans l'arène : le tableau envp (variables fixes + dynamic
+	places libres + NULL), suivi de la copie du bloc. Les variables fixes pointent
+	dans la copie ; interpreter aussi, NULL si l'extension n'a pas d'interpréteur */
+char	**CgiEnvTemplate::instantiate(Arena &arena, size_t dynamic, const std::string &extension, char *&interpreter) const
+{
+	size_t	slots = _offsets.size() + dynamic + 1;
+	char	**envp = static_cast<char **>(arena.alloc(slots * sizeof(char *) + _block.size()));
+	char	*copy = reinterpret_cast<char *>(envp + slots);
+
+	memcpy(copy, _block.data(), _block.size());
+	for (size_t i = 0; i < _offsets.size(); ++i)
+		envp[i] = copy + _offsets[i];
+	std::map<std::string, size_t>::const_iterator it = _interpreters.find(extension);
+	interpreter = (it == _interpreters.end() ? NULL : copy + it->second);
+	return (envp);
+}
+
+size_t	CgiEnvTemplate::count() const
+{
+	return (_offsets.size());
+}
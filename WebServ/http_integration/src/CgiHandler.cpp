@@ -19,6 +19,12 @@ CgiHandler::CgiHandler() {
 	this->_cgi_path = "";
 	this->_ch_env = NULL;
 	this->_argv = NULL;
+	this->_pool_size = 0;
+	this->_pool_max_requests = 0;
+	this->pipe_in[0] = -1;
+	this->pipe_in[1] = -1;
+	this->pipe_out[0] = -1;
+	this->pipe_out[1] = -1;
 }
 
 CgiHandler::CgiHandler(std::string path)
@@ -28,45 +34,48 @@ CgiHandler::CgiHandler(std::string path)
 	this->_cgi_path = path;
 	this->_ch_env = NULL;
 	this->_argv = NULL;
+	this->_pool_size = 0;
+	this->_pool_max_requests = 0;
+	this->pipe_in[0] = -1;
+	this->pipe_in[1] = -1;
+	this->pipe_out[0] = -1;
+	this->pipe_out[1] = -1;
 }
 
+/* _ch_env et _argv sont dans _arena : libérés avec elle */
 CgiHandler::~CgiHandler() {
-
-	if (this->_ch_env)
-	{
-		for (int i = 0; this->_ch_env[i]; i++)
-			free(this->_ch_env[i]);
-		free(this->_ch_env);
-	}
-	if (this->_argv)
-	{
-		for (int i = 0; this->_argv[i]; i++)
-			free(_argv[i]);
-		free(_argv);
-	}
-	this->_env.clear();
 }
 
 CgiHandler::CgiHandler(const CgiHandler &other)
 {
-		this->_env = other._env;
-		this->_ch_env = other._ch_env;
-		this->_argv = other._argv;
+		this->_ch_env = NULL;				// bloc d'environnement propre à l'arène de other
+		this->_argv = NULL;
 		this->_cgi_path = other._cgi_path;
 		this->_cgi_pid = other._cgi_pid;
 		this->_exit_status = other._exit_status;
+		this->_pool_size = other._pool_size;
+		this->_pool_max_requests = other._pool_max_requests;
+		this->pipe_in[0] = other.pipe_in[0];
+		this->pipe_in[1] = other.pipe_in[1];
+		this->pipe_out[0] = other.pipe_out[0];
+		this->pipe_out[1] = other.pipe_out[1];
 }
 
 CgiHandler &CgiHandler::operator=(const CgiHandler &rhs)
 {
     if (this != &rhs)
 	{
-		this->_env = rhs._env;
-		this->_ch_env = rhs._ch_env;
-		this->_argv = rhs._argv;
+		this->_ch_env = NULL;
+		this->_argv = NULL;
 		this->_cgi_path = rhs._cgi_path;
 		this->_cgi_pid = rhs._cgi_pid;
 		this->_exit_status = rhs._exit_status;
+		this->_pool_size = rhs._pool_size;
+		this->_pool_max_requests = rhs._pool_max_requests;
+		this->pipe_in[0] = rhs.pipe_in[0];
+		this->pipe_in[1] = rhs.pipe_in[1];
+		this->pipe_out[0] = rhs.pipe_out[0];
+		this->pipe_out[1] = rhs.pipe_out[1];
 	}
 	return (*this);
 }
@@ -83,9 +92,10 @@ void CgiHandler::setCgiPath(const std::string &cgi_path)
 }
 
 /* Get functions */
-const std::map<std::string, std::string> &CgiHandler::getEnv() const
+/* envp du script, "NOM=valeur", terminé par NULL */
+char *const *CgiHandler::getEnv() const
 {
-    return (this->_env);
+    return (this->_ch_env);
 }
 
 const pid_t &CgiHandler::getCgiPid() const
@@ -98,9 +108,57 @@ const std::string &CgiHandler::getCgiPath() const
     return (this->_cgi_path);
 }
 
-void CgiHandler::initEnvCgi(HttpRequest& req, const std::vector<Location>::iterator it_loc)
+/* Chemin de l'interpréteur (argv[0]), clé du pool : "/usr/bin/python3" */
+std::string CgiHandler::getInterpreter() const
+{
+	return (this->_argv && this->_argv[0] ? std::string(this->_argv[0]) : std::string());
+}
+
+bool CgiHandler::pooled() const
+{
+	return (this->_pool_size > 0);
+}
+
+size_t CgiHandler::getPoolSize() const
+{
+	return (this->_pool_size);
+}
+
+size_t CgiHandler::getPoolMaxRequests() const
+{
+	return (this->_pool_max_requests);
+}
+
+/* Pas de fork ici : ServerManager confie la requête à un interpréteur du pool */
+void CgiHandler::usePool(size_t size, size_t max_requests)
+{
+	this->_pool_size = size;
+	this->_pool_max_requests = max_requests;
+}
+
+/* "HTTP_<NOM>=valeur" d'un en-tête, écrit directement dans l'arène :
+	majuscules et '-' → '_' (RFC 3875), "user-agent" → "HTTP_USER_AGENT" */
+static char *headerVariable(Arena &arena, const std::string &name, const std::string &value)
 {
-	std::string cgi_exec = ("cgi-bin/" + it_loc->getCgiPath()[0]).c_str();
+	char	*dst = static_cast<char *>(arena.alloc(5 + name.size() + value.size() + 2));
+	char	*p = dst;
+
+	memcpy(p, "HTTP_", 5);
+	p += 5;
+	for (size_t i = 0; i < name.size(); ++i)
+		*p++ = (name[i] == '-' ? '_' : std::toupper(static_cast<unsigned char>(name[i])));
+	*p++ = '=';
+	memcpy(p, value.data(), value.size());
+	p[value.size()] = '\0';
+	return (dst);
+}
+
+/* Variables propres à la requête, en plus de la partie fixe de la location (CgiEnvTemplate) */
+#define CGI_ENV_DYNAMIC 13
+
+void CgiHandler::initEnvCgi(HttpRequest& req, const Location &location)
+{
+	std::string cgi_exec = "cgi-bin/" + location.getCgiPath()[0];
 	char    *cwd = getcwd(NULL, 0);
 	if(_cgi_path[0] != '/')
 	{
@@ -109,102 +167,89 @@ void CgiHandler::initEnvCgi(HttpRequest& req, const std::vector<Location>::itera
 		if(_cgi_path.length() > 0)
 			_cgi_path.insert(0, tmp);
 	}
+	free(cwd);
+
+	const std::map<std::string, std::string> &request_headers = req.getHeaders();
+	char	*interpreter;
+	size_t	n = location.getCgiEnv().count();
+
+	this->_ch_env = location.getCgiEnv().instantiate(this->_arena, CGI_ENV_DYNAMIC + request_headers.size(), "", interpreter);
 	if(req.getMethod() == POST)
 	{
-		std::stringstream out;
-		out << req.getBody().length();
-		this->_env["CONTENT_LENGTH"] = out.str();
-		this->_env["CONTENT_TYPE"] = req.getHeader("content-type");
+		this->_ch_env[n++] = this->_arena.join("CONTENT_LENGTH", '=', toString(req.getBody().size()));
+		this->_ch_env[n++] = this->_arena.join("CONTENT_TYPE", '=', req.getHeader("content-type"));
 	}
-
-    this->_env["GATEWAY_INTERFACE"] = std::string("CGI/1.1");
-	this->_env["SCRIPT_NAME"] = cgi_exec;//
-    this->_env["SCRIPT_FILENAME"] = this->_cgi_path;
-    this->_env["PATH_INFO"] = this->_cgi_path;//
-    this->_env["PATH_TRANSLATED"] = this->_cgi_path;//
-    this->_env["REQUEST_URI"] = this->_cgi_path;//
-    this->_env["SERVER_NAME"] = req.getHeader("host");
-    this->_env["SERVER_PORT"] ="8002";
-    this->_env["REQUEST_METHOD"] = req.getMethodStr();
-    this->_env["SERVER_PROTOCOL"] = "HTTP/1.1";
-    this->_env["REDIRECT_STATUS"] = "200";
-	this->_env["SERVER_SOFTWARE"] = "LETSGO";
-
-	std::map<std::string, std::string> request_headers = req.getHeaders();
-	for(std::map<std::string, std::string>::iterator it = request_headers.begin();
+	this->_ch_env[n++] = this->_arena.join("SCRIPT_NAME", '=', cgi_exec);
+	this->_ch_env[n++] = this->_arena.join("SCRIPT_FILENAME", '=', this->_cgi_path);
+	this->_ch_env[n++] = this->_arena.join("PATH_INFO", '=', this->_cgi_path);
+	this->_ch_env[n++] = this->_arena.join("PATH_TRANSLATED", '=', this->_cgi_path);
+	this->_ch_env[n++] = this->_arena.join("REQUEST_URI", '=', this->_cgi_path);
+	this->_ch_env[n++] = this->_arena.join("SERVER_NAME", '=', req.getHeader("host"));
+	this->_ch_env[n++] = this->_arena.join("SERVER_PORT", '=', "8002");
+	this->_ch_env[n++] = this->_arena.join("REQUEST_METHOD", '=', req.getMethodStr());
+
+	for(std::map<std::string, std::string>::const_iterator it = request_headers.begin();
 		it != request_headers.end(); ++it)
-	{
-		std::string name = it->first;
-		std::transform(name.begin(), name.end(), name.begin(), ::toupper);
-		std::string key = "HTTP_" + name;
-		_env[key] = it->second;
-	}
-	this->_ch_env =  (char **)calloc(this->_env.size() + 1, sizeof(char *));
-	std::map<std::string, std::string>::const_iterator it = this->_env.begin();
-	for (int i = 0; it != this->_env.end(); it++, i++)
-	{
-		std::string tmp = it->first + "=" + it->second;
-		this->_ch_env[i] = strdup(tmp.c_str());
-	}
-	this->_argv = (char **)malloc(sizeof(char *) * 3);
-	this->_argv[0] = strdup(cgi_exec.c_str());
-	this->_argv[1] = strdup(this->_cgi_path.c_str());
-	this->_argv[2] = NULL;
+		this->_ch_env[n++] = headerVariable(this->_arena, it->first, it->second);
+	this->_ch_env[n] = NULL;
+	buildArgv(this->_arena.copy(cgi_exec));
 }
 
 
-/* initialisation des variables d'environnement */
-void CgiHandler::initEnv(HttpRequest& req, const std::vector<Location>::iterator it_loc)
+/* initialisation des variables d'environnement
+	La partie fixe (DOCUMENT_ROOT, GATEWAY_INTERFACE, interpréteur...) vient de la
+	location, copiée d'un bloc ; seules les variables de la requête sont écrites ici */
+void CgiHandler::initEnv(HttpRequest& req, const Location &location)
 {
 	int			poz;
-	std::string extension;
-	std::string ext_path;
-
-	extension = this->_cgi_path.substr(this->_cgi_path.find("."));
-	std::map<std::string, std::string>::iterator it_path = it_loc->_ext_path.find(extension);
-    if (it_path == it_loc->_ext_path.end())
-        return ;
-    ext_path = it_loc->_ext_path[extension];
-
-	this->_env["AUTH_TYPE"] = "Basic";
-	this->_env["CONTENT_LENGTH"] = req.getHeader("content-length");
-	this->_env["CONTENT_TYPE"] = req.getHeader("content-type");
-    this->_env["GATEWAY_INTERFACE"] = "CGI/1.1";
-	poz = findStart(this->_cgi_path, "cgi-bin/");
-	this->_env["SCRIPT_NAME"] = this->_cgi_path;
-    this->_env["SCRIPT_FILENAME"] = ((poz < 0 || (size_t)(poz + 8) > this->_cgi_path.size()) ? "" : this->_cgi_path.substr(poz + 8, this->_cgi_path.size())); // check dif cases after put right parametr from the response
-    this->_env["PATH_INFO"] = getPathInfo(req.getPath(), it_loc->getCgiExtension());
-    this->_env["PATH_TRANSLATED"] = it_loc->getRootLocation() + (this->_env["PATH_INFO"] == "" ? "/" : this->_env["PATH_INFO"]);
-    this->_env["QUERY_STRING"] = decode(req.getQuery());
-    this->_env["REMOTE_ADDR"] = req.getHeader("host");
-	poz = findStart(req.getHeader("host"), ":");
-    this->_env["SERVER_NAME"] = (poz > 0 ? req.getHeader("host").substr(0, poz) : "");
-    this->_env["SERVER_PORT"] = (poz > 0 ? req.getHeader("host").substr(poz + 1, req.getHeader("host").size()) : "");
-    this->_env["REQUEST_METHOD"] = req.getMethodStr();
-    this->_env["HTTP_COOKIE"] = req.getHeader("cookie");
-    this->_env["DOCUMENT_ROOT"] = it_loc->getRootLocation();
-	this->_env["REQUEST_URI"] = req.getPath() + req.getQuery();
-    this->_env["SERVER_PROTOCOL"] = "HTTP/1.1";
-    this->_env["REDIRECT_STATUS"] = "200";
-	this->_env["SERVER_SOFTWARE"] = "LETSGO";
-
-	this->_ch_env =  (char **)calloc(this->_env.size() + 1, sizeof(char *));
-	std::map<std::string, std::string>::const_iterator it = this->_env.begin();
-	for (int i = 0; it != this->_env.end(); it++, i++)
+	std::string	host = req.getHeader("host");
+	std::string	path_info;
+	char		*interpreter;
+	size_t		n = location.getCgiEnv().count();
+
+	this->_ch_env = location.getCgiEnv().instantiate(this->_arena, CGI_ENV_DYNAMIC,
+		this->_cgi_path.substr(this->_cgi_path.find(".")), interpreter);
+	if (interpreter == NULL)
 	{
-		std::string tmp = it->first + "=" + it->second;
-		this->_ch_env[i] = strdup(tmp.c_str());
+		this->_ch_env = NULL;
+		return ;
 	}
-	this->_argv = (char **)malloc(sizeof(char *) * 3);
-	this->_argv[0] = strdup(ext_path.c_str());
-	this->_argv[1] = strdup(this->_cgi_path.c_str());
+
+	this->_ch_env[n++] = this->_arena.join("CONTENT_LENGTH", '=', req.getHeader("content-length"));
+	this->_ch_env[n++] = this->_arena.join("CONTENT_TYPE", '=', req.getHeader("content-type"));
+	poz = findStart(this->_cgi_path, "cgi-bin/");
+	this->_ch_env[n++] = this->_arena.join("SCRIPT_NAME", '=', this->_cgi_path);
+	this->_ch_env[n++] = this->_arena.join("SCRIPT_FILENAME", '=', ((poz < 0 || (size_t)(poz + 8) > this->_cgi_path.size()) ? std::string() : this->_cgi_path.substr(poz + 8))); // check dif cases after put right parametr from the response
+	path_info = getPathInfo(req.getPath(), location.getCgiExtension());
+	this->_ch_env[n++] = this->_arena.join("PATH_INFO", '=', path_info);
+	this->_ch_env[n++] = this->_arena.join("PATH_TRANSLATED", '=', location.getRootLocation() + (path_info.empty() ? "/" : path_info));
+	this->_ch_env[n++] = this->_arena.join("QUERY_STRING", '=', decode(req.getQuery()));
+	this->_ch_env[n++] = this->_arena.join("REMOTE_ADDR", '=', host);
+	poz = findStart(host, ":");
+	this->_ch_env[n++] = this->_arena.join("SERVER_NAME", '=', (poz > 0 ? host.substr(0, poz) : std::string()));
+	this->_ch_env[n++] = this->_arena.join("SERVER_PORT", '=', (poz > 0 ? host.substr(poz + 1) : std::string()));
+	this->_ch_env[n++] = this->_arena.join("REQUEST_METHOD", '=', req.getMethodStr());
+	this->_ch_env[n++] = this->_arena.join("HTTP_COOKIE", '=', req.getHeader("cookie"));
+	this->_ch_env[n++] = this->_arena.join("REQUEST_URI", '=', req.getPath() + req.getQuery());
+	this->_ch_env[n] = NULL;
+
+	buildArgv(interpreter);
+}
+
+/* argv pour execve() : l'interpréteur et le script, dans _arena avec envp,
+	rendus d'un coup par clear() */
+void CgiHandler::buildArgv(const char *exec)
+{
+	this->_argv = static_cast<char **>(this->_arena.alloc(sizeof(char *) * 3));
+	this->_argv[0] = const_cast<char *>(exec);
+	this->_argv[1] = this->_arena.copy(this->_cgi_path);
 	this->_argv[2] = NULL;
 }
 
 /* Pipe et exécution du CGI */
 void CgiHandler::execute(short &error_code)
 {
-	if (this->_argv[0] == NULL || this->_argv[1] == NULL)
+	if (this->_argv == NULL || this->_argv[0] == NULL || this->_argv[1] == NULL)
 	{
 		error_code = 500;
 		return ;
@@ -225,9 +270,18 @@ void CgiHandler::execute(short &error_code)
 		error_code = 500;
 		return ;
 	}
+	// Pas hérités par les autres enfants (interpréteurs du pool) : sinon l'EOF n'arrive jamais
+	fcntl(pipe_in[0], F_SETFD, FD_CLOEXEC);
+	fcntl(pipe_in[1], F_SETFD, FD_CLOEXEC);
+	fcntl(pipe_out[0], F_SETFD, FD_CLOEXEC);
+	fcntl(pipe_out[1], F_SETFD, FD_CLOEXEC);
+	sigset_t no_signals;
+	sigemptyset(&no_signals);
 	this->_cgi_pid = fork();
 	if (this->_cgi_pid == 0)
 	{
+		// Le serveur bloque SIGCHLD (signalfd) : le script repart d'un masque vide
+		sigprocmask(SIG_SETMASK, &no_signals, NULL);
 		dup2(pipe_in[0], STDIN_FILENO);
 		dup2(pipe_out[1], STDOUT_FILENO);
 		close(pipe_in[0]);
@@ -332,5 +386,11 @@ void		CgiHandler::clear()
 	this->_cgi_path = "";
 	this->_ch_env = NULL;
 	this->_argv = NULL;
-	this->_env.clear();
+	this->_arena.reset();
+	this->_pool_size = 0;
+	this->_pool_max_requests = 0;
+	this->pipe_in[0] = -1;
+	this->pipe_in[1] = -1;
+	this->pipe_out[0] = -1;
+	this->pipe_out[1] = -1;
 }
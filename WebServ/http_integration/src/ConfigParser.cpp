@@ -232,6 +232,16 @@ void ConfigParser::createServer(std::string &config, ServerConfig &server)
 	int		flag_loc = 1;						// : Indique si les directives doivent être lues avant une section location (1 = avant, 0 = après).
 	bool	flag_autoindex = false;
 	bool	flag_max_size = false;
+	bool	flag_output_buffer = false;
+	bool	flag_cgi_max_output = false;
+	bool	flag_body_buffer = false;
+	bool	flag_body_temp_path = false;
+	bool	flag_status_page = false;
+	bool	flag_aio_threads = false;
+	bool	flag_timeouts[TIMEOUT_PHASES] = {false, false, false, false, false};
+	bool	flag_socket_options[SOCKET_OPTIONS] = {false, false, false, false, false, false};
+	int		timeout;
+	int		socket_option;
 
 	parametrs = splitParametrs(config += ' ', std::string(" \n\t"));	// Split en tocken dans parametrs , un espace est ajouté à config pour s'assurer que le dernier token est bien traité.
 	if (parametrs.size() < 3)
@@ -298,6 +308,62 @@ void ConfigParser::createServer(std::string &config, ServerConfig &server)
 			server.setClientMaxBodySize(parametrs[++i]);
 			flag_max_size = true;
 		}
+		else if (parametrs[i] == "output_buffer_size" && (i + 1) < parametrs.size() && flag_loc)
+		{
+			if (flag_output_buffer)
+				throw  ErrorException("Output_buffer_size is duplicated");
+			server.setOutputBufferSize(parametrs[++i]);
+			flag_output_buffer = true;
+		}
+		else if (parametrs[i] == "cgi_max_output" && (i + 1) < parametrs.size() && flag_loc)
+		{
+			if (flag_cgi_max_output)
+				throw  ErrorException("Cgi_max_output is duplicated");
+			server.setCgiMaxOutput(parametrs[++i]);
+			flag_cgi_max_output = true;
+		}
+		else if (parametrs[i] == "client_body_buffer_size" && (i + 1) < parametrs.size() && flag_loc)
+		{
+			if (flag_body_buffer)
+				throw  ErrorException("Client_body_buffer_size is duplicated");
+			server.setClientBodyBufferSize(parametrs[++i]);
+			flag_body_buffer = true;
+		}
+		else if (parametrs[i] == "client_body_temp_path" && (i + 1) < parametrs.size() && flag_loc)
+		{
+			if (flag_body_temp_path)
+				throw  ErrorException("Client_body_temp_path is duplicated");
+			server.setClientBodyTempPath(parametrs[++i]);
+			flag_body_temp_path = true;
+		}
+		else if ((timeout = ServerConfig::timeoutDirective(parametrs[i])) >= 0 && (i + 1) < parametrs.size() && flag_loc)
+		{
+			if (flag_timeouts[timeout])
+				throw  ErrorException(parametrs[i] + " is duplicated");
+			server.setTimeout(static_cast<TimeoutPhase>(timeout), parametrs[++i]);
+			flag_timeouts[timeout] = true;
+		}
+		else if ((socket_option = ServerConfig::socketOptionDirective(parametrs[i])) >= 0 && (i + 1) < parametrs.size() && flag_loc)
+		{
+			if (flag_socket_options[socket_option])
+				throw  ErrorException(parametrs[i] + " is duplicated");
+			server.setSocketOption(static_cast<SocketOption>(socket_option), parametrs[++i]);
+			flag_socket_options[socket_option] = true;
+		}
+		else if (parametrs[i] == "aio_threads" && (i + 1) < parametrs.size() && flag_loc)
+		{
+			if (flag_aio_threads)
+				throw  ErrorException("Aio_threads is duplicated");
+			server.setAioThreads(parametrs[++i]);
+			flag_aio_threads = true;
+		}
+		else if (parametrs[i] == "status_page" && (i + 1) < parametrs.size() && flag_loc)
+		{
+			if (flag_status_page)
+				throw  ErrorException("Status_page is duplicated");
+			server.setStatusPage(parametrs[++i]);
+			flag_status_page = true;
+		}
 		else if (parametrs[i] == "server_name" && (i + 1) < parametrs.size() && flag_loc) // similaires à listen
 		{
 			if (!server.getServerName().empty())
@@ -0,0 +1,221 @@
+#include "DirectoryCache.hpp"
+#include <dirent.h>
+#include <algorithm>
+
+DirectoryCache::DirectoryCache(size_t max_listings, size_t max_entries)
+	: _max_listings(max_listings), _max_entries(max_entries), _count(0)
+{
+	pthread_mutex_init(&_lock, NULL);
+}
+
+DirectoryCache::~DirectoryCache()
+{
+	for (std::map<std::string, CachedListing *>::iterator it = _listings.begin(); it != _listings.end(); ++it)
+		delete it->second;
+	for (std::set<CachedListing *>::iterator it = _retired.begin(); it != _retired.end(); ++it)
+		delete *it;
+	pthread_mutex_destroy(&_lock);
+}
+
+/* Renvoie le listing à jour du dossier path, épinglé, NULL si le dossier est illisible
+	1 stat() du dossier
+	2 si le listing en cache correspond (même inode, même mtime, lu après la
+	  dernière modification, depuis moins de DIRECTORY_CACHE_VALID s) -> réutilisé
+	3 sinon le dossier est relu hors verrou, l'ancien listing est retiré
+	L'appelant rend le listing avec release() ; jusque-là il reste valable. */
+const CachedListing *DirectoryCache::acquire(const std::string &path)
+{
+	struct stat st;
+	time_t		now = time(NULL);
+
+	if (stat(path.c_str(), &st) != 0 || !S_ISDIR(st.st_mode))
+		return (NULL);
+
+	pthread_mutex_lock(&_lock);
+	CachedListing *l = pin(path, st, now);
+	pthread_mutex_unlock(&_lock);
+	if (l)
+		return (l);
+
+	l = new CachedListing();
+	l->mtime = st.st_mtime;
+	l->ino = st.st_ino;
+	l->dev = st.st_dev;
+	l->scanned = now;
+	l->refs = 1;
+	l->retired = false;
+	if (!scan(path, *l))
+	{
+		delete l;
+		return (NULL);
+	}
+	pthread_mutex_lock(&_lock);
+	l = insert(path, l, now);
+	pthread_mutex_unlock(&_lock);
+	return (l);
+}
+
+/* Le listing décrit toujours le dossier vu par st ?
+	Modifié dans la seconde même de la lecture, le mtime ne dit plus rien : relu */
+bool DirectoryCache::fresh(const CachedListing &l, const struct stat &st, time_t now)
+{
+	return (l.ino == st.st_ino && l.dev == st.st_dev && l.mtime == st.st_mtime
+		&& l.mtime < l.scanned && now - l.scanned < DIRECTORY_CACHE_VALID);
+}
+
+/* Listing en cache qui correspond à st, épinglé ; une version périmée est retirée */
+CachedListing *DirectoryCache::pin(const std::string &path, const struct stat &st, time_t now)
+{
+	std::map<std::string, CachedListing *>::iterator it = _listings.find(path);
+
+	if (it == _listings.end())
+		return (NULL);
+	CachedListing &l = *it->second;
+	if (fresh(l, st, now))
+	{
+		l.refs++;
+		touch(l);
+		return (&l);
+	}
+	drop(it);
+	return (NULL);
+}
+
+/* Ajoute l (déjà épinglé). Un autre thread a lu la même version entre-temps :
+	la sienne est gardée, l est libéré */
+CachedListing *DirectoryCache::insert(const std::string &path, CachedListing *l, time_t now)
+{
+	struct stat st;
+
+	st.st_ino = l->ino;
+	st.st_dev = l->dev;
+	st.st_mtime = l->mtime;
+	if (CachedListing *loaded = pin(path, st, now))
+	{
+		delete l;
+		return (loaded);
+	}
+	_lru.push_front(path);
+	l->lru_pos = _lru.begin();
+	_listings[path] = l;
+	_count += l->entries.size();
+	evict();
+	return (l);
+}
+
+/* ".." en tête, puis ordre des octets : un ordre stable d'une requête à l'autre,
+	nécessaire pour paginer (readdir() n'en garantit aucun) */
+static bool	byName(const std::string &a, const std::string &b)
+{
+	if (b == "..")
+		return (false);
+	if (a == "..")
+		return (true);
+	return (a < b);
+}
+
+/* readdir() de tout le dossier, tri, puis un fstatat() par entrée (sans reconstruire
+	le chemin complet) ; la date est formatée ici, une fois par version du dossier.
+	localtime_r() + asctime_r() = ctime(), sans son tampon statique : appelé
+	depuis les threads de FilePool */
+bool DirectoryCache::scan(const std::string &path, CachedListing &l)
+{
+	DIR							*dir = opendir(path.c_str());
+	struct dirent				*entity;
+	std::vector<std::string>	names;
+
+	if (dir == NULL)
+		return (false);
+	while ((entity = readdir(dir)) != NULL)
+	{
+		if (strcmp(entity->d_name, ".") != 0)
+			names.push_back(entity->d_name);
+	}
+	std::sort(names.begin(), names.end(), byName);
+	l.entries.reserve(names.size());
+	for (size_t i = 0; i < names.size(); ++i)
+	{
+		struct stat	st;
+		struct tm	tm;
+
+		if (fstatat(dirfd(dir), names[i].c_str(), &st, 0) != 0)
+			continue ;							// supprimé entre readdir() et stat()
+		l.entries.push_back(DirectoryEntry());
+		DirectoryEntry &e = l.entries.back();
+		e.name.swap(names[i]);
+		e.is_dir = S_ISDIR(st.st_mode);
+		e.size = st.st_size;
+		e.mtime = st.st_mtime;
+		if (!localtime_r(&st.st_mtime, &tm) || !asctime_r(&tm, e.modified))
+			e.modified[0] = '\0';
+	}
+	closedir(dir);
+	return (true);
+}
+
+/* Une réponse a fini d'envoyer le listing : le dernier à rendre un listing retiré le libère */
+void DirectoryCache::release(const CachedListing *listing)
+{
+	CachedListing *l = const_cast<CachedListing *>(listing);
+
+	if (!l)
+		return ;
+	pthread_mutex_lock(&_lock);
+	if (--l->refs <= 0 && l->retired)
+	{
+		_retired.erase(l);
+		delete l;
+	}
+	pthread_mutex_unlock(&_lock);
+}
+
+/* Le fichier file vient d'être écrit (POST) ou supprimé (DELETE) : le listing de son
+	dossier est retiré, même si le mtime du dossier n'a pas bougé (réécriture sur place) */
+void DirectoryCache::invalidate(const std::string &file)
+{
+	std::string	path = file.substr(0, file.find_last_of('/') + 1);
+
+	pthread_mutex_lock(&_lock);
+	std::map<std::string, CachedListing *>::iterator it = _listings.find(path);
+	if (it != _listings.end())
+		drop(it);
+	pthread_mutex_unlock(&_lock);
+}
+
+/* Sort le listing du cache ; il reste valable tant qu'une réponse l'a épinglé */
+void DirectoryCache::drop(std::map<std::string, CachedListing *>::iterator it)
+{
+	CachedListing *l = it->second;
+
+	_count -= l->entries.size();
+	_lru.erase(l->lru_pos);
+	_listings.erase(it);
+	if (l->refs > 0)
+	{
+		l->retired = true;
+		_retired.insert(l);
+	}
+	else
+		delete l;
+}
+
+/* Remet le listing en tête de la liste LRU, en O(1) */
+void DirectoryCache::touch(CachedListing &l)
+{
+	_lru.splice(_lru.begin(), _lru, l.lru_pos);
+	l.lru_pos = _lru.begin();
+}
+
+/* Borne le nombre de listings et d'entrées gardés : évince les moins récents
+	(jamais celui en tête, qui vient d'être demandé) */
+void DirectoryCache::evict()
+{
+	while ((_listings.size() > _max_listings || _count > _max_entries) && _lru.size() > 1)
+	{
+		std::map<std::string, CachedListing *>::iterator it = _listings.find(_lru.back());
+		if (it == _listings.end())
+			_lru.pop_back();
+		else
+			drop(it);
+	}
+}
@@ -0,0 +1,229 @@
+#include "FileCache.hpp"
+
+FileCache::FileCache(Mime &mime, size_t max_entries, size_t max_bytes)
+	: _mime(mime), _max_entries(max_entries), _max_bytes(max_bytes), _bytes(0)
+{
+	pthread_mutex_init(&_lock, NULL);
+}
+
+FileCache::~FileCache()
+{
+	for (std::map<std::string, CachedFile *>::iterator it = _entries.begin(); it != _entries.end(); ++it)
+		discard(it->second);
+	for (std::set<CachedFile *>::iterator it = _retired.begin(); it != _retired.end(); ++it)
+		discard(*it);
+	pthread_mutex_destroy(&_lock);
+}
+
+/* Renvoie l'entrée à jour pour path, épinglée, NULL si le fichier est inaccessible
+	1 stat() sur le chemin : remplace open() + fstat() + close() par requête
+	2 si l'entrée en cache correspond (même inode, taille, mtime à la ns) -> réutilisée
+	3 sinon le fichier est rechargé hors verrou, l'ancienne entrée est retirée
+	L'appelant rend l'entrée avec release() ; jusque-là elle (et son fd) reste valable. */
+const CachedFile *FileCache::acquire(const std::string &path)
+{
+	struct stat st;
+
+	if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+		return (NULL);
+
+	pthread_mutex_lock(&_lock);
+	CachedFile *f = pin(path, st);
+	pthread_mutex_unlock(&_lock);
+	if (f)
+		return (f);
+
+	f = new CachedFile();
+	if (!load(path, *f))
+	{
+		delete f;
+		return (NULL);
+	}
+	pthread_mutex_lock(&_lock);
+	f = insert(path, f);
+	pthread_mutex_unlock(&_lock);
+	return (f);
+}
+
+/* Entrée en cache qui correspond à st, épinglée ; une version périmée est retirée */
+CachedFile *FileCache::pin(const std::string &path, const struct stat &st)
+{
+	std::map<std::string, CachedFile *>::iterator it = _entries.find(path);
+
+	if (it == _entries.end())
+		return (NULL);
+	CachedFile &f = *it->second;
+	if (f.ino == st.st_ino && f.dev == st.st_dev && f.size == st.st_size && f.mtime == st.st_mtime
+		&& f.mtime_nsec == ST_MTIME_NSEC(st))
+	{
+		f.refs++;
+		touch(f);
+		return (&f);
+	}
+	drop(it);							// fichier modifié ou remplacé
+	return (NULL);
+}
+
+/* Ajoute f (déjà épinglée par load()). Un autre thread a chargé la même version
+	entre-temps : la sienne est gardée, f est libérée */
+CachedFile *FileCache::insert(const std::string &path, CachedFile *f)
+{
+	struct stat st;
+
+	st.st_ino = f->ino;
+	st.st_dev = f->dev;
+	st.st_size = f->size;
+	st.st_mtime = f->mtime;
+	ST_MTIME_NSEC(st) = f->mtime_nsec;
+	if (CachedFile *loaded = pin(path, st))
+	{
+		discard(f);
+		return (loaded);
+	}
+	_lru.push_front(path);
+	f->lru_pos = _lru.begin();
+	_entries[path] = f;
+	_bytes += f->content.size();
+	evict();
+	return (f);
+}
+
+/* Ouvre le fichier ; un petit fichier est lu en entier puis son fd refermé.
+	L'entrée sort épinglée pour l'appelant (refs = 1) */
+bool FileCache::load(const std::string &path, CachedFile &f)
+{
+	struct stat st;
+
+	int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return (false);
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+	{
+		close(fd);
+		return (false);
+	}
+	f.fd = fd;
+	f.size = st.st_size;
+	f.mtime = st.st_mtime;
+	f.mtime_nsec = ST_MTIME_NSEC(st);
+	f.ino = st.st_ino;
+	f.dev = st.st_dev;
+	f.refs = 1;
+	f.in_memory = false;
+	f.retired = false;
+	if (st.st_size <= FILE_CACHE_SMALL_FILE)
+	{
+		f.content.resize(st.st_size);
+		off_t done = 0;
+		while (done < st.st_size)
+		{
+			ssize_t n = pread(fd, &f.content[done], st.st_size - done, done);
+			if (n <= 0)
+				break;
+			done += n;
+		}
+		if (done == st.st_size)			// lecture complète : plus besoin du fd
+		{
+			close(fd);
+			f.fd = -1;
+			f.in_memory = true;
+		}
+		else
+			f.content.clear();
+	}
+	buildHeaders(path, f);
+	return (true);
+}
+
+/* En-têtes qui ne dépendent que du fichier : calculés une fois par version du fichier */
+void FileCache::buildHeaders(const std::string &path, CachedFile &f)
+{
+	std::stringstream	etag;
+	char				date[64];
+	struct tm			tm;
+
+	etag << "\"" << std::hex << f.mtime << "." << f.mtime_nsec << "-" << f.size << "\"";
+	f.etag = etag.str();
+	strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S GMT", gmtime_r(&f.mtime, &tm));
+	f.last_modified = date;
+	f.validators = "ETag: " + f.etag + "\r\n" + "Last-Modified: " + f.last_modified + "\r\n";
+
+	std::string type;
+	if (path.rfind(".") != std::string::npos)
+		type = _mime.getMimeType(path.substr(path.rfind(".")));
+	else
+		type = _mime.getMimeType("default");
+	f.headers = "Content-Type: " + type + "\r\n" + "Content-Length: " + toString(f.size) + "\r\n" + f.validators;
+}
+
+/* Une réponse a fini d'utiliser l'entrée : la dernière à rendre une entrée retirée la libère */
+void FileCache::release(const CachedFile *file)
+{
+	CachedFile *f = const_cast<CachedFile *>(file);
+
+	if (!f)
+		return ;
+	pthread_mutex_lock(&_lock);
+	if (--f->refs <= 0 && f->retired)
+	{
+		_retired.erase(f);
+		discard(f);
+	}
+	pthread_mutex_unlock(&_lock);
+}
+
+/* Le fichier vient d'être écrit (POST) ou supprimé (DELETE) */
+void FileCache::invalidate(const std::string &path)
+{
+	pthread_mutex_lock(&_lock);
+	std::map<std::string, CachedFile *>::iterator it = _entries.find(path);
+	if (it != _entries.end())
+		drop(it);
+	pthread_mutex_unlock(&_lock);
+}
+
+/* Sort l'entrée du cache ; elle reste valable tant qu'une réponse l'a épinglée */
+void FileCache::drop(std::map<std::string, CachedFile *>::iterator it)
+{
+	CachedFile *f = it->second;
+
+	_bytes -= f->content.size();
+	_lru.erase(f->lru_pos);
+	_entries.erase(it);
+	if (f->refs > 0)
+	{
+		f->retired = true;
+		_retired.insert(f);
+	}
+	else
+		discard(f);
+}
+
+/* Ferme le fd (gros fichier) et libère l'entrée */
+void FileCache::discard(CachedFile *f)
+{
+	if (f->fd >= 0)
+		close(f->fd);
+	delete f;
+}
+
+/* Remet l'entrée en tête de la liste LRU, en O(1) */
+void FileCache::touch(CachedFile &f)
+{
+	_lru.splice(_lru.begin(), _lru, f.lru_pos);
+	f.lru_pos = _lru.begin();
+}
+
+/* Borne le nombre d'entrées et la mémoire occupée : évince les moins récentes
+	(jamais l'entrée en tête, qui vient d'être demandée) */
+void FileCache::evict()
+{
+	while ((_entries.size() > _max_entries || _bytes > _max_bytes) && _lru.size() > 1)
+	{
+		std::map<std::string, CachedFile *>::iterator it = _entries.find(_lru.back());
+		if (it == _entries.end())
+			_lru.pop_back();
+		else
+			drop(it);
+	}
+}
@@ -0,0 +1,134 @@
+#include "HeaderWriter.hpp"
+#include "Webserv.hpp"
+
+#define STATUS_MIN 100
+#define STATUS_MAX 599
+
+/* "HTTP/1.1 <code> <raison>\r\n" pour chaque code, construit au premier appel */
+static const std::string	*statusLines()
+{
+	static std::string	lines[STATUS_MAX - STATUS_MIN + 1];
+	static bool			built = false;
+
+	if (!built)
+	{
+		for (int code = STATUS_MIN; code <= STATUS_MAX; ++code)
+			lines[code - STATUS_MIN] = "HTTP/1.1 " + toString(code) + " " + statusCodeString(code) + "\r\n";
+		built = true;
+	}
+	return (lines);
+}
+
+HeaderWriter::HeaderWriter() : _length(0), _spilled(false)
+{
+}
+
+HeaderWriter::HeaderWriter(const HeaderWriter &other) : _length(0), _spilled(false)
+{
+	append(other.data(), other.size());
+}
+
+HeaderWriter &HeaderWriter::operator=(const HeaderWriter &other)
+{
+	if (this != &other)
+	{
+		clear();
+		append(other.data(), other.size());
+	}
+	return (*this);
+}
+
+void	HeaderWriter::clear()
+{
+	_length = 0;
+	_spilled = false;
+	_spill.clear();
+}
+
+/* Tampon fixe plein : tout passe dans _spill, qui garde la suite */
+HeaderWriter	&HeaderWriter::append(const char *str, size_t len)
+{
+	if (!_spilled && _length + len > RESPONSE_HEAD_BUFFER)
+	{
+		_spill.assign(_fixed, _length);
+		_spilled = true;
+	}
+	if (_spilled)
+		_spill.append(str, len);
+	else
+	{
+		memcpy(_fixed + _length, str, len);
+		_length += len;
+	}
+	return (*this);
+}
+
+HeaderWriter	&HeaderWriter::append(const char *str)
+{
+	return (append(str, strlen(str)));
+}
+
+HeaderWriter	&HeaderWriter::append(const std::string &str)
+{
+	return (append(str.data(), str.size()));
+}
+
+HeaderWriter	&HeaderWriter::number(uint64_t value)
+{
+	char	digits[20];
+	size_t	i = sizeof(digits);
+
+	do
+	{
+		digits[--i] = '0' + value % 10;
+		value /= 10;
+	} while (value);
+	return (append(digits + i, sizeof(digits) - i));
+}
+
+HeaderWriter	&HeaderWriter::crlf()
+{
+	return (append("\r\n", 2));
+}
+
+/* Code hors 100-599 (statut d'un CGI déjà filtré) : ligne construite à la volée */
+HeaderWriter	&HeaderWriter::statusLine(short code)
+{
+	if (code < STATUS_MIN || code > STATUS_MAX)
+		return (append("HTTP/1.1 ").number(code).append(" ").append(statusCodeString(code)).crlf());
+	return (append(statusLines()[code - STATUS_MIN]));
+}
+
+/* "Date: Tue, 14 Oct 2025 09:12:03 GMT\r\n", gmtime() + strftime() une fois par seconde */
+HeaderWriter	&HeaderWriter::date()
+{
+	static char		line[64];
+	static size_t	length = 0;
+	static time_t	formatted = (time_t)-1;
+	time_t			now = time(NULL);
+
+	if (now != formatted)
+	{
+		struct tm	tm;
+
+		gmtime_r(&now, &tm);
+		length = strftime(line, sizeof(line), "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", &tm);
+		formatted = now;
+	}
+	return (append(line, length));
+}
+
+const char	*HeaderWriter::data() const
+{
+	return (_spilled ? _spill.data() : _fixed);
+}
+
+size_t	HeaderWriter::size() const
+{
+	return (_spilled ? _spill.size() : _length);
+}
+
+bool	HeaderWriter::empty() const
+{
+	return (size() == 0);
+}
@@ -9,7 +9,6 @@ HttpRequest::HttpRequest()
     _path = "";
     _query = "";
     _fragment = "";
-    _body_str = "";
     _error_code = 0;
     _chunk_length = 0;
     _method = NONE;
@@ -20,10 +19,16 @@ HttpRequest::HttpRequest()
     _body_done_flag = false;
     _chunked_flag = false;
     _body_length = 0;
+    _body_received = 0;
+    _upload = NULL;
+    _max_body_size = MAX_CONTENT_LENGTH;
     _storage = "";
     _key_storage = "";
     _multiform_flag = false;
+    _headers_built = false;
     _boundary = "";
+    _ver_major = 0;
+    _ver_minor = 0;
 }
 
 HttpRequest::~HttpRequest() {}
@@ -82,13 +87,27 @@ void    toLower(std::string &str)
         str[i] = std::tolower(str[i]);
 }
 
-/* Parse la requête HTTP caractère par caractère */
-void    HttpRequest::feed(char *data, size_t size)
+/* Parse la requête HTTP caractère par caractère
+   Retourne le nombre d'octets consommés : le parsing s'arrête à la fin de la requête,
+   les octets suivants (requête pipelinée) restent dans le buffer du client.
+   Il s'arrête aussi juste après l'en-tête quand un corps suit : l'appelant peut
+   alors lui donner un MultipartParser (setUpload) avant d'en recevoir un octet */
+size_t  HttpRequest::feed(char *data, size_t size)
 {
     u_int8_t character;
     static std::stringstream s;
+    size_t i = 0;
 
-    for (size_t i = 0; i < size; ++i)
+    /* Début de requête : chemin rapide si l'en-tête est arrivé en entier */
+    if (_state == Request_Line)
+    {
+        i = _fast_parse(data, size);
+        if (i)
+            return (i);
+    }
+    if (_error_code)
+        return (i);
+    for (; i < size && _state != Parsing_Done; ++i)
     {
         character = data[i];
         switch (_state)
@@ -107,7 +126,7 @@ void    HttpRequest::feed(char *data, size_t size)
                 else
                 {
                     _error_code = 501;
-                    return ;
+                    return (i);
                 }
                 _state = Request_Line_Method;
                 break ;
@@ -119,7 +138,7 @@ void    HttpRequest::feed(char *data, size_t size)
                 else
                 {
                     _error_code = 501;
-                    return ;
+                    return (i);
                 }
                 _method_index++;
                 _state = Request_Line_Method;
@@ -132,7 +151,7 @@ void    HttpRequest::feed(char *data, size_t size)
                 else
                 {
                     _error_code = 501;
-                    return ;
+                    return (i);
                 }
 
                 if ((size_t) _method_index == _method_str[_method].length())
@@ -144,7 +163,7 @@ void    HttpRequest::feed(char *data, size_t size)
                 if (character != ' ')
                 {
                     _error_code = 400;
-                    return ;
+                    return (i);
                 }
                 _state = Request_Line_URI_Path_Slash;
                 continue ;
@@ -161,12 +180,12 @@ void    HttpRequest::feed(char *data, size_t size)
                     /* Plusieurs espaces sont pas autorisés */
                     _error_code = 400;
                     std::cout << "Multiple spaces in request line" << std::endl;
-                    return ;
+                    return (i);
                 }
                 else
                 {
                     _error_code = 400;
-                    return ;
+                    return (i);
                 }
                 break ;
             }
@@ -196,12 +215,12 @@ void    HttpRequest::feed(char *data, size_t size)
                 else if (!allowedCharURI(character))
                 {
                     _error_code = 400;
-                    return ;
+                    return (i);
                 }
                 else if (_storage.length() > MAX_URI_LENGTH)
                 {
                     _error_code = 414;
-                    return ;
+                    return (i);
                 }
                 break ;
             }
@@ -224,12 +243,12 @@ void    HttpRequest::feed(char *data, size_t size)
                 else if (!allowedCharURI(character))
                 {
                     _error_code = 400;
-                    return ;
+                    return (i);
                 }
                 else if (_storage.length() > MAX_URI_LENGTH)
                 {
                     _error_code = 414;
-                    return ;
+                    return (i);
                 }
                 break ;
             }
@@ -245,12 +264,12 @@ void    HttpRequest::feed(char *data, size_t size)
                 else if (!allowedCharURI(character))
                 {
                     _error_code = 400;
-                    return ;
+                    return (i);
                 }
                 else if (_storage.length() > MAX_URI_LENGTH)
                 {
                     _error_code = 414;
-                    return ;
+                    return (i);
                 }
                 break ;
             }
@@ -259,12 +278,12 @@ void    HttpRequest::feed(char *data, size_t size)
                 if (checkUriPos(_path))
                 {
                     _error_code = 400;
-                    return ;
+                    return (i);
                 }
                 if (character != 'H')
                 {
                     _error_code = 400;
-                    return ;
+                    return (i);
                 }
                 _state = Request_Line_HT;
                 break ;
@@ -274,7 +293,7 @@ void    HttpRequest::feed(char *data, size_t size)
                 if (character != 'T')
                 {
                     _error_code = 400;
-                    return ;
+                    return (i);
                 }
                 _state = Request_Line_HTT;
                 break ;
@@ -284,7 +303,7 @@ void    HttpRequest::feed(char *data, size_t size)
                 if (character != 'T')
                 {
                     _error_code = 400;
-                    return ;
+                    return (i);
                 }
                 _state = Request_Line_HTTP;
                 break ;
@@ -294,7 +313,7 @@ void    HttpRequest::feed(char *data, size_t size)
                 if (character != 'P')
                 {
                     _error_code = 400;
-                    return ;
+                    return (i);
                 }
                 _state = Request_Line_HTTP_Slash;
                 break ;
@@ -304,7 +323,7 @@ void    HttpRequest::feed(char *data, size_t size)
                 if (character != '/')
                 {
                     _error_code = 400;
-                    return ;
+                    return (i);
                 }
                 _state = Request_Line_Major;
                 break ;
@@ -314,7 +333,7 @@ void    HttpRequest::feed(char *data, size_t size)
                 if (!isdigit(character))
                 {
                     _error_code = 400;
-                    return ;
+                    return (i);
                 }
                 _ver_major = character;
 
@@ -326,7 +345,7 @@ void    HttpRequest::feed(char *data, size_t size)
                 if (character != '.')
                 {
                     _error_code = 400;
-                    return ;
+                    return (i);
                 }
                 _state = Request_Line_Minor;
                 break ;
@@ -336,7 +355,7 @@ void    HttpRequest::feed(char *data, size_t size)
                 if (!isdigit(character))
                 {
                     _error_code = 400;
-                    return ;
+                    return (i);
                 }
                 _ver_minor = character;
                 _state = Request_Line_CR;
@@ -347,7 +366,7 @@ void    HttpRequest::feed(char *data, size_t size)
                 if (character != '\r')
                 {
                     _error_code = 400;
-                    return ;
+                    return (i);
                 }
                 _state = Request_Line_LF;
                 break ;
@@ -357,13 +376,13 @@ void    HttpRequest::feed(char *data, size_t size)
                 if (character != '\n')
                 {
                     _error_code = 400;
-                    return ;
+                    return (i);
                 }
                 /* Vérifie la version HTTP - seulement 1.0 et 1.1 sont supportées */
                 if (_ver_major != '1' || (_ver_minor != '0' && _ver_minor != '1'))
                 {
                     _error_code = 505;
-                    return ;
+                    return (i);
                 }
                 _state = Field_Name_Start;
                 _storage.clear();
@@ -378,7 +397,7 @@ void    HttpRequest::feed(char *data, size_t size)
                 else
                 {
                     _error_code = 400;
-                    return ;
+                    return (i);
                 }
                 break ;
             }
@@ -387,28 +406,15 @@ void    HttpRequest::feed(char *data, size_t size)
                 if (character == '\n')
                 {
                     _storage.clear();
-                    _fields_done_flag = true;
-                    _handle_headers();
-                    /* Si pas de body, le parsing est terminé */
-                    if (_body_flag == 1)
-                    {
-                        if (_chunked_flag == true)
-                            _state = Chunked_Length_Begin;
-                        else
-                        {
-                            _state = Message_Body;
-                        }
-                    }
-                    else
-                    {
-                        _state = Parsing_Done;
-                    }
+                    _fields_end();
+                    if (_error_code || headersCompleted())
+                        return (i + 1);
                     continue ;
                 }
                 else
                 {
                     _error_code = 400;
-                    return ;
+                    return (i);
                 }
                 break ;
             }
@@ -424,7 +430,7 @@ void    HttpRequest::feed(char *data, size_t size)
                 else if (!isToken(character))
                 {
                     _error_code = 400;
-                    return ;
+                    return (i);
                 }
                 break ;
                 /* Si le caractère n'est pas autorisé, erreur */
@@ -452,7 +458,7 @@ void    HttpRequest::feed(char *data, size_t size)
                 else
                 {
                     _error_code = 400;
-                    return ;
+                    return (i);
                 }
                 break ;
             }
@@ -461,7 +467,7 @@ void    HttpRequest::feed(char *data, size_t size)
                 if (isxdigit(character) == 0)
                 {
                     _error_code = 400;
-                    return ;
+                    return (i);
                 }
                 s.str("");
                 s.clear();
@@ -498,7 +504,7 @@ void    HttpRequest::feed(char *data, size_t size)
                 else
                 {
                     _error_code = 400;
-                    return ;
+                    return (i);
                 }
                 continue ;
             }
@@ -514,7 +520,7 @@ void    HttpRequest::feed(char *data, size_t size)
                 else
                 {
                     _error_code = 400;
-                    return ;
+                    return (i);
                 }
                 continue ;
             }
@@ -526,11 +532,21 @@ void    HttpRequest::feed(char *data, size_t size)
             }
             case Chunked_Data:
             {
-				_body.push_back(character);
-				--_chunk_length;
+                /* Tout ce qui reste du chunk dans data, d'un bloc ; au-delà de la
+                   taille maximale, rien de plus n'est écrit dans le BodySink */
+                size_t len = std::min(size - i, _chunk_length);
+                if (_body_received + len > _max_body_size)
+                {
+                    _error_code = 413;
+                    return (i);
+                }
+                if (!_append_body(data + i, len))
+                    return (i);
+                _chunk_length -= len;
+                i += len - 1;
                 if (_chunk_length == 0)
                     _state = Chunked_Data_CR;
-				continue ;
+                continue ;
             }
             case Chunked_Data_CR:
             {
@@ -539,7 +555,7 @@ void    HttpRequest::feed(char *data, size_t size)
                 else
                 {
                     _error_code = 400;
-                    return ;
+                    return (i);
                 }
                 continue ;
             }
@@ -550,7 +566,7 @@ void    HttpRequest::feed(char *data, size_t size)
                 else
                 {
                     _error_code = 400;
-                    return ;
+                    return (i);
                 }
                 continue ;
             }
@@ -559,7 +575,7 @@ void    HttpRequest::feed(char *data, size_t size)
                 if (character != '\r')
                 {
                     _error_code = 400;
-                    return ;
+                    return (i);
                 }
                 _state = Chunked_End_LF;
                 continue ;
@@ -570,7 +586,7 @@ void    HttpRequest::feed(char *data, size_t size)
                 if (character != '\n')
                 {
                     _error_code = 400;
-                    return ;
+                    return (i);
                 }
                 _body_done_flag = true;
                 _state = Parsing_Done;
@@ -578,26 +594,106 @@ void    HttpRequest::feed(char *data, size_t size)
             }
             case Message_Body:
             {
-                if (_body.size() < _body_length )
-                    _body.push_back(character);
-                if (_body.size() == _body_length )
+                /* Jusqu'à Content-Length, d'un bloc ; la suite est une requête pipelinée */
+                size_t len = std::min(size - i, _body_length - _body_received);
+                if (!_append_body(data + i, len))
+                    return (i);
+                i += len - 1;
+                if (_body_received == _body_length )
                 {
                     _body_done_flag = true;
                     _state = Parsing_Done;
                 }
-                break ;
+                continue ;
             }
             case Parsing_Done:
-            {
-                return ;
-            }
+                break ;
         } // fin de switch
         _storage += character;
     }
-    if( _state == Parsing_Done)
+    return (i);
+}
+
+/* Fin des headers : décide de la suite selon le body annoncé.
+   Un Content-Length au-delà de la taille maximale est refusé ici (413),
+   avant d'en recevoir le moindre octet */
+void    HttpRequest::_fields_end()
+{
+    _fields_done_flag = true;
+    _handle_headers();
+    if (_body_flag == 1 && !_chunked_flag && _body_length > _max_body_size)
+    {
+        _error_code = 413;
+        return ;
+    }
+    /* Si pas de body, le parsing est terminé */
+    if (_body_flag == 1)
     {
-        _body_str.append((char*)_body.data(), _body.size());
+        if (_chunked_flag == true)
+            _state = Chunked_Length_Begin;
+        else if (_body_length == 0)
+            _state = Parsing_Done;
+        else
+            _state = Message_Body;
     }
+    else
+    {
+        _state = Parsing_Done;
+    }
+}
+
+/* Octets du corps : au MultipartParser s'il y en a un, sinon au BodySink.
+   false : _error_code est posé (celui du parser, 500 si le BodySink ne peut écrire) */
+bool    HttpRequest::_append_body(const char *data, size_t len)
+{
+    if (_upload ? !_upload->feed(data, len) : !_body.append(data, len))
+    {
+        _error_code = _upload ? _upload->errorCode() : 500;
+        return (false);
+    }
+    _body_received += len;
+    return (true);
+}
+
+/* Chemin rapide : l'en-tête est copié d'un bloc dans _head (le buffer du client
+   peut être réalloué par les lectures suivantes), découpé par scanRequest(),
+   et les headers restent des vues sur _head : la map n'est construite que si
+   getHeaders() est appelé (CGI).
+   Retourne les octets consommés (l'en-tête), 0 si la requête doit passer par la
+   machine à états (en-tête incomplet, erreur à signaler, cas inhabituel) */
+size_t  HttpRequest::_fast_parse(char *data, size_t size)
+{
+    const char *head_end = scanHeadEnd(data, data + size);
+
+    if (head_end == NULL)
+        return (0);
+    _head.assign(data, head_end - data);
+    if (!scanRequest(_head.data(), _head.size(), _view))
+        return (0);
+    _path.assign(_view.path.data, _view.path.len);
+    if (checkUriPos(_path))
+    {
+        _path.clear();
+        _view.clear();
+        return (0);
+    }
+    if (_view.method.data[0] == 'G')
+        _method = GET;
+    else if (_view.method.data[0] == 'P')
+        _method = POST;
+    else
+        _method = DELETE;
+    _query.assign(_view.query.data, _view.query.len);
+    _fragment.assign(_view.fragment.data, _view.fragment.len);
+    _ver_major = '1';
+    _ver_minor = _view.ver_minor;
+    _fields_end();
+    return (_view.head_length);
+}
+
+const RequestView &HttpRequest::view() const
+{
+    return (_view);
 }
 
 bool    HttpRequest::parsingCompleted()
@@ -605,6 +701,12 @@ bool    HttpRequest::parsingCompleted()
     return (_state == Parsing_Done || _error_code != 0);
 }
 
+/* Les états du corps (chunked ou Content-Length) suivent ceux des en-têtes dans l'enum */
+bool    HttpRequest::headersCompleted()
+{
+    return (_state >= Chunked_Length_Begin);
+}
+
 HttpMethod  &HttpRequest::getMethod()
 {
     return (_method);
@@ -625,13 +727,55 @@ std::string &HttpRequest::getFragment()
     return (_fragment);
 }
 
+/* Valeur du header name (en minuscules), vide s'il est absent */
 std::string HttpRequest::getHeader(std::string const &name)
 {
-    return (_request_headers[name]);
+    std::string value;
+
+    getHeader(name, value);
+    return (value);
+}
+
+/* Comme getHeader(), mais distingue un header absent d'un header vide */
+bool    HttpRequest::getHeader(std::string const &name, std::string &value)
+{
+    if (_view.head_length && !_headers_built)
+    {
+        /* Chemin rapide : dernière occurrence, comme dans la map */
+        for (size_t h = _view.headers.size(); h-- > 0; )
+        {
+            const HeaderView &header = _view.headers[h];
+            if (header.name.len == name.size() && !strncasecmp(header.name.data, name.c_str(), name.size()))
+            {
+                value.assign(header.value.data, header.value.len);
+                return (true);
+            }
+        }
+        return (false);
+    }
+    std::map<std::string, std::string>::const_iterator it = _request_headers.find(name);
+    if (it == _request_headers.end())
+        return (false);
+    value = it->second;
+    return (true);
 }
 
-const std::map<std::string, std::string> &HttpRequest::getHeaders() const
+/* Tous les headers (clés en minuscules). Après le chemin rapide, la map est
+   construite ici, au premier appel, à partir des vues */
+const std::map<std::string, std::string> &HttpRequest::getHeaders()
 {
+    if (_view.head_length && !_headers_built)
+    {
+        for (size_t h = 0; h < _view.headers.size(); ++h)
+        {
+            const HeaderView &header = _view.headers[h];
+            _key_storage.assign(header.name.data, header.name.len);
+            toLower(_key_storage);
+            _request_headers[_key_storage].assign(header.value.data, header.value.len);
+        }
+        _key_storage.clear();
+        _headers_built = true;
+    }
 	return (this->_request_headers);
 }
 
@@ -640,9 +784,9 @@ std::string HttpRequest::getMethodStr()
 	return (_method_str[_method]);
 }
 
-std::string &HttpRequest::getBody()
+BodySink    &HttpRequest::getBody()
 {
-    return (_body_str);
+    return (_body);
 }
 
 std::string     HttpRequest::getServerName()
@@ -663,8 +807,23 @@ std::string     &HttpRequest::getBoundary()
 void    HttpRequest::setBody(std::string body)
 {
     _body.clear();
-    _body.insert(_body.begin(), body.begin(), body.end());
-    _body_str = body;
+    _body.append(body.data(), body.size());
+    _body_received = _body.size();
+}
+
+size_t  HttpRequest::getBodySize()
+{
+    return (_body_received);
+}
+
+void    HttpRequest::setUpload(MultipartParser *upload)
+{
+    _upload = upload;
+}
+
+void    HttpRequest::setBodyBuffer(size_t threshold, const std::string &temp_dir)
+{
+    _body.configure(threshold, temp_dir);
 }
 
 void    HttpRequest::setMethod(HttpMethod & method)
@@ -679,6 +838,9 @@ void    HttpRequest::setHeader(std::string &name, std::string &value)
     _request_headers[name] = value;
 }
 
+/* Borne du corps pendant la réception : la plus grande client_max_body_size
+   des serveurs du port (le serveur exact n'est choisi qu'après, par Host) ;
+   Response applique ensuite la limite du serveur et de la location */
 void    HttpRequest::setMaxBodySize(size_t size)
 {
     _max_body_size = size;
@@ -690,15 +852,15 @@ void        HttpRequest::printMessage()
     std::cout << _method_str[_method] + " " + _path + "?" + _query + "#" + _fragment
               + " " + "HTTP/" << _ver_major  << "." << _ver_minor << std::endl;
 
-    for (std::map<std::string, std::string>::iterator it = _request_headers.begin();
+    for (std::map<std::string, std::string>::const_iterator it = getHeaders().begin();
     it != _request_headers.end(); ++it)
     {
         std::cout << it->first + ":" + it->second << std::endl;
     }
-    for (std::vector<u_int8_t>::iterator it = _body.begin(); it != _body.end(); ++it)
-    {
-        std::cout << *it;
-    }
+    if (_body.inMemory())
+        std::cout << _body.memory();
+    else
+        std::cout << "(" << _body.size() << " bytes on disk)";
     std::cout << std::endl << "END OF BODY" << std::endl;
 
     std::cout << "BODY FLAG =" << _body_flag << "  _BOD_done_flag= " << _body_done_flag << "FEIDLS FLAG = " << _fields_done_flag
@@ -708,30 +870,33 @@ void        HttpRequest::printMessage()
 /* Gère les headers de la requête */
 void        HttpRequest::_handle_headers()
 {
-    std::stringstream ss;
+    std::string value;
 
-    if (_request_headers.count("content-length"))
+    if (getHeader("content-length", value))
     {
+        std::stringstream ss(value);
         _body_flag = true;
-        ss << _request_headers["content-length"];
         ss >> _body_length;
     }
-    if ( _request_headers.count("transfer-encoding"))
+    if (getHeader("transfer-encoding", value))
     {
-        if (_request_headers["transfer-encoding"].find_first_of("chunked") != std::string::npos)
+        if (value.find_first_of("chunked") != std::string::npos)
             _chunked_flag = true;
         _body_flag = true;
     }
-    if (_request_headers.count("host"))
-    {
-        size_t pos = _request_headers["host"].find_first_of(':');
-        _server_name = _request_headers["host"].substr(0, pos);
-    }
-    if (_request_headers.count("content-type") && _request_headers["content-type"].find("multipart/form-data") != std::string::npos)
+    if (getHeader("host", value))
+        _server_name.assign(value, 0, value.find_first_of(':'));
+    if (getHeader("content-type", value) && value.find("multipart/form-data") != std::string::npos)
     {
-        size_t pos = _request_headers["content-type"].find("boundary=", 0);
+        size_t pos = value.find("boundary=", 0);
+        /* boundary=XyZ ou boundary="XyZ", éventuellement suivi d'autres paramètres */
         if (pos != std::string::npos)
-            this->_boundary = _request_headers["content-type"].substr(pos + 9, _request_headers["content-type"].size());
+        {
+            this->_boundary = value.substr(pos + 9, value.find(';', pos) - pos - 9);
+            trimStr(this->_boundary);
+            if (this->_boundary.size() >= 2 && this->_boundary[0] == '"')
+                this->_boundary = this->_boundary.substr(1, this->_boundary.find('"', 1) - 1);
+        }
         this->_multiform_flag = true;
     }
 }
@@ -752,11 +917,15 @@ void    HttpRequest::clear()
     _method_index = 1;
     _state = Request_Line;
     _body_length = 0;
+    _body_received = 0;
+    _upload = NULL;
     _chunk_length = 0x0;
     _storage.clear();
-    _body_str = "";
+    _view.clear();
     _key_storage.clear();
     _request_headers.clear();
+    _headers_built = false;
+    _head.clear();
     _server_name.clear();
     _body.clear();
     _boundary.clear();
@@ -766,21 +935,29 @@ void    HttpRequest::clear()
     _complete_flag = false;
     _chunked_flag = false;
     _multiform_flag = false;
+    _ver_major = 0;
+    _ver_minor = 0;
 }
 
-/* Vérifie la valeur du header "Connection". Si keep-alive, ne pas fermer la connexion. */
+/* Vérifie la valeur du header "Connection". Si keep-alive, ne pas fermer la connexion.
+   HTTP/1.1 : persistante par défaut, sauf "Connection: close"
+   HTTP/1.0 : fermée par défaut, sauf "Connection: keep-alive"
+   Après une erreur de parsing, la suite du flux est illisible : on ferme. */
 bool        HttpRequest::keepAlive()
 {
-    if (_request_headers.count("connection"))
-    {
-        if (_request_headers["connection"].find("close", 0) != std::string::npos)
-            return (false);
-    }
+    if (_error_code)
+        return (false);
+    std::string connection;
+    bool        found = getHeader("connection", connection);
+    if (_ver_minor == '0')
+        return (found && connection.find("keep-alive") != std::string::npos);
+    if (found && connection.find("close", 0) != std::string::npos)
+        return (false);
     return (true);
 }
 
-void            HttpRequest::cutReqBody(int bytes)
+bool        HttpRequest::isHttp11()
 {
-    _body_str = _body_str.substr(bytes);
+    return (_ver_major == '1' && _ver_minor == '1');
 }
 
@@ -27,10 +27,14 @@ Location::Location()
 	this->_path = "";
 	this->_root = "";
 	this->_autoindex = false;
+	this->_autoindex_json = false;
+	this->_autoindex_page_size = 0;
 	this->_index = "";
 	this->_return = "";
 	this->_alias = "";
 	this->_client_max_body_size = MAX_CONTENT_LENGTH;
+	this->_cgi_pool = 0;
+	this->_cgi_pool_max_requests = CGI_POOL_MAX_REQUESTS;
 	this->_methods.reserve(3);
 	this->_methods.push_back(1);
 	this->_methods.push_back(0);
@@ -44,6 +48,8 @@ Location::Location(const Location &src)
 	this->_path 				= src._path;
 	this->_root 				= src._root;
 	this->_autoindex 			= src._autoindex;
+	this->_autoindex_json		= src._autoindex_json;
+	this->_autoindex_page_size	= src._autoindex_page_size;
 	this->_index 				= src._index;
 	this->_cgi_path 			= src._cgi_path;
 	this->_cgi_ext 				= src._cgi_ext;
@@ -52,6 +58,9 @@ Location::Location(const Location &src)
     this->_methods 				= src._methods;
 	this->_ext_path 			= src._ext_path;
 	this->_client_max_body_size = src._client_max_body_size;
+	this->_cgi_pool = src._cgi_pool;
+	this->_cgi_pool_max_requests = src._cgi_pool_max_requests;
+	this->_cgi_env = src._cgi_env;
 }
 
 Location &Location::operator=(const Location &src)
@@ -61,6 +70,8 @@ Location &Location::operator=(const Location &src)
 		this->_path 				= src._path;
 		this->_root 				= src._root;
 		this->_autoindex 			= src._autoindex;
+		this->_autoindex_json		= src._autoindex_json;
+		this->_autoindex_page_size	= src._autoindex_page_size;
 		this->_index 				= src._index;
 		this->_cgi_path 			= src._cgi_path;
 		this->_cgi_ext 				= src._cgi_ext;
@@ -69,6 +80,9 @@ Location &Location::operator=(const Location &src)
 		this->_methods				= src._methods;
 		this->_ext_path 			= src._ext_path;
 		this->_client_max_body_size = src._client_max_body_size;
+		this->_cgi_pool = src._cgi_pool;
+		this->_cgi_pool_max_requests = src._cgi_pool_max_requests;
+		this->_cgi_env = src._cgi_env;
 	}
 	return (*this);
 }
@@ -111,6 +125,25 @@ void Location::setAutoindex(std::string parametr){
 		throw ServerConfig::ErrorException("Wrong autoindex");
 }
 
+/* Format du listing autoindex : html, ou json pour un client programmé */
+void Location::setAutoindexFormat(std::string parametr){
+	if (parametr != "html" && parametr != "json")
+		throw ServerConfig::ErrorException("Wrong syntax: autoindex_format");
+	this->_autoindex_json = (parametr == "json");
+}
+
+/* Entrées par page du listing autoindex (?page=N), 0 : pas de pagination */
+void Location::setAutoindexPageSize(std::string parametr){
+	for (size_t i = 0; i < parametr.length(); i++)
+	{
+		if (parametr[i] < '0' || parametr[i] > '9')
+			throw ServerConfig::ErrorException("Wrong syntax: autoindex_page_size");
+	}
+	if (parametr.empty() || parametr.length() > 9)
+		throw ServerConfig::ErrorException("Wrong syntax: autoindex_page_size");
+	this->_autoindex_page_size = ft_stoi(parametr);
+}
+
 void Location::setIndexLocation(std::string parametr){
 	this->_index = parametr;
 }
@@ -149,6 +182,36 @@ void Location::setMaxBodySize(unsigned long parametr){
 	this->_client_max_body_size = parametr;
 }
 
+/* Nombre d'interpréteurs Python gardés en vie pour cette location (1 à CGI_POOL_MAX_SIZE) */
+void Location::setCgiPool(std::string parametr){
+	for (size_t i = 0; i < parametr.length(); i++)
+	{
+		if (parametr[i] < '0' || parametr[i] > '9')
+			throw ServerConfig::ErrorException("Wrong syntax: cgi_pool");
+	}
+	int size = ft_stoi(parametr);
+	if (size < 1 || size > CGI_POOL_MAX_SIZE)
+		throw ServerConfig::ErrorException("Wrong syntax: cgi_pool");
+	this->_cgi_pool = size;
+}
+
+void Location::setCgiPoolMaxRequests(std::string parametr){
+	for (size_t i = 0; i < parametr.length(); i++)
+	{
+		if (parametr[i] < '0' || parametr[i] > '9')
+			throw ServerConfig::ErrorException("Wrong syntax: cgi_pool_max_requests");
+	}
+	if (!ft_stoi(parametr))
+		throw ServerConfig::ErrorException("Wrong syntax: cgi_pool_max_requests");
+	this->_cgi_pool_max_requests = ft_stoi(parametr);
+}
+
+/* Une fois la location validée (root et interpréteurs définitifs) :
+	les requêtes CGI ne recalculent plus que leurs propres variables */
+void Location::buildCgiEnv(){
+	this->_cgi_env.build(this->_root, this->_ext_path);
+}
+
 /***** GET fonctions *****/
 const std::string &Location::getPath() const{
 	return (this->_path);
@@ -178,6 +241,14 @@ const bool &Location::getAutoindex() const{
 	return (this->_autoindex);
 }
 
+bool Location::getAutoindexJson() const{
+	return (this->_autoindex_json);
+}
+
+size_t Location::getAutoindexPageSize() const{
+	return (this->_autoindex_page_size);
+}
+
 const std::string &Location::getReturn() const{
 	return (this->_return);
 }
@@ -194,6 +265,18 @@ const unsigned long &Location::getMaxBodySize() const{
 	return (this->_client_max_body_size);
 }
 
+size_t Location::getCgiPool() const{
+	return (this->_cgi_pool);
+}
+
+size_t Location::getCgiPoolMaxRequests() const{
+	return (this->_cgi_pool_max_requests);
+}
+
+const CgiEnvTemplate &Location::getCgiEnv() const{
+	return (this->_cgi_env);
+}
+
 /**** Pour imprimer les méthodes autorisées (pour contrôle)****/
 std::string Location::getPrintMethods() const
 {
@@ -0,0 +1,74 @@
+#include "LocationTrie.hpp"
+#include <algorithm>
+
+LocationTrie::LocationTrie()
+{
+	clear();
+}
+
+void LocationTrie::clear()
+{
+	_nodes.clear();
+	_nodes.push_back(LocationTrieNode());
+	_nodes[0].location = -1;
+}
+
+/* Enfant de node par le caractère c, -1 s'il n'existe pas */
+int LocationTrie::child(int node, char c) const
+{
+	const std::vector<char> &keys = _nodes[node].keys;
+	std::vector<char>::const_iterator it = std::lower_bound(keys.begin(), keys.end(), c);
+
+	if (it == keys.end() || *it != c)
+		return (-1);
+	return (_nodes[node].next[it - keys.begin()]);
+}
+
+/* Ajoute le chemin d'une location ; en cas de doublon la première reste (checkLocations() le refuse) */
+void LocationTrie::insert(const std::string &path, int location)
+{
+	int node = 0;
+
+	for (size_t i = 0; i < path.length(); i++)
+	{
+		int next = child(node, path[i]);
+		if (next < 0)
+		{
+			next = _nodes.size();
+			_nodes.push_back(LocationTrieNode());
+			_nodes.back().location = -1;
+			std::vector<char> &keys = _nodes[node].keys;
+			size_t pos = std::lower_bound(keys.begin(), keys.end(), path[i]) - keys.begin();
+			keys.insert(keys.begin() + pos, path[i]);
+			_nodes[node].next.insert(_nodes[node].next.begin() + pos, next);
+		}
+		node = next;
+	}
+	if (_nodes[node].location < 0)
+		_nodes[node].location = location;
+}
+
+/* Index de la location la plus longue qui correspond à uri, -1 si aucune
+	Ex : locations "/", "/42-webserv", "/42-webserv/messages"
+	"/42-webserv/messages/a.txt" -> "/42-webserv/messages" (longueur 20, suivie de '/') */
+int LocationTrie::match(const std::string &uri) const
+{
+	int		node = 0;
+	int		best = -1;
+	size_t	i = 0;
+
+	while (true)
+	{
+		int loc = _nodes[node].location;
+		bool root = (i == 1 && uri[0] == '/');		// location "/"
+		if (loc >= 0 && (root || i == uri.length() || uri[i] == '/'))
+			best = loc;
+		if (i == uri.length())
+			break ;
+		node = child(node, uri[i]);
+		if (node < 0)
+			break ;
+		i++;
+	}
+	return (best);
+}
@@ -33,15 +33,19 @@ Mime::Mime()
 	_types[".jpeg"] = "image/jpeg";
 	_types[".png"] = "image/png";
 	_types[".txt"] = "text/plain";
+	_types[".json"] = "application/json";
 	_types[".mp3"] = "audio/mp3";
 	_types[".pdf"] = "application/pdf";
 	_types["default"] = "text/html";
 }
 
-std::string Mime::getMimeType(std::string extension)
+/* Renvoie une référence vers la table : aucune copie par réponse */
+const std::string &Mime::getMimeType(const std::string &extension) const
 {
-	if (_types.count(extension))
-		return (_types[extension]);
-	return (_types["default"]);
+	std::map<std::string, std::string>::const_iterator it = _types.find(extension);
+
+	if (it == _types.end())
+		it = _types.find("default");
+	return (it->second);
 }
 
@@ -0,0 +1,314 @@
+#include "MultipartParser.hpp"
+#include "Webserv.hpp"
+#include "BodySink.hpp"
+
+Horspool::Horspool()
+{
+    assign("");
+}
+
+/* Table de sauts : pour chaque octet, distance entre sa dernière position dans
+   le motif (dernier octet exclu) et la fin du motif ; absent : longueur du motif */
+void    Horspool::assign(const std::string &pattern)
+{
+    size_t  last = pattern.empty() ? 0 : pattern.size() - 1;
+
+    _pattern = pattern;
+    for (size_t c = 0; c < 256; ++c)
+        _shift[c] = pattern.size() ? pattern.size() : 1;
+    for (size_t i = 0; i < last; ++i)
+        _shift[(unsigned char)pattern[i]] = last - i;
+}
+
+size_t  Horspool::find(const char *text, size_t len) const
+{
+    size_t  size = _pattern.size();
+
+    if (size == 0 || len < size)
+        return (std::string::npos);
+
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(text);
+    unsigned char       last = _pattern[size - 1];
+
+    for (size_t pos = 0; pos <= len - size; pos += _shift[bytes[pos + size - 1]])
+    {
+        if (bytes[pos + size - 1] == last && !memcmp(text + pos, _pattern.data(), size - 1))
+            return (pos);
+    }
+    return (std::string::npos);
+}
+
+size_t  Horspool::size() const
+{
+    return (_pattern.size());
+}
+
+const std::string   &Horspool::pattern() const
+{
+    return (_pattern);
+}
+
+/* Le premier délimiteur n'est précédé d'aucun CRLF : on en ajoute un devant le corps,
+   le préambule devient une partie ignorée comme une autre */
+MultipartParser::MultipartParser(const std::string &boundary, const std::string &target, bool to_directory)
+    : _buffer("\r\n"), _target(target), _to_directory(to_directory), _state(Multipart_Data),
+      _fd(-1), _error_code(0), _created(false)
+{
+    _delimiter.assign("\r\n--" + boundary);
+}
+
+/* Parseur abandonné avant finish() : rien n'est renommé */
+MultipartParser::~MultipartParser()
+{
+    _discard();
+}
+
+/* Une tranche du corps. Sans reste de la tranche précédente (le cas courant),
+   elle est découpée sur place, sans copie */
+bool    MultipartParser::feed(const char *data, size_t len)
+{
+    if (_error_code)
+        return (false);
+    if (_buffer.empty())
+    {
+        size_t used = _parse(data, len);
+        if (!_error_code)
+            _buffer.assign(data + used, len - used);
+    }
+    else
+    {
+        _buffer.append(data, len);
+        _buffer.erase(0, _parse(_buffer.data(), _buffer.size()));
+    }
+    return (_error_code == 0);
+}
+
+/* Fin du corps : le délimiteur final doit avoir été lu, alors seulement chaque
+   temporaire prend la place de sa destination (rename() : atomique, même dossier) */
+bool    MultipartParser::finish()
+{
+    if (!_error_code && _state != Multipart_Done)
+        _fail(400);
+    _buffer.clear();
+    for (size_t i = 0; !_error_code && i < _temps.size(); ++i)
+    {
+        if (rename(_temps[i].c_str(), _files[i].c_str()) != 0)
+            _fail(500);
+        else
+            _temps[i].clear();
+    }
+    return (_error_code == 0);
+}
+
+short   MultipartParser::errorCode() const
+{
+    return (_error_code);
+}
+
+bool    MultipartParser::created() const
+{
+    return (_created);
+}
+
+const std::vector<std::string>  &MultipartParser::files() const
+{
+    return (_files);
+}
+
+/* Avance d'état en état tant que les octets suffisent ; retourne les octets consommés
+   (le reste attend la tranche suivante) */
+size_t  MultipartParser::_parse(const char *data, size_t len)
+{
+    size_t  pos = 0;
+    size_t  used = 0;
+
+    while (pos < len && _state != Multipart_Done && !_error_code)
+    {
+        if (_state == Multipart_Delimiter_End)
+            used = _delimiterEnd(data + pos, len - pos);
+        else if (_state == Multipart_Headers)
+            used = _headers(data + pos, len - pos);
+        else
+            used = _data(data + pos, len - pos);
+        if (used == 0)
+            break ;
+        pos += used;
+    }
+    if (_state == Multipart_Done)
+        return (len);
+    return (pos);
+}
+
+/* Après "\r\n--boundary" : "--" termine le corps, sinon blancs éventuels puis CRLF */
+size_t  MultipartParser::_delimiterEnd(const char *data, size_t len)
+{
+    size_t  i = 0;
+
+    if (len < 2)
+        return (0);
+    if (data[0] == '-' && data[1] == '-')
+    {
+        _state = Multipart_Done;
+        return (2);
+    }
+    while (i < len && (data[i] == ' ' || data[i] == '\t'))
+        ++i;
+    if (i + 1 >= len)
+        return (len > 64 ? _fail(400) : 0);
+    if (data[i] != '\r' || data[i + 1] != '\n')
+        return (_fail(400));
+    _state = Multipart_Headers;
+    return (i + 2);
+}
+
+/* Valeur de filename="..." dans Content-Disposition, vide si absente */
+static std::string partFilename(const std::string &headers)
+{
+    std::string lower(headers);
+
+    for (size_t i = 0; i < lower.size(); ++i)
+        lower[i] = std::tolower(lower[i]);
+    size_t  line = lower.find("content-disposition:");
+    if (line == std::string::npos)
+        return ("");
+    size_t  end_line = lower.find("\r\n", line);
+    size_t  start = lower.find("filename=\"", line);
+    if (start == std::string::npos || start > end_line)
+        return ("");
+    start += 10;
+    size_t  end = headers.find('"', start);
+    if (end == std::string::npos || end > end_line)
+        return ("");
+    return (headers.substr(start, end - start));
+}
+
+/* En-têtes de la partie jusqu'à la ligne vide ; ouvre son fichier si elle en porte un */
+size_t  MultipartParser::_headers(const char *data, size_t len)
+{
+    std::string block;
+    size_t      end;
+
+    if (len >= 2 && data[0] == '\r' && data[1] == '\n')
+        end = 0;
+    else
+    {
+        const char *found = std::search(data, data + len, "\r\n\r\n", "\r\n\r\n" + 4);
+        if (found == data + len)
+            return (len > MULTIPART_HEADER_MAX ? _fail(400) : 0);
+        end = found - data + 2;
+        block.assign(data, end);
+    }
+    _state = Multipart_Data;
+
+    /* Seul le nom est gardé : "../../etc/passwd" → "passwd" */
+    std::string name = partFilename(block);
+    name.erase(0, name.find_last_of("/\\") + 1);
+    if (name == "." || name == "..")
+        return (_fail(400));
+    if (!name.empty() && !_openPart(name))
+        return (0);
+    return (end + 2);
+}
+
+/* Contenu de la partie : écrit jusqu'au délimiteur. S'il n'est pas dans la tranche,
+   on garde seulement la fin qui pourrait en être le début ("\r\n--Xy" de "\r\n--XyZ") */
+size_t  MultipartParser::_data(const char *data, size_t len)
+{
+    size_t  found = _delimiter.find(data, len);
+
+    if (found != std::string::npos)
+    {
+        if (!_write(data, found))
+            return (0);
+        _closePart();
+        _state = Multipart_Delimiter_End;
+        return (found + _delimiter.size());
+    }
+
+    const std::string   &pattern = _delimiter.pattern();
+    size_t              keep = std::min(len, pattern.size() - 1);
+
+    while (keep > 0 && (data[len - keep] != '\r' || memcmp(data + len - keep, pattern.data(), keep)))
+        --keep;
+    if (!_write(data, len - keep))
+        return (0);
+    return (len - keep);
+}
+
+/* Temporaire de la partie, dans le dossier de sa destination (pour que rename() ne
+   copie rien) ; 403 comme un open() : destination dossier ou non inscriptible, dossier
+   non inscriptible. Le fichier a les droits d'un open(0666) */
+bool    MultipartParser::_openPart(const std::string &filename)
+{
+    std::string path;
+
+    if (_to_directory)
+        path = _target + filename;
+    else if (_files.empty())
+        path = _target;
+    else
+        path = _target.substr(0, _target.find_last_of('/') + 1) + filename;
+
+    struct stat st;
+    bool        existed = stat(path.c_str(), &st) == 0;
+
+    if (existed && (S_ISDIR(st.st_mode) || access(path.c_str(), W_OK) != 0))
+        return (_fail(403));
+
+    std::string         temp = path.substr(0, path.find_last_of('/') + 1) + ".upload-XXXXXX";
+    std::vector<char>   name(temp.begin(), temp.end());
+
+    name.push_back('\0');
+    _fd = mkstemp(&name[0]);
+    if (_fd < 0)
+        return (_fail(403));
+    fcntl(_fd, F_SETFD, FD_CLOEXEC);
+    fchmod(_fd, BodySink::fileMode());
+    _created = _created || !existed;
+    _files.push_back(path);
+    _temps.push_back(&name[0]);
+    return (true);
+}
+
+/* Contenu d'une partie ignorée (champ de formulaire, préambule) : rien à écrire */
+bool    MultipartParser::_write(const char *data, size_t len)
+{
+    if (_fd < 0)
+        return (true);
+    for (size_t done = 0; done < len; )
+    {
+        ssize_t n = write(_fd, data + done, len - done);
+        if (n < 0)
+            return (_fail(500));
+        done += n;
+    }
+    return (true);
+}
+
+void    MultipartParser::_closePart()
+{
+    if (_fd >= 0)
+        close(_fd);
+    _fd = -1;
+}
+
+/* Erreur : aucune partie de la requête n'est gardée, même celles déjà complètes */
+bool    MultipartParser::_fail(short code)
+{
+    _error_code = code;
+    _discard();
+    return (false);
+}
+
+/* Supprime les temporaires pas encore renommés */
+void    MultipartParser::_discard()
+{
+    _closePart();
+    for (size_t i = 0; i < _temps.size(); ++i)
+    {
+        if (!_temps[i].empty())
+            unlink(_temps[i].c_str());
+    }
+    _temps.clear();
+    _files.clear();
+}
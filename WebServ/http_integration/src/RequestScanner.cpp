@@ -0,0 +1,164 @@
+#include "RequestScanner.hpp"
+#include "Webserv.hpp"
+
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#endif
+
+/* Tables de caractères (mêmes règles que allowedCharURI() et isToken()) */
+struct CharTables
+{
+	bool	uri[256];
+	bool	token[256];
+
+	CharTables()
+	{
+		for (int ch = 0; ch < 256; ++ch)
+		{
+			uri[ch] = (ch >= '#' && ch <= ';') || (ch >= '?' && ch <= '[') || (ch >= 'a' && ch <= 'z')
+				|| ch == '!' || ch == '=' || ch == ']' || ch == '_' || ch == '~';
+			token[ch] = ch == '!' || (ch >= '#' && ch <= '\'') || ch == '*' || ch == '+' || ch == '-'
+				|| ch == '.' || (ch >= '0' && ch <= '9') || (ch >= 'A' && ch <= 'Z')
+				|| (ch >= '^' && ch <= '`') || (ch >= 'a' && ch <= 'z') || ch == '|';
+		}
+	}
+};
+
+static const CharTables	g_tables;
+
+void	RequestView::clear()
+{
+	method = StrView();
+	path = StrView();
+	query = StrView();
+	fragment = StrView();
+	ver_minor = 0;
+	head_length = 0;
+	headers.clear();
+}
+
+/* Premier c dans [p, end), end si absent */
+const char	*scanByte(const char *p, const char *end, char c)
+{
+#if defined(__SSE2__)
+	const __m128i	needle = _mm_set1_epi8(c);
+
+	while (end - p >= 16)
+	{
+		__m128i	block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+		int		mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+		if (mask)
+			return (p + __builtin_ctz(mask));
+		p += 16;
+	}
+#endif
+	while (p < end && *p != c)
+		++p;
+	return (p);
+}
+
+/* Fin de l'en-tête (juste après "\r\n\r\n"), NULL s'il n'est pas encore arrivé en entier */
+const char	*scanHeadEnd(const char *p, const char *end)
+{
+	while (p < end)
+	{
+		p = scanByte(p, end, '\r');
+		if (end - p < 4)
+			return (NULL);
+		if (p[1] == '\n' && p[2] == '\r' && p[3] == '\n')
+			return (p + 4);
+		++p;
+	}
+	return (NULL);
+}
+
+static bool	allIn(const bool *table, const char *p, const char *end)
+{
+	for (; p < end; ++p)
+	{
+		if (!table[static_cast<unsigned char>(*p)])
+			return (false);
+	}
+	return (true);
+}
+
+/* Méthode, chemin, query, fragment et version ; line = ligne sans le CRLF */
+static bool	scanRequestLine(const char *line, const char *end, RequestView &view)
+{
+	const char	*sp = scanByte(line, end, ' ');
+
+	view.method = StrView(line, sp - line);
+	if (!((view.method.len == 3 && !memcmp(line, "GET", 3))
+		|| (view.method.len == 4 && !memcmp(line, "POST", 4))
+		|| (view.method.len == 6 && !memcmp(line, "DELETE", 6))))
+		return (false);
+
+	const char	*target = sp + 1;
+	const char	*target_end = scanByte(target, end, ' ');
+	if (target >= end || *target != '/' || !allIn(g_tables.uri, target, target_end))
+		return (false);
+	if (end - target_end != 9 || memcmp(target_end, " HTTP/1.", 8)
+		|| (target_end[8] != '0' && target_end[8] != '1'))
+		return (false);
+	view.ver_minor = target_end[8];
+
+	const char	*query = std::min(scanByte(target, target_end, '?'), scanByte(target, target_end, '#'));
+	view.path = StrView(target, query - target);
+	if (query < target_end && *query == '?')
+	{
+		const char	*fragment = scanByte(query + 1, target_end, '#');
+		view.query = StrView(query + 1, fragment - query - 1);
+		query = fragment;
+	}
+	if (query < target_end)
+		view.fragment = StrView(query + 1, target_end - query - 1);
+	return (view.path.len <= MAX_URI_LENGTH && view.query.len <= MAX_URI_LENGTH
+		&& view.fragment.len <= MAX_URI_LENGTH);
+}
+
+/* "Nom: valeur" ; line = ligne sans le CRLF */
+static bool	scanHeader(const char *line, const char *end, RequestView &view)
+{
+	const char	*colon = scanByte(line, end, ':');
+
+	if (colon == line || colon == end || !allIn(g_tables.token, line, colon))
+		return (false);
+	const char	*value = colon + 1;
+	const char	*value_end = end;
+	while (value < value_end && (*value == ' ' || *value == '\t'))
+		++value;
+	while (value_end > value && (value_end[-1] == ' ' || value_end[-1] == '\t'))
+		--value_end;
+
+	HeaderView	header;
+	header.name = StrView(line, colon - line);
+	header.value = StrView(value, value_end - value);
+	view.headers.push_back(header);
+	return (true);
+}
+
+/* Découpe la requête si data contient son en-tête complet ; view est remplie
+	(vues sur data) et view.head_length indique où commence le body */
+bool	scanRequest(const char *data, size_t size, RequestView &view)
+{
+	const char	*end = data + size;
+	const char	*head_end = scanHeadEnd(data, end);
+
+	view.clear();
+	if (head_end == NULL)
+		return (false);
+	const char	*line_end = scanByte(data, head_end, '\r');
+	if (line_end[1] != '\n' || !scanRequestLine(data, line_end, view))
+		return (false);
+	const char	*line = line_end + 2;
+	while (line < head_end - 2)
+	{
+		line_end = scanByte(line, head_end, '\r');
+		if (line_end[1] != '\n' || view.headers.size() == MAX_FAST_HEADERS
+			|| !scanHeader(line, line_end, view))
+			return (false);
+		line = line_end + 2;
+	}
+	view.head_length = head_end - data;
+	return (true);
+}
@@ -11,37 +11,121 @@
 /* ************************************************************************** */
 
 #include "Response.hpp"
+#include "Metrics.hpp"
 
 Mime Response::mime;
+FileCache Response::files(Response::mime);
+DirectoryCache Response::directories;
 
-Response::Response()
+Response::Response() : _server(NULL), _request(NULL)
 {
 	_target_file = "";
 	_body.clear();
 	_body_length = 0;
-	response_content = "";
 	_response_body = "";
 	_location = "";
 	_code = 0;
 	_cgi = 0;
 	_cgi_response_length = 0;
 	_auto_index = 0;
+	_listing_view.json = false;
+	_listing_view.page = 1;
+	_listing_view.page_size = 0;
+	_file_fd = -1;
+	_file_size = 0;
+	_cached = NULL;
+	_cached_body = NULL;
+	_source = NULL;
+	_stream = NULL;
+	_upload = NULL;
+	_chunked = false;
+	_source_done = false;
+	_with_body = false;
+	_resolve_us = PHASE_UNTIMED;
+	_read_us = PHASE_UNTIMED;
 }
 
-Response::~Response() {}
+Response::~Response()
+{
+	releaseFile();
+	releaseBody();
+	releaseUpload();
+}
+
+/*	Copie sans les ressources possédées : le fd du cache, l'entrée épinglée, le
+	producteur et l'upload en cours restent à l'original (sinon double libération). Tout ce que
+	releaseFile() et releaseBody() lisent est initialisé avant l'operator= */
+Response::Response(const Response &src) : _server(NULL), _request(NULL)
+{
+	_file_fd = -1;
+	_cached = NULL;
+	_cached_body = NULL;
+	_source = NULL;
+	_stream = NULL;
+	_upload = NULL;
+	*this = src;
+}
+
+Response &Response::operator=(const Response &src)
+{
+	if (this != &src)
+	{
+		releaseFile();
+		releaseBody();
+		releaseUpload();
+		_server = src._server;
+		_request = src._request;
+		_target_file = src._target_file;
+		_body = src._body;
+		_body_length = src._body_length;
+		_response_body = src._response_body;
+		_location = src._location;
+		_code = src._code;
+		_cgi = src._cgi;
+		_cgi_fd[0] = src._cgi_fd[0];
+		_cgi_fd[1] = src._cgi_fd[1];
+		_cgi_response_length = src._cgi_response_length;
+		_auto_index = src._auto_index;
+		_listing_view = src._listing_view;
+		_file_fd = -1;
+		_file_size = 0;
+		_cached = NULL;
+		_cached_body = NULL;
+		_chunked = false;
+		_source_done = false;
+		cgi_obj = src.cgi_obj;
+		_head = src._head;
+		_with_body = src._with_body;
+	}
+	return (*this);
+}
 
-Response::Response(HttpRequest &req) : request(req)
+Response::Response(HttpRequest &req) : _server(NULL), _request(&req)
 {
 	_target_file = "";
 	_body.clear();
 	_body_length = 0;
-	response_content = "";
 	_response_body = "";
 	_location = "";
 	_code = 0;
 	_cgi = 0;
 	_cgi_response_length = 0;
 	_auto_index = 0;
+	_listing_view.json = false;
+	_listing_view.page = 1;
+	_listing_view.page_size = 0;
+	_file_fd = -1;
+	_file_size = 0;
+	_cached = NULL;
+	_cached_body = NULL;
+	_source = NULL;
+	_stream = NULL;
+	_upload = NULL;
+	_chunked = false;
+	_source_done = false;
+	_with_body = false;
+	_resolve_us = PHASE_UNTIMED;
+	_read_us = PHASE_UNTIMED;
 }
 
 /* Construit le type de contenu de la réponse 
@@ -49,54 +133,68 @@ Response::Response(HttpRequest &req) : request(req)
 	Si pas d'extension, type MIME par défaut */
 void	Response::contentType()
 {
-	response_content.append("Content-Type: ");
-	if(_target_file.rfind(".", std::string::npos) != std::string::npos && _code == 200)
-		response_content.append(mime.getMimeType(_target_file.substr(_target_file.rfind(".", std::string::npos))) );
+	size_t	dot = _target_file.rfind(".", std::string::npos);
+
+	_head.append("Content-Type: ");
+	if (_auto_index && _code == 200)
+		_head.append(_listing_view.json ? "application/json" : "text/html");
+	else if (dot != std::string::npos && _code == 200)
+		_head.append(mime.getMimeType(_target_file.substr(dot)));
 	else
-		response_content.append(mime.getMimeType("default"));
-	response_content.append("\r\n");
+		_head.append(mime.getMimeType("default"));
+	_head.crlf();
 }
 
 /* Construit la longueur du contenu  */
 void	Response::contentLength()
 {
-	std::stringstream ss;
-	ss << _response_body.length();
-	response_content.append("Content-Length: ");
-	response_content.append(ss.str());
-	response_content.append("\r\n");
+	if (_source)
+	{
+		if (_chunked)
+			_head.append("Transfer-Encoding: chunked\r\n");
+		return ;
+	}
+	_head.append("Content-Length: ");
+	if (_file_fd >= 0)
+		_head.number(_file_size);
+	else
+		_head.number(bodyInMemory().length());
+	_head.crlf();
 }
 
-/* Construit le header Connection */
+/* Construit le header Connection (doit refléter la décision de keepAlive()) */
 void	Response::connection()
 {
-	std::string conn = request.getHeader("connection");
-	if (conn == "close")
-		response_content.append("Connection: close\r\n");
+	if (keepAlive())
+		_head.append("Connection: keep-alive\r\n");
 	else
-		response_content.append("Connection: keep-alive\r\n");
+		_head.append("Connection: close\r\n");
+}
+
+/* La connexion reste ouverte après cette réponse ?
+	Un corps en flux (autoindex, CGI) n'a pas de Content-Length : seulement s'il part
+	en chunked (HTTP/1.1), sinon la fin est signalée par la fermeture.
+	Non plus pour une page d'erreur remplaçant un CGI (état du script inconnu) */
+bool	Response::keepAlive()
+{
+	return (_request && _request->keepAlive() && (!_cgi || _chunked) && (!_source || _chunked));
 }
 
 void	Response::server()
 {
-		response_content.append("Server: LETSGO\r\n");
+		_head.append("Server: LETSGO\r\n");
 }
 
 void    Response::location()
 {
 	if (_location.length())
-		response_content.append("Location: "+ _location +"\r\n");
+		_head.append("Location: ").append(_location).crlf();
 }
 
+/* Date mise en cache par HeaderWriter, reformatée au plus une fois par seconde */
 void	Response::date()
 {
-	char date[1000];
-	time_t now = time(0);
-	struct tm *tm = gmtime(&now);
-	strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S GMT", tm);
-	response_content.append("Date: ");
-	response_content.append(date);
-	response_content.append("\r\n");
+	_head.date();
 }
 
 
@@ -111,8 +209,15 @@ void	Response::date()
 */
 void	Response::setHeaders()
 {
-	contentType();
-	contentLength();
+	if (_cached && _code == 200)
+		_head.append(_cached->headers);		// Content-Type, Content-Length, ETag, Last-Modified
+	else if (_cached && _code == 304)
+		_head.append(_cached->validators);	// 304 : pas de corps
+	else
+	{
+		contentType();
+		contentLength();
+	}
 	connection();
 	server();
 	location();
@@ -122,43 +227,24 @@ void	Response::setHeaders()
 	{
 		/* Trouve la location la plus correspondante pour le chemin de la requête
 		   et ajoute le header Allow en fonction des méthodes autorisées */
-		const std::vector<Location> &locs = _server.getLocations();
-		const Location *best = NULL;
-		size_t biggest_match = 0;
-		const std::string &path = request.getPath();
-		for (std::vector<Location>::const_iterator it = locs.begin(); it != locs.end(); ++it)
-		{
-			const std::string &lp = it->getPath();
-			if (path.find(lp) == 0)
-			{
-				if (lp == "/" || path.length() == lp.length() || path[lp.length()] == '/')
-				{
-					if (lp.length() > biggest_match)
-					{
-						biggest_match = lp.length();
-						best = &(*it);
-					}
-				}
-			}
-		}
+		const Location *best = _server->matchLocation(_request->getPath());
 		if (best)  // Si on a trouvé une location correspondante ; Récupère les méthodes autorisées de cette location
 		{
-			const std::vector<short> methods = best->getMethods();
-			std::string allow = "Allow: ";
+			const std::vector<short> &methods = best->getMethods();
 			bool first = true;
+			_head.append("Allow: ");
 			// Order: GET, POST, DELETE
 			if (methods.size() >= 3)
 			{
-				if (methods[0]) { allow += "GET"; first = false; }
-				if (methods[1]) { if (!first) allow += ", "; allow += "POST"; first = false; }
-				if (methods[2]) { if (!first) allow += ", "; allow += "DELETE"; }
+				if (methods[0]) { _head.append("GET"); first = false; }
+				if (methods[1]) { if (!first) _head.append(", "); _head.append("POST"); first = false; }
+				if (methods[2]) { if (!first) _head.append(", "); _head.append("DELETE"); }
 			}
-			allow += "\r\n";
-			response_content.append(allow);
+			_head.crlf();
 		}
 	}
 	date();
-	response_content.append("\r\n");
+	_head.crlf();
 }
 
 static bool fileExists (const std::string& f)
@@ -176,9 +262,9 @@ static bool isDirectory(std::string path)
 	return (S_ISDIR(file_stat.st_mode));
 }
 
-static bool isAllowedMethod(HttpMethod &method, Location &location, short &code)
+static bool isAllowedMethod(HttpMethod &method, const Location &location, short &code)
 {
-	std::vector<short> methods = location.getMethods();
+	const std::vector<short> &methods = location.getMethods();
 	if ((method == GET && !methods[0]) || (method == POST && !methods[1]) ||
 		(method == DELETE && !methods[2]))
 	{
@@ -189,7 +275,7 @@ static bool isAllowedMethod(HttpMethod &method, Location &location, short &code)
 }
 
 /* Vérifie si la location a une redirection configurée */
-static bool	checkReturn(Location &loc, short &code, std::string &location)
+static bool	checkReturn(const Location &loc, short &code, std::string &location)
 {
 	if (!loc.getReturn().empty())
 	{
@@ -225,29 +311,24 @@ static std::string combinePaths(std::string p1, std::string p2, std::string p3)
 }
 
 /* Remplace le chemin par l'alias */
-static void replaceAlias(Location &location, HttpRequest &request, std::string &target_file) {
+static void replaceAlias(const Location &location, HttpRequest &request, std::string &target_file) {
 	target_file = combinePaths(location.getAlias(), request.getPath().substr(location.getPath().length()), "");
 }
 
 /* Ajoute le chemin racine */
-static void appendRoot(Location &location, HttpRequest &request, std::string &target_file) {
+static void appendRoot(const Location &location, HttpRequest &request, std::string &target_file) {
 	target_file = combinePaths(location.getRootLocation(), request.getPath(), "");
 }
 
 /* Prépare et lance l'exécution d'un script CGI */
-int Response::handleCgiTemp(std::string &location_key)
+int Response::handleCgiTemp(const Location &location)
 {
 	std::string path;
 	path = _target_file;					// Récupère le chemin du fichier script CGI
 	cgi_obj.clear();
 	cgi_obj.setCgiPath(path);				// Définit le chemin du script CGI à exécuter
 	_cgi = 1;								// Flag indiquant qu'une requête CGI est en cours
-	if (pipe(_cgi_fd) < 0)					// Crée un pipe pour la communication entre processus
-	{										// _cgi_fd[0] = lecture, _cgi_fd[1] = écriture
-		_code = 500;
-		return (1);
-	}
-	cgi_obj.initEnvCgi(request, _server.getLocationKey(location_key)); // Initialise les variables d'environnement CGI (REQUEST_METHOD, QUERY_STRING, etc.)
+	cgi_obj.initEnvCgi(*_request, location); // Initialise les variables d'environnement CGI (REQUEST_METHOD, QUERY_STRING, etc.)
 	cgi_obj.execute(this->_code);			// Execute le script CGI et stocke le code de statut dans _code
 	return (0);
 }
@@ -262,21 +343,21 @@ int Response::handleCgiTemp(std::string &location_key)
 5		Fichier existe						
 6		Fichier lisible ET exécutable		
 7		Méthode HTTP autorisée				
-8		Création du pipe					
-9		Exécution du CGI-						*/
-int	Response::handleCgi(std::string &location_key)
+8		Variables d'environnement
+9		Exécution du CGI (fork, ou interpréteur du pool avec cgi_pool)	*/
+int	Response::handleCgi(const Location &location)
 {
 	std::string path;
 	std::string exten;
 	size_t		pos;
 
-	path = this->request.getPath();
+	path = _request->getPath();
 	if (!path.empty() && path[0] == '/')		// Supprime le '/' initial si présent
 		path.erase(0, 1);						// "/cgi-bin/script.py" → "cgi-bin/script.py"
 	if (path == "cgi-bin")						// Si le chemin est exactement "cgi-bin", ajoute le fichier index
-		path += "/" + _server.getLocationKey(location_key)->getIndexLocation();
+		path += "/" + location.getIndexLocation();
 	else if (path == "cgi-bin/")				// Si le chemin est "cgi-bin/", ajoute juste le fichier index
-		path.append(_server.getLocationKey(location_key)->getIndexLocation()); // Ex: "cgi-bin/" → "cgi-bin/index.py"
+		path.append(location.getIndexLocation()); // Ex: "cgi-bin/" → "cgi-bin/index.py"
 
 	pos = path.find(".");						// Cherche le point de l'extension error 501 si pas trouvé
 	if (pos == std::string::npos)
@@ -300,43 +381,51 @@ int	Response::handleCgi(std::string &location_key)
 		_code = 403;
 		return (1);
 	}
-	if (isAllowedMethod(request.getMethod(), *_server.getLocationKey(location_key), _code)) 	// Vérifie si la méthode (GET, POST, etc.) est autorisée
+	if (isAllowedMethod(_request->getMethod(), location, _code)) 	// Vérifie si la méthode (GET, POST, etc.) est autorisée
 		return (1);
 	cgi_obj.clear();						// Nettoie l'objet CGI
 	cgi_obj.setCgiPath(path);				// Définit le script à exécuter
 	_cgi = 1;								// Active le flag CGI
-	if (pipe(_cgi_fd) < 0)					// CRÉATION DU PIPE POUR LA COMMUNICATION
-	{
-		_code = 500;
-		return (1);
-	}
-	cgi_obj.initEnv(request, _server.getLocationKey(location_key)); // INITIALISATION DES VARIABLES D'ENVIRONNEMENT CGI
-	cgi_obj.execute(this->_code);			// EXÉCUTION DU SCRIPT CGI
+	cgi_obj.initEnv(*_request, location); // INITIALISATION DES VARIABLES D'ENVIRONNEMENT CGI
+	if (location.getCgiPool() && cgi_obj.getInterpreter().find("python") != std::string::npos)
+		cgi_obj.usePool(location.getCgiPool(), location.getCgiPoolMaxRequests()); // Interpréteur du pool, choisi par ServerManager
+	else
+		cgi_obj.execute(this->_code);			// EXÉCUTION DU SCRIPT CGI
 	return (0);
 }
 
-/*
-Compare l'URI avec les emplacements du fichier de configuration et tente de trouver la meilleure correspondance.
-Si une correspondance est trouvée, location_key est défini sur cet emplacement ; sinon, location_key est une chaîne vide.	*/
-static void	getLocationMatch(std::string &path, std::vector<Location> locations, std::string &location_key)
+/* Valeur de key dans la query string ("format=json&page=3", "page" -> "3"), vide si absente */
+static std::string	queryValue(const std::string &query, const std::string &key)
 {
-	size_t biggest_match = 0;									// Garde la longueur de la meilleure correspondance
+	size_t	start = 0;
 
-	for(std::vector<Location>::const_iterator it = locations.begin(); it != locations.end(); ++it) 	// Parcourt toutes les locations définies dans config
+	while (start < query.size())
 	{
-		if(path.find(it->getPath()) == 0) {
-			if( it->getPath() == "/" ||						// Vérifie si le chemin commence par le chemin de la location
-			 path.length() == it->getPath().length() ||		// Match exact
-			 path[it->getPath().length()] == '/')			// Prochain caractère est '/'
-			{
-				if(it->getPath().length() > biggest_match){ // Si cette location est plus spécifique que la précédente
-					biggest_match = it->getPath().length();	// Met à jour la longueur
-					location_key = it->getPath();			// Sauvegarde la clé de location
-				}
-			}
-		}
+		size_t	end = query.find('&', start);
+		if (end == std::string::npos)
+			end = query.size();
+		if (query.compare(start, key.size(), key) == 0 && start + key.size() < end && query[start + key.size()] == '=')
+			return (query.substr(start + key.size() + 1, end - start - key.size() - 1));
+		start = end + 1;
 	}
+	return ("");
+}
+
+/* Format et page du listing : ceux de la location, ?format=html|json et ?page=N
+	(à partir de 1) les remplacent pour cette requête */
+void	Response::listingView(const Location &location)
+{
+	const std::string	&query = _request->getQuery();
+	std::string			format = queryValue(query, "format");
+	std::string			page = queryValue(query, "page");
+
+	_listing_view.json = (format.empty() ? location.getAutoindexJson() : format == "json");
+	_listing_view.page_size = location.getAutoindexPageSize();
+	_listing_view.page = 1;
+	if (!page.empty() && page.size() <= 9 && page.find_first_not_of("0123456789") == std::string::npos)
+		_listing_view.page = std::max(atoi(page.c_str()), 1);
 }
+
 /*
 	Cherche quelle location correspond à l'URL
 	Vérifie les permissions (méthode, taille body)
@@ -347,17 +436,16 @@ static void	getLocationMatch(std::string &path, std::vector<Location> locations,
 	Retourne 0 si tout OK, 1 si erreur/redirection */
 int	Response::handleTarget()
 {
-	std::string location_key;
-	getLocationMatch(request.getPath(), _server.getLocations(), location_key);
-	if (location_key.length() > 0)
+	const Location *match = _server->matchLocation(_request->getPath());
+	if (match)
 	{
-		Location target_location = *_server.getLocationKey(location_key);
+		const Location &target_location = *match;
 
-	if (isAllowedMethod(request.getMethod(), target_location, _code))
+	if (isAllowedMethod(_request->getMethod(), target_location, _code))
 	{
 		return (1);
 	}
-		if (request.getBody().length() > target_location.getMaxBodySize())
+		if (_request->getBodySize() > target_location.getMaxBodySize())
 		{
 			_code = 413;
 			return (1);
@@ -366,19 +454,19 @@ int	Response::handleTarget()
 			return (1);
 
 		if (target_location.getPath().find("cgi-bin") != std::string::npos){
-			return (handleCgi(location_key));
+			return (handleCgi(target_location));
 		}
 
 		if (!target_location.getAlias().empty()){
-			replaceAlias(target_location, request, _target_file);
+			replaceAlias(target_location, *_request, _target_file);
 		}
 		else
-			appendRoot(target_location, request, _target_file);
+			appendRoot(target_location, *_request, _target_file);
 
 		if (!target_location.getCgiExtension().empty())
 		{
 			if (_target_file.rfind(target_location.getCgiExtension()[0]) != std::string::npos) {
-				return (handleCgiTemp(location_key));
+				return (handleCgiTemp(target_location));
 			}
 		}
 
@@ -387,19 +475,23 @@ int	Response::handleTarget()
 			if (_target_file[_target_file.length() - 1] != '/')
 			{
 				_code = 301;
-				_location = request.getPath() + "/";
+				_location = _request->getPath() + "/";
 				return (1);
 			}
+			/* Formulaire envoyé vers un répertoire : chaque fichier y est déposé sous son nom */
+			if (_request->getMethod() == POST && _request->getMultiformFlag())
+				return (0);
 			if (!target_location.getIndexLocation().empty())
 					_target_file += target_location.getIndexLocation();
 			else
-				_target_file += _server.getIndex();
+				_target_file += _server->getIndex();
 			if (!fileExists(_target_file))
 			{
 				if (target_location.getAutoindex())
 				{
 					_target_file.erase(_target_file.find_last_of('/') + 1);
 					_auto_index = true;
+					listingView(target_location);
 					return (0);
 				}
 				else
@@ -412,9 +504,9 @@ int	Response::handleTarget()
 			{
 				_code = 301;
 				if (!target_location.getIndexLocation().empty())
-					_location = combinePaths(request.getPath(), target_location.getIndexLocation(), "");
+					_location = combinePaths(_request->getPath(), target_location.getIndexLocation(), "");
 				else
-					_location = combinePaths(request.getPath(), _server.getIndex(), "");
+					_location = combinePaths(_request->getPath(), _server->getIndex(), "");
 				if (_location[_location.length() - 1] != '/')
 					_location.insert(_location.end(), '/');
 				return (1);
@@ -423,16 +515,16 @@ int	Response::handleTarget()
 	}
 	else
 	{
-		_target_file = combinePaths(_server.getRoot(), request.getPath(), "");
+		_target_file = combinePaths(_server->getRoot(), _request->getPath(), "");
 		if (isDirectory(_target_file))
 		{
 			if (_target_file[_target_file.length() - 1] != '/')
 			{
 				_code = 301;
-				_location = request.getPath() + "/";
+				_location = _request->getPath() + "/";
 				return (1);
 			}
-			_target_file += _server.getIndex();
+			_target_file += _server->getIndex();
 			if (!fileExists(_target_file))
 			{
 				_code = 403;
@@ -441,7 +533,7 @@ int	Response::handleTarget()
 			if (isDirectory(_target_file))
 			{
 				_code = 301;
-				_location = combinePaths(request.getPath(), _server.getIndex(), "");
+				_location = combinePaths(_request->getPath(), _server->getIndex(), "");
 				if(_location[_location.length() - 1] != '/')
 				{
 					_location.insert(_location.end(), '/');
@@ -455,9 +547,9 @@ int	Response::handleTarget()
 
 bool Response::reqError()
 {
-	if(request.errorCode())
+	if(_request->errorCode())
 	{
-		_code = request.errorCode();
+		_code = _request->errorCode();
 		return (1);
 	}
 	return (0);
@@ -472,10 +564,14 @@ void Response::buildErrorBody()
 {
 	short original_code = _code;
 
-	if (!_server.getErrorPages().count(original_code) ||
-		_server.getErrorPages().at(original_code).empty() ||
-		request.getMethod() == DELETE ||
-		request.getMethod() == POST)
+	releaseFile();
+	releaseBody();
+	_cached = NULL;
+
+	if (!_server->getErrorPages().count(original_code) ||
+		_server->getErrorPages().at(original_code).empty() ||
+		_request->getMethod() == DELETE ||
+		_request->getMethod() == POST)
 	{
 		/* Retour à la page d'erreur par défaut */
 		setServerDefaultErrorPages();
@@ -483,8 +579,8 @@ void Response::buildErrorBody()
 		return;
 	}
 
-	std::string error_page_path = _server.getErrorPages().at(original_code);
-	_target_file = _server.getRoot() + error_page_path;
+	std::string error_page_path = _server->getErrorPages().at(original_code);
+	_target_file = _server->getRoot() + error_page_path;
 
 	/* Essayer de lire la page d'erreur personnalisée */
 	if (readFile() == 0)
@@ -498,29 +594,95 @@ void Response::buildErrorBody()
 	_response_body = getErrorPage(_code);
 }
 
+/* En-tête d'un POST multipart reçu, corps pas encore lu : vers une location sans
+	script, le MultipartParser est créé dès maintenant et la requête le nourrit au
+	fil de la réception (chaque fichier écrit une fois, à côté de sa destination).
+	Un CGI lit le corps brut : il reste au BodySink. Une cible refusée (405, 301...)
+	est signalée par buildResponse() comme avant, une fois le corps reçu.
+	buildBody() rejoue handleTarget() : ce qu'il a posé est remis à zéro ici */
+void	Response::streamUpload()
+{
+	if (_request->getBoundary().empty() || !offloadable())
+		return ;
+	if (handleTarget() == 0)
+	{
+		_upload = new MultipartParser(_request->getBoundary(), _target_file, isDirectory(_target_file));
+		_request->setUpload(_upload);
+	}
+	_target_file.clear();
+	_location.clear();
+	_code = 0;
+}
+
 /* Génére de réponse HTTP
  Elle coordonne toutes les étapes de construction d'une réponse HTTP complète */
 void	 Response::buildResponse()
+{
+	resolveBody();
+	buildHead();
+}
+
+/* La partie disque peut partir dans un thread de FilePool (aio_threads) :
+	pas pour une location à scripts, un CGI lance un processus et ses pipes
+	sont suivis par la boucle d'événements */
+bool	Response::offloadable() const
+{
+	const Location *match = _server->matchLocation(_request->getPath());
+
+	if (!match)
+		return (true);
+	return (match->getPath().find("cgi-bin") == std::string::npos && match->getCgiExtension().empty());
+}
+
+/* Tout ce qui touche au disque : stat() de la cible, fichier du cache, dépôt POST,
+	remove() DELETE, ouverture du dossier, page d'erreur personnalisée.
+	Dans un thread de FilePool, n'utilise que la requête et la réponse de ce client,
+	la config (immuable) et le cache de fichiers (verrouillé) */
+void	Response::resolveBody()
 {
 	if (reqError() || buildBody())
 			buildErrorBody();
 	if (_cgi)
+	{
+		StreamSource *cgi_output = new StreamSource();
+
+		attachBody(cgi_output);
+		_stream = cgi_output;
 		return ;
+	}
 	else if (_auto_index)
 	{
-		if (buildHtmlIndex(_target_file, _body, _body_length))
+		DirectorySource *listing = new DirectorySource(directories, _target_file, _request->getPath(), _listing_view);
+
+		if (!listing->isOpen())
 		{
+			delete listing;
 			_code = 500;
 			buildErrorBody();
 		}
 		else
+		{
 			_code = 200;
-		_response_body.insert(_response_body.begin(), _body.begin(), _body.end());
+			attachBody(listing);
+		}
 	}
+}
+
+/* Ligne d'état et en-têtes, toujours dans la boucle d'événements
+	(Date en cache, métriques du processus) */
+void	Response::buildHead()
+{
+	if (_resolve_us != PHASE_UNTIMED)
+		Metrics::record(PHASE_RESOLVE, _resolve_us);
+	if (_read_us != PHASE_UNTIMED)
+		Metrics::record(PHASE_FILE_READ, _read_us);
+	_resolve_us = PHASE_UNTIMED;
+	_read_us = PHASE_UNTIMED;
+	if (_cgi)
+		return ;
 	setStatusLine();
 	setHeaders();
-	if (request.getMethod() == GET || _code != 200)
-			response_content.append(_response_body);
+	_with_body = (_request->getMethod() == GET || _code != 200);
 }
 /*
 ┌─────────────────────────────────────┐
@@ -557,82 +719,119 @@ void	 Response::buildResponse()
        └──────┬──────┘
               ↓
 ┌─────────────────────────────────────┐
-│ 3. Assemblage final                 │
+│ 3. En-têtes                         │
 │    setStatusLine()                  │
 │    setHeaders()                     │
-│    append body si nécessaire        │
+│    corps envoyé à côté (writev)     │
 └─────────────────────────────────────┘
               ↓
 	[Réponse HTTP complète] */
 
 void	Response::setErrorResponse(short code)
 {
-	response_content = "";
+	_head.clear();
 	_code = code;
 	_response_body = "";
 	buildErrorBody();
 	setStatusLine();
 	setHeaders();
-	response_content.append(_response_body);
+	_with_body = true;
 }
 
-/* Renvoie la réponse entière (en-têtes + corps) */
-std::string Response::getRes()	{
-	return (response_content);
+/* Réponse 200 produite par le serveur lui-même (page /__status)
+	Le type MIME vient de l'extension de name (".json" → application/json) */
+void	Response::setGeneratedResponse(const std::string &body, const std::string &name)
+{
+	_head.clear();
+	_code = 200;
+	_target_file = name;
+	_response_body = body;
+	setStatusLine();
+	setHeaders();
+	_with_body = true;
 }
 
-/* taille (en-têtes + corps) */
+/* taille (en-têtes + corps en mémoire) */
 size_t Response::getLen() const	{
-	return (response_content.length());
+	return (_head.size() + (_with_body ? bodyInMemory().size() : 0));
 }
 
-/* Construit la ligne d'état en fonction du code d'état. */
+/* Ce qui reste à envoyer à partir de offset, sans recopier : en-têtes puis corps
+	en mémoire, au plus 2 tranches pour un seul writev(). Renvoie le nombre de tranches */
+int		Response::getVector(struct iovec *iov, size_t offset) const
+{
+	const std::string	&content = bodyInMemory();
+	int					count = 0;
+	size_t				body = (_with_body ? content.size() : 0);
+
+	if (offset < _head.size())
+	{
+		iov[count].iov_base = const_cast<char *>(_head.data() + offset);
+		iov[count++].iov_len = _head.size() - offset;
+		offset = 0;
+	}
+	else
+		offset -= _head.size();
+	if (offset < body)
+	{
+		iov[count].iov_base = const_cast<char *>(content.data() + offset);
+		iov[count++].iov_len = body - offset;
+	}
+	return (count);
+}
+
+/* Construit la ligne d'état en fonction du code d'état (précalculée par HeaderWriter) */
 void	Response::setStatusLine()
 {
-	response_content.append("HTTP/1.1 " + toString(_code) + " ");
-	response_content.append(statusCodeString(_code));
-	response_content.append("\r\n");
+	_head.statusLine(_code);
 }
 
 /* Construit le corps de la réponse */
 int	Response::buildBody()
 {
-	if (request.getBody().length() > _server.getClientMaxBodySize())
+	if (_request->getBodySize() > _server->getClientMaxBodySize())
 	{
 		_code = 413;
 		return (1);
 	}
-	if ( handleTarget() )
+	uint64_t start = monotonicMicros();
+	int target_error = handleTarget();
+	_resolve_us = monotonicMicros() - start;
+	if (target_error)
 		return (1);
 	if (_cgi || _auto_index)
 		return (0);
 	if (_code)
 		return (0);
-	if (request.getMethod() == GET)
+	if (_request->getMethod() == GET)
 	{
-		if (readFile())
+		start = monotonicMicros();
+		int open_error = openFile();
+		_read_us = monotonicMicros() - start;
+		if (open_error)
 			return (1);
+		if (notModified())
+		{
+			_file_fd = -1;			// pas de corps ; l'entrée reste épinglée pour ses validateurs
+			_file_size = 0;
+			_cached_body = NULL;
+			_code = 304;
+			return (0);
+		}
 	}
-	else if (request.getMethod() == POST)
+	else if (_request->getMethod() == POST)
 	{
 		bool existed = fileExists(_target_file);
-		std::ofstream file(_target_file.c_str(), std::ios::binary);
-		if (file.fail())
+		if (_request->getMultiformFlag())
+			return (saveMultipart());
+		/* Corps brut : déposé tel quel (rename() du fichier temporaire s'il y en a un) */
+		if (!_request->getBody().saveAs(_target_file))
 		{
 			_code = 403;
 			return (1);
 		}
-
-		if (request.getMultiformFlag())
-		{
-			std::string body = request.getBody();
-			body = removeBoundary(body, request.getBoundary());
-			file.write(body.c_str(), body.length());
-		}
-		else
-		{
-			file.write(request.getBody().c_str(), request.getBody().length());
-		}
+		files.invalidate(_target_file);
+		directories.invalidate(_target_file);
 		/* Définit les codes d'état appropriés pour POST */
 		if (existed)
 		{
@@ -641,10 +840,10 @@ int	Response::buildBody()
 		else
 		{
 			_code = 201; /* Créé pour une nouvelle ressource */
-			_location = request.getPath(); /* Fournit l'URI de la ressource */
+			_location = _request->getPath(); /* Fournit l'URI de la ressource */
 		}
 	}
-	else if (request.getMethod() == DELETE)
+	else if (_request->getMethod() == DELETE)
 	{
 		if (!fileExists(_target_file))
 		{
@@ -656,6 +855,8 @@ int	Response::buildBody()
 			_code = 403;
 			return (1);
 		}
+		files.invalidate(_target_file);
+		directories.invalidate(_target_file);
 	}
 	/* Si aucun code d'état spécifique n'a été défini par les gestionnaires ci-dessus,
 	   définit le code d'état par défaut à 200 OK */
@@ -680,31 +881,300 @@ int Response::readFile()
 	return (0);
 }
 
-void	Response::setServer(ServerConfig &server)	{
-	_server = server;
+/* Récupère le fichier dans le cache sans passer par le disque s'il n'a pas changé
+	Petit fichier : le corps est lu dans l'entrée elle-même, épinglée jusqu'à releaseFile()
+	Gros fichier : seul le fd est gardé, le corps partira par sendfile() */
+int Response::openFile()
+{
+	_cached = files.acquire(_target_file);
+	if (!_cached)
+	{
+		_code = 404;
+		return (1);
+	}
+	if (_cached->in_memory)
+		_cached_body = &_cached->content;
+	else
+	{
+		_file_fd = _cached->fd;
+		_file_size = _cached->size;
+	}
+	return (0);
 }
 
-void	Response::setRequest(HttpRequest &req)	{
-	request = req;
+/* Requête conditionnelle (RFC 7232) : le client a déjà cette version du fichier ?
+	If-None-Match prioritaire : "*" ou l'un des ETag listés (comparaison faible : W/ ignoré)
+	Sinon If-Modified-Since : fichier pas modifié depuis la date donnée */
+bool	Response::notModified()
+{
+	std::string	value;
+
+	if (_request->getHeader("if-none-match", value))
+	{
+		std::stringstream	list(value);
+		std::string			tag;
+
+		while (std::getline(list, tag, ','))
+		{
+			size_t start = tag.find_first_not_of(" \t");
+			size_t end = tag.find_last_not_of(" \t");
+			if (start == std::string::npos)
+				continue ;
+			tag = tag.substr(start, end - start + 1);
+			if (tag.compare(0, 2, "W/") == 0)
+				tag.erase(0, 2);
+			if (tag == "*" || tag == _cached->etag)
+				return (true);
+		}
+		return (false);
+	}
+	if (!_request->getHeader("if-modified-since", value))
+		return (false);
+	if (value == _cached->last_modified)
+		return (true);
+	time_t since = parseHttpDate(value);
+	return (since != (time_t)-1 && _cached->mtime <= since);
+}
+
+/* Rend l'entrée (et son fd) au cache (réponse envoyée ou abandonnée) */
+void	Response::releaseFile()
+{
+	if (_cached)
+		files.release(_cached);
+	_cached = NULL;
+	_cached_body = NULL;
+	_file_fd = -1;
+	_file_size = 0;
 }
 
-/* Supprime le début de la réponse */
-void	Response::cutRes(size_t i)	{
-	response_content = response_content.substr(i);
+/* Corps en mémoire : celui de l'entrée du cache s'il y en a une, sinon _response_body */
+const std::string	&Response::bodyInMemory() const
+{
+	return (_cached_body ? *_cached_body : _response_body);
+}
+
+/* Le corps sera tiré de source par pullBody() : pas de Content-Length connu d'avance */
+void	Response::attachBody(BodySource *source)
+{
+	releaseBody();
+	_source = source;
+	_chunked = !_cgi && _request->isHttp11();
+	_source_done = false;
+}
+
+void	Response::releaseBody()
+{
+	delete _source;
+	_source = NULL;
+	_stream = NULL;
+	_chunked = false;
+	_source_done = false;
+}
+
+/* Upload abandonné ou terminé : les fichiers pas encore en place sont supprimés */
+void	Response::releaseUpload()
+{
+	delete _upload;
+	_upload = NULL;
+}
+
+bool	Response::hasBodySource() const	{
+	return (_source != NULL);
+}
+
+StreamSource	*Response::cgiStream()	{
+	return (_stream);
+}
+
+size_t	Response::getBufferSize()	{
+	return (_server ? _server->getOutputBufferSize() : OUTPUT_BUFFER_SIZE);
+}
+
+/* La sortie CGI peut partir vers le client : en-têtes complets, plafond atteint ou script terminé */
+bool	Response::cgiReady()
+{
+	if (!_stream)
+		return (false);
+	if (_stream->pulled() || _stream->finished())
+		return (true);
+	return (_stream->buffered() >= getBufferSize() || cgiHeaderEnd() != std::string::npos);
+}
+
+/* Longueur des en-têtes CGI, ligne vide comprise (npos tant qu'elle n'est pas arrivée).
+	Les scripts terminent leurs lignes par "\r\n" ou par "\n" seul */
+size_t	Response::cgiHeaderEnd()
+{
+	size_t	lf = _stream->find("\n\n");
+	size_t	crlf = _stream->find("\n\r\n");
+
+	if (lf == std::string::npos && crlf == std::string::npos)
+		return (std::string::npos);
+	if (crlf == std::string::npos || (lf != std::string::npos && lf < crlf))
+		return (lf + 2);
+	return (crlf + 3);
+}
+
+/*	En-têtes écrits par le script (RFC 3875 §6.3) → en-tête HTTP, une seule fois,
+	ajouté à out ; le corps suit ensuite tranche par tranche sans autre copie.
+	- Statut : "Status: 404 Not Found", ou une ligne "HTTP/1.1 404 ..." en tête,
+	  sinon 302 si Location est présent, sinon 200
+	- Content-Type, Location, Set-Cookie... recopiés
+	- Content-Length, Transfer-Encoding, Connection ignorés : le cadrage est le nôtre,
+	  chunked en HTTP/1.1 (la connexion peut rester ouverte), fin à la fermeture en HTTP/1.0
+	Exemple : "Status: 302\nLocation: /a\n\n" → "HTTP/1.1 302 Found\r\nLocation: /a\r\n
+	Transfer-Encoding: chunked\r\nConnection: keep-alive\r\n..."
+	Renvoie false si la sortie ne commence pas par des en-têtes valides */
+bool	Response::cgiHead(std::string &out)
+{
+	size_t		end = cgiHeaderEnd();
+	std::string	head;
+	std::string	fields;
+	std::string	line;
+	short		code = 200;
+	bool		has_status = false;
+	bool		has_location = false;
+	size_t		count = 0;
+
+	if (end == std::string::npos)
+		return (false);
+	_stream->pull(head, end);
+	std::istringstream	lines(head);
+	while (std::getline(lines, line))
+	{
+		if (!line.empty() && line[line.size() - 1] == '\r')
+			line.erase(line.size() - 1);
+		if (line.empty())
+			break ;
+		if (count++ == 0 && line.compare(0, 5, "HTTP/") == 0 && line.size() >= 12)
+		{
+			code = atoi(line.c_str() + 9);
+			has_status = true;
+			continue ;
+		}
+		size_t	colon = line.find(':');
+		if (colon == std::string::npos || colon == 0)
+			return (false);
+		std::string	name = line.substr(0, colon);
+		for (size_t i = 0; i < name.size(); i++)
+			name[i] = std::tolower(name[i]);
+		if (name == "status")
+		{
+			code = atoi(line.c_str() + colon + 1);
+			has_status = true;
+		}
+		else if (name != "content-length" && name != "transfer-encoding" && name != "connection")
+		{
+			has_location = has_location || name == "location";
+			fields.append(line).append("\r\n");
+		}
+	}
+	if (count == 0 || code < 200 || code > 599)
+		return (false);
+	if (!has_status && has_location)
+		code = 302;
+	_code = code;
+	_chunked = _request->isHttp11() && code != 204 && code != 304;
+	_head.clear();
+	setStatusLine();
+	_head.append(fields);
+	contentLength();
+	connection();
+	server();
+	date();
+	_head.crlf();
+	out.append(_head.data(), _head.size());
+	_head.clear();
+	return (true);
+}
+
+/*	Tranche suivante du corps (au plus max octets de données), ajoutée à out.
+	En HTTP/1.1 chaque tranche est encadrée en chunked : "<taille hex>\r\n<données>\r\n",
+	et la fin du corps est signalée par "0\r\n\r\n".
+	La première tranche d'un CGI commence par l'en-tête construit par cgiHead() ;
+	_code prend le statut envoyé (journal d'accès). */
+BodySource::Status	Response::pullBody(std::string &out, size_t max)
+{
+	BodySource::Status	status;
+	size_t				start = out.size();
+
+	bool				first_cgi_slice = (_stream && !_stream->pulled());
+
+	if (!_source || _source_done)
+		return (BodySource::BODY_END);
+	if (first_cgi_slice && !cgiHead(out))
+	{
+		/* Sortie sans en-têtes valides : page 502 à la place, avec son Content-Length
+			(_source masqué pour setHeaders() ; le script est arrêté à la fermeture) */
+		BodySource	*source = _source;
+
+		_source = NULL;
+		setErrorResponse(502);
+		_source = source;
+		out.append(_head.data(), _head.size());
+		out.append(_response_body);
+		_head.clear();
+		_with_body = false;
+		_source_done = true;
+		return (BodySource::BODY_END);
+	}
+	size_t data_start = out.size();
+	status = _source->pull(out, max);
+	if (_chunked && out.size() > data_start)
+	{
+		std::stringstream ss;
+		ss << std::hex << (out.size() - data_start) << "\r\n";
+		out.insert(data_start, ss.str());
+		out.append("\r\n");
+	}
+	if (status == BodySource::BODY_END)
+	{
+		if (_chunked)
+			out.append("0\r\n\r\n");
+		_source_done = true;
+		if (out.size() > start)
+			return (BodySource::BODY_DATA);
+	}
+	return (status);
+}
+
+int		Response::getFileFd() const	{
+	return (_file_fd);
+}
+
+off_t	Response::getFileSize() const	{
+	return (_file_size);
+}
+
+/* La config et la requête sont empruntées, pas copiées : la ServerConfig vit dans
+	ServerManager::_servers et la requête dans le Client, tous deux plus longtemps que la réponse */
+void	Response::setServer(const ServerConfig &server)	{
+	_server = &server;
+}
+
+void	Response::setRequest(HttpRequest &req)	{
+	_request = &req;
 }
 
 void	Response::clear()
 {
+	releaseFile();
+	releaseBody();
+	releaseUpload();
+	_cached = NULL;
 	_target_file.clear();
 	_body.clear();
 	_body_length = 0;
-	response_content.clear();
+	_head.clear();
+	_with_body = false;
 	_response_body.clear();
 	_location.clear();
 	_code = 0;
 	_cgi = 0;
 	_cgi_response_length = 0;
 	_auto_index = 0;
+	_listing_view.json = false;
+	_listing_view.page = 1;
+	_listing_view.page_size = 0;
 }
 
 int	Response::getCode() const	{
@@ -715,71 +1185,39 @@ int	Response::getCgiState()	{
 	return (_cgi);
 }
 
-/* Supprime le boundary (Séparateur de contenu --boundary--) de la réponse */
-std::string Response::removeBoundary(std::string &body, std::string &boundary)
+/* Upload multipart/form-data : déjà découpé pendant la réception par le
+	MultipartParser de streamUpload(), chaque fichier écrit dans un temporaire à côté
+	de sa destination ; finish() les met en place une fois le corps entier valide.
+	Vers un répertoire, chaque fichier sous son nom ; sinon le premier remplace la cible.
+	201 si un fichier a été créé, 204 si tous existaient */
+int	Response::saveMultipart()
 {
-	std::string buffer;
-	std::string new_body;
-	std::string filename;
-	bool is_boundary = false;
-	bool is_content = false;
-
-	if (body.find("--" + boundary) != std::string::npos && body.find("--" + boundary + "--") != std::string::npos)
+	if (_request->getBoundary().empty())
 	{
-		for (size_t i = 0; i < body.size(); i++)
-		{
-			buffer.clear();
-			while(body[i] != '\n')
-			{
-				 buffer += body[i];
-				i++;
-			}
-			if (!buffer.compare(("--" + boundary + "--\r")))
-			{
-				is_content = true;
-				is_boundary = false;
-			}
-			if (!buffer.compare(("--" + boundary + "\r")))
-			{
-				is_boundary = true;
-			}
-			if (is_boundary)
-			{
-				if (!buffer.compare(0, 31, "Content-Disposition: form-data;"))
-				{
-					size_t start = buffer.find("filename=\"");
-					if (start != std::string::npos)
-					{
-						size_t end = buffer.find("\"", start + 10);
-						if (end != std::string::npos)
-						filename = buffer.substr(start + 10, end);
-					}
-				}
-				else if (!buffer.compare(0, 1, "\r") && !filename.empty())
-				{
-					is_boundary = false;
-					is_content = true;
-				}
-			}
-			else if (is_content)
-			{
-				if (!buffer.compare(("--" + boundary + "\r")))
-				{
-					is_boundary = true;
-				}
-				else if (!buffer.compare(("--" + boundary + "--\r")))
-				{
-				new_body.erase(new_body.end() - 1);
-					break ;
-				}
-				else
-					new_body += (buffer + "\n");
-			}
-		}
+		_code = 400;
+		return (1);
+	}
+	if (!_upload)							// cible refusée à l'en-tête, acceptée maintenant
+	{
+		_code = 409;
+		return (1);
 	}
+	MultipartParser	&parser = *_upload;
 
-	body.clear();
-	return (new_body);
+	if (!parser.finish() || parser.files().empty())
+	{
+		_code = parser.errorCode() ? parser.errorCode() : 400;
+		return (1);
+	}
+	for (size_t i = 0; i < parser.files().size(); ++i)
+	{
+		files.invalidate(parser.files()[i]);
+		directories.invalidate(parser.files()[i]);
+	}
+	_code = parser.created() ? 201 : 204;
+	if (_code == 201)
+		_location = _request->getPath();
+	return (0);
 }
 
 void	Response::setCgiState(int state)	{
@@ -19,9 +19,26 @@ ServerConfig::ServerConfig()
 	this->_server_name = "";
 	this->_root = "";
 	this->_client_max_body_size = MAX_CONTENT_LENGTH;
+	this->_output_buffer_size = OUTPUT_BUFFER_SIZE;
+	this->_cgi_max_output = CGI_MAX_OUTPUT;
+	this->_aio_threads = AIO_THREADS_OFF;
+	this->_client_body_buffer_size = CLIENT_BODY_BUFFER_SIZE;
+	this->_client_body_temp_path = CLIENT_BODY_TEMP_PATH;
+	this->_timeouts[TIMEOUT_HEADER] = CLIENT_HEADER_TIMEOUT;
+	this->_timeouts[TIMEOUT_BODY] = CLIENT_BODY_TIMEOUT;
+	this->_timeouts[TIMEOUT_SEND] = SEND_TIMEOUT;
+	this->_timeouts[TIMEOUT_KEEPALIVE] = KEEPALIVE_TIMEOUT;
+	this->_timeouts[TIMEOUT_CGI] = CGI_TIMEOUT;
+	this->_socket_options[SOCKET_BACKLOG] = LISTEN_BACKLOG;
+	this->_socket_options[SOCKET_NODELAY] = TCP_NODELAY_ON;
+	this->_socket_options[SOCKET_DEFER_ACCEPT] = TCP_DEFER_ACCEPT_OFF;
+	this->_socket_options[SOCKET_RCVBUF] = SOCKET_BUFFER_SYSTEM;
+	this->_socket_options[SOCKET_SNDBUF] = SOCKET_BUFFER_SYSTEM;
+	this->_socket_options[SOCKET_FASTOPEN] = TCP_FASTOPEN_OFF;
 	this->_index = "";
-	this->_listen_fd = 0;
+	this->_listen_fd = -1;
 	this->_autoindex = false;
+	this->_status_page = false;
 	this->initErrorPages();
 }
 
@@ -37,11 +54,22 @@ ServerConfig::ServerConfig(const ServerConfig &src)
 		this->_host 				= src._host;
 		this->_port 				= src._port;
 		this->_client_max_body_size = src._client_max_body_size;
+		this->_output_buffer_size	= src._output_buffer_size;
+		this->_cgi_max_output		= src._cgi_max_output;
+		this->_aio_threads			= src._aio_threads;
+		this->_client_body_buffer_size	= src._client_body_buffer_size;
+		this->_client_body_temp_path	= src._client_body_temp_path;
+		for (int i = 0; i < TIMEOUT_PHASES; i++)
+			this->_timeouts[i]		= src._timeouts[i];
+		for (int i = 0; i < SOCKET_OPTIONS; i++)
+			this->_socket_options[i] = src._socket_options[i];
 		this->_index 				= src._index;
 		this->_error_pages 			= src._error_pages;
 		this->_locations 			= src._locations;
+		this->_location_trie		= src._location_trie;
 		this->_listen_fd 			= src._listen_fd;
 		this->_autoindex 			= src._autoindex;
+		this->_status_page			= src._status_page;
 		this->_server_address 		= src._server_address;
 	}
 	return ;
@@ -57,11 +85,22 @@ ServerConfig &ServerConfig::operator = (const ServerConfig &src)
 		this->_port 				= src._port;
 		this->_host 				= src._host;
 		this->_client_max_body_size = src._client_max_body_size;
+		this->_output_buffer_size	= src._output_buffer_size;
+		this->_cgi_max_output		= src._cgi_max_output;
+		this->_aio_threads			= src._aio_threads;
+		this->_client_body_buffer_size	= src._client_body_buffer_size;
+		this->_client_body_temp_path	= src._client_body_temp_path;
+		for (int i = 0; i < TIMEOUT_PHASES; i++)
+			this->_timeouts[i]		= src._timeouts[i];
+		for (int i = 0; i < SOCKET_OPTIONS; i++)
+			this->_socket_options[i] = src._socket_options[i];
 		this->_index 				= src._index;
 		this->_error_pages 			= src._error_pages;
 		this->_locations 			= src._locations;
+		this->_location_trie		= src._location_trie;
 		this->_listen_fd 			= src._listen_fd;
 		this->_autoindex 			= src._autoindex;
+		this->_status_page			= src._status_page;
 		this->_server_address 		= src._server_address;
 	}
 	return (*this);
@@ -164,6 +203,122 @@ void ServerConfig::setClientMaxBodySize(std::string parametr)
 	this->_client_max_body_size = body_size;
 }
 
+/* Plafond mémoire par connexion pour les corps envoyés en flux (minimum 1024 octets) */
+void ServerConfig::setOutputBufferSize(std::string parametr)
+{
+	checkToken(parametr);
+	for (size_t i = 0; i < parametr.length(); i++)
+	{
+		if (parametr[i] < '0' || parametr[i] > '9')
+			throw ErrorException("Wrong syntax: output_buffer_size");
+	}
+	if (parametr.empty() || ft_stoi(parametr) < 1024)
+		throw ErrorException("Wrong syntax: output_buffer_size");
+	this->_output_buffer_size = ft_stoi(parametr);
+}
+
+/* Octets qu'un script CGI peut produire (en-têtes compris) avant d'être tué */
+void ServerConfig::setCgiMaxOutput(std::string parametr)
+{
+	checkToken(parametr);
+	for (size_t i = 0; i < parametr.length(); i++)
+	{
+		if (parametr[i] < '0' || parametr[i] > '9')
+			throw ErrorException("Wrong syntax: cgi_max_output");
+	}
+	if (parametr.empty() || ft_stoi(parametr) < 1)
+		throw ErrorException("Wrong syntax: cgi_max_output");
+	this->_cgi_max_output = ft_stoi(parametr);
+}
+
+/* Octets du corps d'une requête gardés en mémoire ; au-delà, fichier temporaire
+	(0 : toujours sur disque) */
+void ServerConfig::setClientBodyBufferSize(std::string parametr)
+{
+	checkToken(parametr);
+	for (size_t i = 0; i < parametr.length(); i++)
+	{
+		if (parametr[i] < '0' || parametr[i] > '9')
+			throw ErrorException("Wrong syntax: client_body_buffer_size");
+	}
+	if (parametr.empty())
+		throw ErrorException("Wrong syntax: client_body_buffer_size");
+	this->_client_body_buffer_size = ft_stoi(parametr);
+}
+
+/* Répertoire des corps de requête sur disque : doit exister et être inscriptible */
+void ServerConfig::setClientBodyTempPath(std::string parametr)
+{
+	checkToken(parametr);
+	if (ConfigFile::getTypePath(parametr) != 2 || ConfigFile::checkFile(parametr, W_OK) != 0)
+		throw ErrorException("client_body_temp_path is not a writable directory");
+	this->_client_body_temp_path = parametr;
+}
+
+/* Noms des directives de délai, dans l'ordre de TimeoutPhase */
+static const char	*timeoutDirectives[TIMEOUT_PHASES] = {
+	"client_header_timeout", "client_body_timeout", "send_timeout", "keepalive_timeout", "cgi_timeout"};
+
+/* Renvoie la phase correspondant à une directive de délai, -1 si ce n'en est pas une */
+int ServerConfig::timeoutDirective(const std::string &name)
+{
+	for (int i = 0; i < TIMEOUT_PHASES; i++)
+	{
+		if (name == timeoutDirectives[i])
+			return (i);
+	}
+	return (-1);
+}
+
+/* Délai d'une phase en secondes (au moins 1) */
+void ServerConfig::setTimeout(TimeoutPhase phase, std::string parametr)
+{
+	checkToken(parametr);
+	for (size_t i = 0; i < parametr.length(); i++)
+	{
+		if (parametr[i] < '0' || parametr[i] > '9')
+			throw ErrorException(std::string("Wrong syntax: ") + timeoutDirectives[phase]);
+	}
+	if (parametr.empty() || ft_stoi(parametr) < 1)
+		throw ErrorException(std::string("Wrong syntax: ") + timeoutDirectives[phase]);
+	this->_timeouts[phase] = ft_stoi(parametr);
+}
+
+static const char	*socketOptionDirectives[SOCKET_OPTIONS] = {
+	"listen_backlog", "tcp_nodelay", "tcp_defer_accept", "so_rcvbuf", "so_sndbuf", "tcp_fastopen"};
+
+/* Renvoie l'option correspondant à une directive de socket, -1 si ce n'en est pas une */
+int ServerConfig::socketOptionDirective(const std::string &name)
+{
+	for (int i = 0; i < SOCKET_OPTIONS; i++)
+	{
+		if (name == socketOptionDirectives[i])
+			return (i);
+	}
+	return (-1);
+}
+
+/* tcp_nodelay : on / off ; les autres : un entier (listen_backlog au moins 1) */
+void ServerConfig::setSocketOption(SocketOption option, std::string parametr)
+{
+	checkToken(parametr);
+	if (option == SOCKET_NODELAY)
+	{
+		if (parametr != "on" && parametr != "off")
+			throw ErrorException("Wrong syntax: tcp_nodelay");
+		this->_socket_options[option] = (parametr == "on");
+		return ;
+	}
+	for (size_t i = 0; i < parametr.length(); i++)
+	{
+		if (parametr[i] < '0' || parametr[i] > '9')
+			throw ErrorException(std::string("Wrong syntax: ") + socketOptionDirectives[option]);
+	}
+	if (parametr.empty() || parametr.length() > 9 || (option == SOCKET_BACKLOG && ft_stoi(parametr) < 1))
+		throw ErrorException(std::string("Wrong syntax: ") + socketOptionDirectives[option]);
+	this->_socket_options[option] = ft_stoi(parametr);
+}
+
 void ServerConfig::setIndex(std::string index)
 {
 	checkToken(index);
@@ -180,6 +335,29 @@ void ServerConfig::setAutoindex(std::string autoindex)
 		this->_autoindex = true;
 }
 
+/* Threads qui font les accès disque des requêtes statiques (0 à AIO_THREADS_MAX) */
+void ServerConfig::setAioThreads(std::string parametr)
+{
+	checkToken(parametr);
+	for (size_t i = 0; i < parametr.length(); i++)
+	{
+		if (parametr[i] < '0' || parametr[i] > '9')
+			throw ErrorException("Wrong syntax: aio_threads");
+	}
+	if (parametr.empty() || parametr.length() > 3 || ft_stoi(parametr) > AIO_THREADS_MAX)
+		throw ErrorException("Wrong syntax: aio_threads");
+	this->_aio_threads = ft_stoi(parametr);
+}
+
+/* Active la page /__status (off par défaut : elle expose l'activité du serveur) */
+void ServerConfig::setStatusPage(std::string status_page)
+{
+	checkToken(status_page);
+	if (status_page != "on" && status_page != "off")
+		throw ErrorException("Wrong syntax: status_page");
+	this->_status_page = (status_page == "on");
+}
+
 /* vérifie si un code d'erreur par défaut existe.
 	Si c'est le cas, le chemin d'accès au fichier est remplacer.
 	 Sinon, une nouvelle paire est créée : code d'erreur - chemin d'accès au fichier. */
@@ -234,7 +412,11 @@ void ServerConfig::setLocation(std::string path, std::vector<std::string> parame
 	std::vector<std::string> methods;
 	bool flag_methods = false;
 	bool flag_autoindex = false;
+	bool flag_autoindex_format = false;
+	bool flag_autoindex_page = false;
 	bool flag_max_size = false;
+	bool flag_cgi_pool = false;
+	bool flag_cgi_pool_max = false;
 	int valid;
 
 	new_location.setPath(path);
@@ -292,6 +474,24 @@ void ServerConfig::setLocation(std::string path, std::vector<std::string> parame
 			flag_autoindex = true;
 		}
 
+		else if (parametr[i] == "autoindex_format" && (i + 1) < parametr.size()) // Listing en HTML ou en JSON
+		{
+			if (flag_autoindex_format)
+				throw ErrorException("Autoindex_format of location is duplicated");
+			checkToken(parametr[++i]);
+			new_location.setAutoindexFormat(parametr[i]);
+			flag_autoindex_format = true;
+		}
+
+		else if (parametr[i] == "autoindex_page_size" && (i + 1) < parametr.size()) // Pagination du listing
+		{
+			if (flag_autoindex_page)
+				throw ErrorException("Autoindex_page_size of location is duplicated");
+			checkToken(parametr[++i]);
+			new_location.setAutoindexPageSize(parametr[i]);
+			flag_autoindex_page = true;
+		}
+
 		else if (parametr[i] == "index" && (i + 1) < parametr.size()) // Définit le fichier index par défaut: index.html
 		{
 			if (!new_location.getIndexLocation().empty())
@@ -382,6 +582,24 @@ void ServerConfig::setLocation(std::string path, std::vector<std::string> parame
 			flag_max_size = true;
 		}
 
+		else if (parametr[i] == "cgi_pool" && (i + 1) < parametr.size()) // Interpréteurs persistants (sinon un processus par requête)
+		{
+			if (flag_cgi_pool)
+				throw ErrorException("Cgi_pool of location is duplicated");
+			checkToken(parametr[++i]);
+			new_location.setCgiPool(parametr[i]);
+			flag_cgi_pool = true;
+		}
+
+		else if (parametr[i] == "cgi_pool_max_requests" && (i + 1) < parametr.size()) // Recyclage d'un interpréteur du pool
+		{
+			if (flag_cgi_pool_max)
+				throw ErrorException("Cgi_pool_max_requests of location is duplicated");
+			checkToken(parametr[++i]);
+			new_location.setCgiPoolMaxRequests(parametr[i]);
+			flag_cgi_pool_max = true;
+		}
+
 		else if (i < parametr.size())
 			throw ErrorException("Parametr in a location is invalid: " + parametr[i]);
 	}
@@ -406,7 +624,9 @@ void ServerConfig::setLocation(std::string path, std::vector<std::string> parame
 	else if (valid == 4)
 		throw ErrorException("Failed alias file in locaition validation");
 
+	new_location.buildCgiEnv();					// Variables CGI fixes, calculées une fois
 	this->_locations.push_back(new_location); 	// Ajout à la liste
+	this->_location_trie.insert(new_location.getPath(), this->_locations.size() - 1);
 }
 
 void	ServerConfig::setFd(int fd)
@@ -530,68 +750,97 @@ int ServerConfig::isValidLocation(Location &location) const
 }
 
 /*** Les fonctions GET ***/
-const std::string &ServerConfig::getServerName(){
+const std::string &ServerConfig::getServerName() const{
 	return (this->_server_name);
 }
-const std::string &ServerConfig::getRoot(){
+const std::string &ServerConfig::getRoot() const{
 	return (this->_root);
 }
 
-const bool &ServerConfig::getAutoindex(){
+const bool &ServerConfig::getAutoindex() const{
 	return (this->_autoindex);
 }
 
-const in_addr_t &ServerConfig::getHost(){
+bool ServerConfig::getStatusPage() const{
+	return (this->_status_page);
+}
+
+const in_addr_t &ServerConfig::getHost() const{
 	return (this->_host);
 }
 
-const uint16_t &ServerConfig::getPort(){
+const uint16_t &ServerConfig::getPort() const{
 	return (this->_port);
 }
 
-const size_t &ServerConfig::getClientMaxBodySize(){
+const size_t &ServerConfig::getClientMaxBodySize() const{
 	return (this->_client_max_body_size);
 }
 
-const std::vector<Location> &ServerConfig::getLocations(){
+const size_t &ServerConfig::getOutputBufferSize() const{
+	return (this->_output_buffer_size);
+}
+
+const size_t &ServerConfig::getCgiMaxOutput() const{
+	return (this->_cgi_max_output);
+}
+
+size_t ServerConfig::getAioThreads() const{
+	return (this->_aio_threads);
+}
+
+const size_t &ServerConfig::getClientBodyBufferSize() const{
+	return (this->_client_body_buffer_size);
+}
+
+const std::string &ServerConfig::getClientBodyTempPath() const{
+	return (this->_client_body_temp_path);
+}
+
+time_t ServerConfig::getTimeout(TimeoutPhase phase) const{
+	return (this->_timeouts[phase]);
+}
+
+int ServerConfig::getSocketOption(SocketOption option) const{
+	return (this->_socket_options[option]);
+}
+
+const std::vector<Location> &ServerConfig::getLocations() const{
 	return (this->_locations);
 }
 
-const std::map<short, std::string> &ServerConfig::getErrorPages(){
+const std::map<short, std::string> &ServerConfig::getErrorPages() const{
 	return (this->_error_pages);
 }
 
-const std::string &ServerConfig::getIndex(){
+const std::string &ServerConfig::getIndex() const{
 	return (this->_index);
 }
 
-int	ServerConfig::getFd(){
+int	ServerConfig::getFd() const{
 	return (this->_listen_fd);
 }
 
 /* Récupère le chemin de la page d'erreur pour un code HTTP donné
 		Utilisée lors de la génération de réponse(Phase RUNTIME), pas pendant le parsing
 		--> afficher une page d'erreur personnalisée*/
-const std::string &ServerConfig::getPathErrorPage(short key)
+const std::string &ServerConfig::getPathErrorPage(short key) const
 {
-	std::map<short, std::string>::iterator it = this->_error_pages.find(key);
+	std::map<short, std::string>::const_iterator it = this->_error_pages.find(key);
 	if (it == this->_error_pages.end())
 		throw ErrorException("Error_page does not exist");
 	return (it->second);						// Retourne le chemin du fichier
 }
 
-/* Trouve une location par son chemin
+/* Trouve la location la plus spécifique pour une URI (trie construit au chargement)
  		Utilisée par le gestionnaire de serveur(Phase RUNTIME), pas pendant le parsing
-		--> pour router vers la bonne location*/
-const std::vector<Location>::iterator ServerConfig::getLocationKey(std::string key)
+		--> pour router vers la bonne location, NULL si aucune ne correspond */
+const Location *ServerConfig::matchLocation(const std::string &uri) const
 {
-	std::vector<Location>::iterator it;
-	for (it = this->_locations.begin(); it != this->_locations.end(); it++)
-	{
-		if (it->getPath() == key)
-			return (it);						//  itérateur vers la location trouvée
-	}
-	throw ErrorException("Error: path to location not found");
+	int index = this->_location_trie.match(uri);
+	if (index < 0)
+		return (NULL);
+	return (&this->_locations[index]);
 }
 
 /* vérifier si la FIN du paramètre est correcte et le suprime */
@@ -619,8 +868,44 @@ bool ServerConfig::checkLocations() const
 	return (false);
 }
 
+/* Options du socket d'écoute (SocketOptions.hpp), avant listen() : sous Linux,
+	les connexions acceptées héritent TCP_NODELAY, SO_RCVBUF et SO_SNDBUF.
+	Renvoie la directive qui a échoué (errno est positionné), NULL si tout est posé */
+static const char *applySocketOptions(int fd, const int *options)
+{
+	int	value = options[SOCKET_NODELAY];
+
+	if (setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value)) == -1)
+		return ("tcp_nodelay");
+	if (options[SOCKET_RCVBUF] && setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &options[SOCKET_RCVBUF], sizeof(int)) == -1)
+		return ("so_rcvbuf");
+	if (options[SOCKET_SNDBUF] && setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &options[SOCKET_SNDBUF], sizeof(int)) == -1)
+		return ("so_sndbuf");
+	if (options[SOCKET_DEFER_ACCEPT])
+	{
+#ifdef TCP_DEFER_ACCEPT
+		if (setsockopt(fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &options[SOCKET_DEFER_ACCEPT], sizeof(int)) == -1)
+			return ("tcp_defer_accept");
+#else
+		errno = ENOPROTOOPT;
+		return ("tcp_defer_accept");
+#endif
+	}
+	if (options[SOCKET_FASTOPEN])
+	{
+#ifdef TCP_FASTOPEN
+		if (setsockopt(fd, IPPROTO_TCP, TCP_FASTOPEN, &options[SOCKET_FASTOPEN], sizeof(int)) == -1)
+			return ("tcp_fastopen");
+#else
+		errno = ENOPROTOOPT;
+		return ("tcp_fastopen");
+#endif
+	}
+	return (NULL);
+}
+
 /* configuration et liaison du socket pour qu’il puisse écouter les connexions entrantes */
-void	ServerConfig::setupServer(void)
+void	ServerConfig::setupServer(bool reuse_port)
 {
 	if ((_listen_fd = socket(AF_INET, SOCK_STREAM, 0) )  == -1 )
 	{
@@ -631,6 +916,16 @@ void	ServerConfig::setupServer(void)
 
 	int option_value = 1;
 	setsockopt(_listen_fd, SOL_SOCKET, SO_REUSEADDR, &option_value, sizeof(int));
+	if (reuse_port)	/* mode workers : chaque processus lie son propre socket sur ce port */
+	{
+#ifdef SO_REUSEPORT
+		setsockopt(_listen_fd, SOL_SOCKET, SO_REUSEPORT, &option_value, sizeof(int));
+#else
+		close(_listen_fd);
+		_listen_fd = -1;
+		throw ErrorException("SO_REUSEPORT is not supported on this system");
+#endif
+	}
 
 	int flags = fcntl(_listen_fd, F_GETFL, 0);
 	fcntl(_listen_fd, F_SETFL, flags | O_NONBLOCK);
@@ -643,14 +938,26 @@ void	ServerConfig::setupServer(void)
 	if (bind(_listen_fd, (struct sockaddr *) &_server_address, sizeof(_server_address)) == -1)
 	{
 		close(_listen_fd);
+		_listen_fd = -1;
 		std::string error_msg = "bind() failed: ";
 		error_msg += strerror(errno);
 		throw ErrorException(error_msg);
 	}
 
-	if (listen(_listen_fd, 128) == -1)
+	const char *failed = applySocketOptions(_listen_fd, _socket_options);
+	if (failed)
+	{
+		std::string error_msg = std::string(failed) + " failed: ";
+		error_msg += strerror(errno);
+		close(_listen_fd);
+		_listen_fd = -1;
+		throw ErrorException(error_msg);
+	}
+
+	if (listen(_listen_fd, _socket_options[SOCKET_BACKLOG]) == -1)
 	{
 		close(_listen_fd);
+		_listen_fd = -1;
 		std::string error_msg = "listen() failed: ";
 		error_msg += strerror(errno);
 		throw ErrorException(error_msg);
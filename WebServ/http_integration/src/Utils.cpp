@@ -144,73 +144,38 @@ std::string getErrorPage(short statusCode)
 			"<center><h1>" + toString(statusCode) + " "	+ statusCodeString(statusCode) + "</h1></center>\r\n");
 }
 
-/* Construit l'index HTML des fichiers pour l'affichage avec autoindex on */
-int buildHtmlIndex(std::string &dir_name, std::vector<uint8_t> &body, size_t &body_len)
+/* Date HTTP au format IMF-fixdate (RFC 7231) : "Sun, 06 Nov 1994 08:49:37 GMT"
+	Conversion en UTC sans timegm() (non standard) : jours depuis 1970 calculés à la main */
+time_t parseHttpDate(const std::string &date)
 {
-	struct dirent	*entityStruct;
-	DIR				*directory;
-	std::string		dirListPage;
+	static const char	*months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+									"Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+	char	wday[4];
+	char	mon[4];
+	int		day, year, hour, min, sec;
+	int		m = -1;
 
-	directory = opendir(dir_name.c_str());
-	if (directory == NULL)
+	if (sscanf(date.c_str(), "%3s, %d %3s %d %d:%d:%d GMT", wday, &day, mon, &year, &hour, &min, &sec) != 7)
+		return (-1);
+	for (int i = 0; i < 12; i++)
 	{
-		std::cerr << "opendir failed" << std::endl;
-		return (1);
+		if (strcmp(mon, months[i]) == 0)
+			m = i + 1;
 	}
-	dirListPage.append("<html>\n");
-	dirListPage.append("<head>\n");
-	dirListPage.append("<title> Index of");
-	dirListPage.append(dir_name);
-	dirListPage.append("</title>\n");
-	dirListPage.append("</head>\n");
-	dirListPage.append("<body >\n");
-	dirListPage.append("<h1> Index of " + dir_name + "</h1>\n");
-	dirListPage.append("<table style=\"width:80%; font-size: 15px\">\n");
-	dirListPage.append("<hr>\n");
-	dirListPage.append("<th style=\"text-align:left\"> File Name </th>\n");
-	dirListPage.append("<th style=\"text-align:left\"> Last Modification  </th>\n");
-	dirListPage.append("<th style=\"text-align:left\"> File Size </th>\n");
-
-	struct stat file_stat;
-	std::string file_path;
-
-	while((entityStruct = readdir(directory)) != NULL)
-	{
-		if(strcmp(entityStruct->d_name, ".") == 0)
-			continue;
-		file_path = dir_name + entityStruct->d_name;
-		stat(file_path.c_str() , &file_stat);
-		dirListPage.append("<tr>\n");
-		dirListPage.append("<td>\n");
-		dirListPage.append("<a href=\"");
-		dirListPage.append(entityStruct->d_name);
-		if (S_ISDIR(file_stat.st_mode))
-			dirListPage.append("/");
-		dirListPage.append("\">");
-		dirListPage.append(entityStruct->d_name);
-		if (S_ISDIR(file_stat.st_mode))
-			dirListPage.append("/");
-		dirListPage.append("</a>\n");
-		dirListPage.append("</td>\n");
-		dirListPage.append("<td>\n");
-		dirListPage.append(ctime(&file_stat.st_mtime));
-		dirListPage.append("</td>\n");
-		dirListPage.append("<td>\n");
-		if (!S_ISDIR(file_stat.st_mode))
-			dirListPage.append(toString(file_stat.st_size));
-		dirListPage.append("</td>\n");
-		dirListPage.append("</tr>\n");
-	}
-	dirListPage.append("</table>\n");
-	dirListPage.append("<hr>\n");
-
-	dirListPage.append("</body>\n");
-	dirListPage.append("</html>\n");
-
-	body.insert(body.begin(), dirListPage.begin(), dirListPage.end());
-	body_len = body.size();
-	return (0);
+	if (m < 0 || day < 1 || day > 31 || year < 1970 || hour > 23 || min > 59 || sec > 60)
+		return (-1);
+	/* jours depuis le 1er mars de l'an 0 (année commençant en mars : février en dernier) */
+	int y = (m <= 2) ? year - 1 : year;
+	int mp = (m + 9) % 12;
+	long days = 365L * y + y / 4 - y / 100 + y / 400 + (153 * mp + 2) / 5 + day - 1 - 719468L;
+	return ((time_t)(days * 86400L + hour * 3600L + min * 60L + sec));
 }
 
+/* Horloge monotone (insensible aux changements de l'heure système), en microsecondes */
+uint64_t monotonicMicros()
+{
+	struct timespec ts;
 
-
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
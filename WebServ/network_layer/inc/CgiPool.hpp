@@ -0,0 +1,86 @@
+#pragma once
+#ifndef CGIPOOL_HPP
+#define CGIPOOL_HPP
+
+#include "Webserv.hpp"
+#include "FastCgi.hpp"
+#include <deque>
+
+#define CGI_POOL_WORKER "cgi-pool/worker.py"  // Runner executed by each pooled interpreter
+#define CGI_POOL_QUEUE 64  // Requests waiting for a busy pool before new ones get a 503
+
+/**
+ * One persistent interpreter: its stdin/stdout pipes carry FastCGI records
+ */
+struct CgiWorker
+{
+	pid_t pid;
+	int to_worker;    // Our end of its stdin (non-blocking)
+	int from_worker;  // Our end of its stdout (non-blocking)
+	size_t served;    // Requests completed, recycled at the location's max
+	bool busy;
+	std::string interpreter;
+	FastCgiReader reader;
+};
+
+/**
+ * Pools of persistent CGI interpreters, one pool per interpreter path
+ *
+ * Replaces fork() + execve() per request for locations with "cgi_pool N":
+ * each interpreter runs CGI_POOL_WORKER, which loads the script in-process
+ * and answers over FastCGI, so the interpreter start-up and the imports
+ * are paid once per worker instead of once per request.
+ *
+ * - Workers are started lazily, up to the pool size
+ * - Backpressure: when every worker is busy, requests wait in a FIFO
+ *   (CGI_POOL_QUEUE long, then 503); release() hands the freed worker on
+ * - Health check: an idle worker that died or wrote unsolicited output is
+ *   replaced before it gets a request
+ * - Recycling: a worker that served max_requests requests is retired
+ *   (stdin closed: it exits), a fresh one takes its place on demand
+ *
+ * Example: location /cgi-bin { cgi_pool 2; }, 3 requests at once
+ * each request is enqueue()d, then given acquire()'s worker if there is one:
+ * A (spawned), B (spawned), third request stays queued (acquire() → NULL)
+ * A finishes → release(A) → acquire() → A again → popWaiting() → third request
+ *
+ * Workers belong to the process that spawned them (each -w worker has its
+ * own pools); retired ones are reaped on SIGCHLD like every child (ChildRegistry)
+ */
+class CgiPool
+{
+public:
+	CgiPool();
+	~CgiPool();
+
+	CgiWorker* acquire(const std::string& interpreter);
+	void release(CgiWorker* worker, size_t max_requests);
+	void discard(CgiWorker* worker);
+	bool enqueue(const std::string& interpreter, size_t size, int client_fd);
+	bool hasWaiting(const std::string& interpreter) const;
+	int popWaiting(const std::string& interpreter);
+	void forget(const std::string& interpreter, int client_fd);
+	size_t busy(const std::string& interpreter) const;
+	void shutdown();
+
+private:
+	struct Pool
+	{
+		std::vector<CgiWorker*> workers;
+		std::deque<int> waiting;  // Client fds, oldest first
+		size_t size;              // Workers at most (cgi_pool of the last request queued)
+
+		Pool() : size(0) {}
+	};
+
+	std::map<std::string, Pool> _pools;
+
+	CgiPool(const CgiPool&);
+	CgiPool& operator=(const CgiPool&);
+
+	CgiWorker* spawn(const std::string& interpreter);
+	bool healthy(const CgiWorker& worker) const;
+	void retire(CgiWorker* worker, int signal);
+};
+
+#endif
@@ -0,0 +1,44 @@
+#pragma once
+#ifndef CGISTDIN_HPP
+#define CGISTDIN_HPP
+
+#include "Webserv.hpp"
+#include "BodySink.hpp"
+
+/**
+ * Feeds a request body to a CGI's stdin without copying it
+ *
+ * The body (BodySink: memory or temp file) is read at an offset that only
+ * moves forward; the only bytes buffered here are framing. For a pool
+ * interpreter the body goes out as FastCGI STDIN records built on the fly:
+ * a record header, then up to 65535 body bytes straight from the sink.
+ *
+ * Example: pooled CGI, 100000-byte body spilled to /tmp
+ * start(body, head) → frame = BEGIN_REQUEST + PARAMS
+ * send(): frame, [STDIN 65535], body[0, 65535), [STDIN 34465],
+ * body[65535, 100000), [STDIN ""] → STDIN_DONE
+ * Pipe full at any point → STDIN_BLOCKED, the next send() resumes there
+ */
+class CgiStdin
+{
+public:
+	enum Status { STDIN_BLOCKED, STDIN_DONE, STDIN_CLOSED };
+
+	CgiStdin();
+
+	void start(const BodySink& body);
+	void start(const BodySink& body, const std::string& head);
+	Status send(int fd);
+	void reset();
+
+private:
+	const BodySink* _body;
+	std::string _frame;   // Framing bytes due before more body (FastCGI)
+	size_t _frame_sent;
+	size_t _body_sent;
+	size_t _record_left;  // Body bytes still due in the current STDIN record
+	bool _fastcgi;
+	bool _end_framed;     // The empty STDIN record (end of stream) is in _frame
+};
+
+#endif
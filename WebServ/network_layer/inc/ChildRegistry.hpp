@@ -0,0 +1,54 @@
+#pragma once
+#ifndef CHILDREGISTRY_HPP
+#define CHILDREGISTRY_HPP
+
+#include "Webserv.hpp"
+
+struct ChildExit
+{
+	pid_t pid;
+	int owner;   // Client fd the child was started for, -1: none (disowned, pool interpreter)
+	int status;  // As returned by waitpid()
+};
+
+/**
+ * Child processes of this server process, reaped from the event loop
+ *
+ * SIGCHLD is turned into a readable fd watched like any other:
+ * - Linux: signalfd (SIGCHLD blocked, queued on the fd)
+ * - elsewhere: self-pipe written by a SIGCHLD handler
+ * When it is readable, reap() collects every exited child with
+ * waitpid(WNOHANG): the loop never blocks on a child.
+ *
+ * Example: CGI time.py (pid 300) for client fd=10
+ * track(300, 10) → script exits → fd readable → reap() → {300, 10, status 0}
+ * Client closed first: disown(300) → still reaped, reported with owner -1
+ *
+ * Every child is reaped, tracked or not (pool interpreters too)
+ */
+class ChildRegistry
+{
+public:
+	ChildRegistry();
+	~ChildRegistry();
+
+	bool open();
+	int fd() const;
+	void track(pid_t pid, int owner);
+	void disown(pid_t pid);
+	void reap(std::vector<ChildExit>& exited);
+	void waitAll();
+
+private:
+	int _fd;                      // Readable when a child exited
+	int _notify_fd;               // Write end of the self-pipe (-1 with signalfd)
+	std::map<pid_t, int> _owners; // Children not reaped yet → client fd
+
+	static int _signal_fd;        // _notify_fd, for the signal handler
+	static void handleChild(int signum);
+
+	ChildRegistry(const ChildRegistry&);
+	ChildRegistry& operator=(const ChildRegistry&);
+};
+
+#endif
@@ -5,28 +5,49 @@
 #include "Webserv.hpp"
 #include "HttpRequest.hpp"
 #include "Response.hpp"
+#include "TimerWheel.hpp"
+#include "Timeouts.hpp"
+#include "CgiStdin.hpp"
+#include <sys/time.h>
 class ServerConfig;
+struct CgiWorker;
 
 class Client
 {
 public:
 	int socket_fd;
 	struct sockaddr_in address;
-	time_t last_activity;
 	std::string read_buffer;
-	std::string write_buffer;
+	std::string write_buffer;  // Streamed body slices (autoindex, CGI)
 	size_t write_offset;
+	size_t head_offset;  // Bytes of response head + in-memory body already sent (writev)
+	off_t file_offset;  // Bytes of response.getFileFd() already sent with sendfile()
 	size_t parse_offset;  // Track how much has been parsed
+	bool response_pending;  // Response in progress: pipelined bytes wait in read_buffer
+	bool file_job;  // Request and response handed to a FilePool thread: off limits until collected
+	bool close_pending;  // Closed during a file job: released once the thread is done
+	bool read_paused;  // PIPELINE_BUFFER_MAX reached behind a pending response: socket not read until finishResponse()
+	bool cgi_paused;  // CGI output at the high-water mark: pipe not read until the client drains it
 	HttpRequest request;
 	Response response;
 	int listen_fd_owner;
 	ServerConfig* server_config;
+	TimerNode timer;  // Deadline of the current phase, linked in ServerManager::_timers
+	TimeoutPhase phase;
+	struct timeval request_start;  // First byte of the current request (access log duration)
+	size_t bytes_sent;  // Response bytes written to the socket (access log, metrics)
+	uint64_t parse_us;  // Time spent in request.feed() for the current request
+	uint64_t cgi_start;  // CGI started, no output yet (0: not waiting for a first byte)
+	uint64_t write_start;  // Response ready to send (0: not ready yet)
+	CgiWorker* cgi_worker;  // Pool interpreter running this client's CGI (NULL: none / fork mode)
+	int cgi_exit;  // Forked CGI reaped: its waitpid() status (-1: still running)
+	size_t cgi_output;  // Bytes read from the CGI so far (cgi_max_output)
+	CgiStdin cgi_stdin;  // Request body on its way to the CGI (offset in request.getBody())
 	
 	Client();
 	Client(int fd, const struct sockaddr_in& addr);
 	
-	void updateActivity();
-	bool isTimedOut(time_t current_time, int timeout) const;
+	void reset(int fd, const struct sockaddr_in& addr);
 	void clear();
 	std::string getAddressString() const;
 	bool requestComplete() const;
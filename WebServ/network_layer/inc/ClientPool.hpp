@@ -0,0 +1,44 @@
+#pragma once
+#ifndef CLIENTPOOL_HPP
+#define CLIENTPOOL_HPP
+
+#include "Webserv.hpp"
+#include "Client.hpp"
+
+#define CLIENT_SLAB_SIZE 64  // Clients allocated together when the pool runs dry
+
+/**
+ * Slab of recycled Client objects
+ * 
+ * Clients are allocated CLIENT_SLAB_SIZE at a time and never freed while
+ * the server runs: a closed connection goes back to the free list with its
+ * buffers (read/write buffers, parser and response strings, CGI arena)
+ * still allocated, so the next connection on that slot does not malloc them again.
+ * 
+ * Example: 3 connections, the second one closes, a fourth arrives
+ * acquire(10) → slab[0]   acquire(11) → slab[1]   acquire(12) → slab[2]
+ * release(slab[1]) → free = {slab[1], ...}
+ * acquire(13) → slab[1] (reused, buffers already sized)
+ */
+class ClientPool
+{
+public:
+	ClientPool();
+	~ClientPool();
+	
+	Client* acquire(int fd, const struct sockaddr_in& addr);
+	void release(Client* client);
+	size_t inUse() const;
+	
+private:
+	std::vector<Client*> _slabs;  // new Client[CLIENT_SLAB_SIZE] each
+	std::vector<Client*> _free;
+	size_t _in_use;
+	
+	ClientPool(const ClientPool&);
+	ClientPool& operator=(const ClientPool&);
+	
+	void grow();
+};
+
+#endif
@@ -0,0 +1,48 @@
+#pragma once
+#ifndef DISPATCHTABLE_HPP
+#define DISPATCHTABLE_HPP
+
+#include "Webserv.hpp"
+
+enum FdRole
+{
+	FD_NONE,
+	FD_LISTENER,     // owner = index in ServerManager::_servers
+	FD_CLIENT,       // owner = client socket fd (itself)
+	FD_CGI_STDIN,    // owner = client fd whose CGI reads this pipe
+	FD_CGI_STDOUT,   // owner = client fd whose CGI writes this pipe
+	FD_CHILDREN,     // SIGCHLD notifications (ChildRegistry), owner unused
+	FD_FILE_IO       // Finished disk jobs (FilePool), owner unused
+};
+
+struct FdSlot
+{
+	FdRole role;
+	int owner;
+};
+
+/**
+ * fd-indexed table: one slot per fd telling who handles its events
+ * 
+ * Example: listener fd=5, client fd=10 running a CGI (pipes 15, 16)
+ * _slots[5]  = {FD_LISTENER, 0}
+ * _slots[10] = {FD_CLIENT, 10}
+ * _slots[15] = {FD_CGI_STDOUT, 10}
+ * _slots[16] = {FD_CGI_STDIN, 10}
+ */
+class DispatchTable
+{
+public:
+	DispatchTable();
+	
+	void set(int fd, FdRole role, int owner);
+	void clear(int fd);
+	const FdSlot& get(int fd) const;
+	bool is(int fd, FdRole role, int owner) const;
+	
+private:
+	std::vector<FdSlot> _slots;
+	FdSlot _none;
+};
+
+#endif
@@ -0,0 +1,40 @@
+#pragma once
+#ifndef EPOLLMANAGER_HPP
+#define EPOLLMANAGER_HPP
+
+#include "Webserv.hpp"
+#include "EventLoop.hpp"
+
+#ifdef __linux__
+# include <sys/epoll.h>
+
+class EpollManager : public EventLoop
+{
+public:
+	EpollManager();
+	~EpollManager();
+	
+	bool addRead(int fd);
+	bool addWrite(int fd);
+	void removeRead(int fd);
+	void removeWrite(int fd);
+	void removeFd(int fd);
+	bool isWriting(int fd) const;
+	int wait(std::vector<IoEvent>& events, int timeout_ms);
+	bool edgeTriggered() const;
+	const char* name() const;
+	
+private:
+	int _epfd;
+	std::vector<int> _interest;                // fd -> IO_READ | IO_WRITE
+	std::vector<struct epoll_event> _ready;
+	
+	EpollManager(const EpollManager&);
+	EpollManager& operator=(const EpollManager&);
+	
+	bool setInterest(int fd, int mask);
+};
+
+#endif
+
+#endif
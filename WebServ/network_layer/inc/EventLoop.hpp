@@ -0,0 +1,47 @@
+#pragma once
+#ifndef EVENTLOOP_HPP
+#define EVENTLOOP_HPP
+
+#include "Webserv.hpp"
+
+enum IoEventFlag
+{
+	IO_READ = 1,
+	IO_WRITE = 2
+};
+
+struct IoEvent
+{
+	int fd;
+	int events;  // IO_READ | IO_WRITE
+};
+
+/**
+ * Readiness notification backend used by ServerManager
+ *
+ * Implementations:
+ * - FdSetManager: select(), level-triggered, limited to FD_SETSIZE
+ * - EpollManager: epoll(), edge-triggered, cost scales with ready fds
+ *
+ * With an edge-triggered backend, handlers must drain an fd
+ * (read/write/accept until EAGAIN) before waiting again.
+ */
+class EventLoop
+{
+public:
+	virtual ~EventLoop() {}
+
+	virtual bool addRead(int fd) = 0;
+	virtual bool addWrite(int fd) = 0;
+	virtual void removeRead(int fd) = 0;
+	virtual void removeWrite(int fd) = 0;
+	virtual void removeFd(int fd) = 0;
+	virtual bool isWriting(int fd) const = 0;
+	virtual int wait(std::vector<IoEvent>& events, int timeout_ms) = 0;
+	virtual bool edgeTriggered() const = 0;
+	virtual const char* name() const = 0;
+
+	static EventLoop* create();
+};
+
+#endif
@@ -0,0 +1,76 @@
+#pragma once
+#ifndef FASTCGI_HPP
+#define FASTCGI_HPP
+
+#include "Webserv.hpp"
+#include "BodySource.hpp"
+
+#define FCGI_VERSION_1 1
+#define FCGI_HEADER_LEN 8
+#define FCGI_MAX_CONTENT 65535  // Content length is a 16-bit field
+#define FCGI_REQUEST_ID 1       // A pool interpreter serves one request at a time
+#define FCGI_RESPONDER 1
+#define FCGI_KEEP_CONN 1        // BEGIN_REQUEST flag: the interpreter stays for the next request
+
+enum FastCgiType
+{
+	FCGI_BEGIN_REQUEST = 1,
+	FCGI_ABORT_REQUEST = 2,
+	FCGI_END_REQUEST = 3,
+	FCGI_PARAMS = 4,
+	FCGI_STDIN = 5,
+	FCGI_STDOUT = 6,
+	FCGI_STDERR = 7
+};
+
+/**
+ * FastCGI record framing (responder role, one request per connection)
+ *
+ * Every record is an 8-byte header (version, type, request id, content
+ * length, padding length) followed by its content. A request is
+ * BEGIN_REQUEST, the CGI variables as PARAMS, the body as STDIN, each
+ * stream closed by an empty record of its type.
+ *
+ * Example: GET /cgi-bin/time.py
+ * encodeHead("cgi-bin/time.py", envp) →
+ * [BEGIN_REQUEST role=1] [PARAMS "REQUEST_METHOD" "GET" ...] [PARAMS ""]
+ * then CgiStdin: [STDIN ""] (no body)
+ */
+class FastCgi
+{
+public:
+	static std::string encodeHead(const std::string& script, char* const* envp);
+	static void appendHeader(std::string& out, FastCgiType type, size_t len);
+
+private:
+	static void appendRecord(std::string& out, FastCgiType type, const char* data, size_t len);
+	static void appendLength(std::string& out, size_t len);
+};
+
+/**
+ * Incremental decoder of an interpreter's answer
+ *
+ * Bytes are fed as they come out of the pipe; complete STDOUT records go to
+ * the response stream, STDERR records to the log, END_REQUEST ends it.
+ *
+ * Example: read() returned 3 bytes of a header, then the rest
+ * feed(3 bytes) → FEED_MORE (header kept in _pending)
+ * feed(rest)    → STDOUT content appended to out, END_REQUEST → FEED_END
+ */
+class FastCgiReader
+{
+public:
+	enum Status { FEED_MORE, FEED_END, FEED_ERROR };
+
+	FastCgiReader();
+
+	Status feed(const char* data, size_t len, StreamSource& out);
+	int appStatus() const;
+	void reset();
+
+private:
+	std::string _pending;  // Start of a record not complete yet
+	int _app_status;       // Script exit status, from END_REQUEST
+};
+
+#endif
@@ -3,8 +3,9 @@
 #define FDSETMANAGER_HPP
 
 #include "Webserv.hpp"
+#include "EventLoop.hpp"
 
-class FdSetManager
+class FdSetManager : public EventLoop
 {
 public:
 	FdSetManager();
@@ -16,9 +17,21 @@ public:
 	void updateMaxFd(int fd);
 	int getMaxFd() const;
 	
+	// EventLoop backend (select)
+	bool addRead(int fd);
+	bool addWrite(int fd);
+	void removeRead(int fd);
+	void removeWrite(int fd);
+	void removeFd(int fd);
+	bool isWriting(int fd) const;
+	int wait(std::vector<IoEvent>& events, int timeout_ms);
+	bool edgeTriggered() const;
+	const char* name() const;
+	
 private:
 	int _max_fd;
+	fd_set _read_set;
+	fd_set _write_set;
 };
 
 #endif
-
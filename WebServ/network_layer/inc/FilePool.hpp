@@ -0,0 +1,66 @@
+#pragma once
+#ifndef FILEPOOL_HPP
+#define FILEPOOL_HPP
+
+#include "Webserv.hpp"
+#include <pthread.h>
+#include <deque>
+
+class Response;
+
+/**
+ * Threads doing the blocking filesystem part of static requests
+ * (stat, open, read, POST body saved, DELETE, opendir), like nginx "aio threads"
+ *
+ * The event loop hands a parsed request over with post() and forgets it;
+ * a thread runs Response::resolveBody() and reports the client fd on a
+ * completion queue. An eventfd (self-pipe elsewhere) watched like any
+ * other fd tells the loop to collect() them: a slow disk or a stalled NFS
+ * mount only holds its own thread, never the other connections.
+ *
+ * Example: aio_threads 4, GET /big.iso on a cold disk for fd=10
+ * post(10, &response) → thread 2: stat() + open() take 300 ms
+ * → meanwhile the loop keeps serving fd=11, 12... → eventfd readable
+ * → collect() = {10} → headers built, fd=10 watched for writing
+ *
+ * Threads never log and never touch a Client: the request and response of
+ * a posted client are theirs until collect() returned its fd
+ */
+class FilePool
+{
+public:
+	FilePool();
+	~FilePool();
+
+	bool start(size_t threads);
+	bool running() const;
+	int fd() const;
+	void post(int owner, Response* response);
+	void collect(std::vector<int>& done);
+	void shutdown();
+
+private:
+	struct Job
+	{
+		int owner;           // Client fd
+		Response* response;
+	};
+
+	std::vector<pthread_t> _threads;
+	std::deque<Job> _queue;  // Posted, not started yet
+	std::vector<int> _done;  // Owners of finished jobs, not collected yet
+	pthread_mutex_t _lock;
+	pthread_cond_t _wake;
+	bool _stopping;
+	int _fd;                 // Readable when _done is not empty
+	int _notify_fd;          // Write end of the self-pipe (-1 with eventfd)
+
+	static void* worker(void* pool);
+	void runJobs();
+	void notify();
+
+	FilePool(const FilePool&);
+	FilePool& operator=(const FilePool&);
+};
+
+#endif
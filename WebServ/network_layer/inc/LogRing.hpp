@@ -0,0 +1,47 @@
+#pragma once
+#ifndef LOGRING_HPP
+#define LOGRING_HPP
+
+#include "Webserv.hpp"
+
+#define LOG_RING_SIZE (1 << 20)  // Bytes of log lines waiting for the writer thread (power of two)
+
+/**
+ * Lock-free single-producer / single-consumer byte ring
+ *
+ * The event loop thread (producer) copies formatted lines in with push();
+ * the writer thread (consumer) hands everything pending to writev() in one
+ * call with drain(). Each side only writes its own counter (_head / _tail),
+ * published with release stores and read with acquire loads: no lock,
+ * no syscall on the producer side.
+ *
+ * Example: 3 lines logged while the writer slept
+ * push("[..] New connection ...\n") push("[..] Request parsed ...\n") push(...)
+ * drain() → one writev() of the 3 lines (2 iovecs if they wrap around the end)
+ *
+ * A full ring never blocks the producer: the line is dropped and counted,
+ * and a "N line(s) dropped" notice is queued once there is room again
+ */
+class LogRing
+{
+public:
+	LogRing(int fd);
+
+	bool push(const char* data, size_t len);
+	size_t drain();
+	int fd() const;
+
+private:
+	std::vector<char> _buf;
+	size_t _head;     // Total bytes pushed (producer only)
+	size_t _tail;     // Total bytes written out (consumer only)
+	size_t _dropped;  // Lines lost to a full ring (producer only)
+	int _fd;
+
+	LogRing(const LogRing&);
+	LogRing& operator=(const LogRing&);
+
+	bool copyIn(const char* data, size_t len);
+};
+
+#endif
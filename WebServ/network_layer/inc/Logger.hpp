@@ -3,6 +3,8 @@
 #define LOGGER_HPP
 
 #include "Webserv.hpp"
+#include "LogRing.hpp"
+#include <pthread.h>
 
 #define RESET "\x1B[0m"
 #define RED "\x1B[31m"
@@ -11,7 +13,18 @@
 #define LIGHT_BLUE "\x1B[94m"
 #define DARK_GREY "\x1B[90m"
 
-enum LogLevel { DEBUG, INFO, WARN, ERROR };
+#define LOG_FLUSH_INTERVAL_US 10000  // Writer thread sleep when nothing is pending (10ms)
+
+enum LogLevel { DEBUG, INFO, WARN, ERROR, SILENT };
+
+/**
+ * Level check before the message is built: a suppressed line costs one compare
+ *
+ * Example: ./webserv -l warn
+ * LOG_INFO("New connection: fd=" + toString(fd)) → no toString(), no concatenation
+ */
+#define LOG_DEBUG(msg) do { if (Logger::enabled(DEBUG)) Logger::debug(msg); } while (0)
+#define LOG_INFO(msg) do { if (Logger::enabled(INFO)) Logger::info(msg); } while (0)
 
 class Logger
 {
@@ -22,12 +35,35 @@ public:
 	static void warn(const std::string& msg);
 	static void error(const std::string& msg);
 	static void performance(const std::string& operation, double time_ms);
-	
+	static void access(const std::string& client, const std::string& request, int status,
+		size_t bytes, const struct timeval& start);
+	static void setProcessTag(const std::string& tag);
+	static void setLevel(LogLevel level);
+	static bool parseLevel(const std::string& name, LogLevel& level);
+	static bool openAccessLog(const std::string& path);
+	static void startAsync();
+	static void stopAsync();
+
+	static bool enabled(LogLevel level) { return level >= _level; }
+	static bool accessEnabled() { return _access_fd >= 0; }
+
 private:
-	static std::string getTimestamp();
-	static std::string getLevelColor(LogLevel level);
-	static std::string getLevelName(LogLevel level);
+	static std::string _tag;  // "[worker 2] " in worker mode, empty otherwise
+	static LogLevel _level;
+	static int _access_fd;    // -1: access log off
+	static LogRing* _ring;    // NULL until startAsync(): lines are written directly
+	static LogRing* _access_ring;
+	static pthread_t _writer;
+	static volatile int _stop_writer;
+	static time_t _ts_second;  // Second the cached timestamps below were built for
+	static char _ts_log[20];   // "2025-11-20 14:03:12"
+	static char _ts_access[32];  // "20/Nov/2025:14:03:12 +0100"
+
+	static void updateTimestamps();
+	static const char* getLevelColor(LogLevel level);
+	static const char* getLevelName(LogLevel level);
+	static void emit(LogRing* ring, int fd, const std::string& line);
+	static void* writerMain(void*);
 };
 
 #endif
-
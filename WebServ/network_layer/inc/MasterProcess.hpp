@@ -0,0 +1,56 @@
+#pragma once
+#ifndef MASTERPROCESS_HPP
+#define MASTERPROCESS_HPP
+
+#include "Webserv.hpp"
+#include "ServerConfig.hpp"
+#include <csignal>
+
+#define WORKER_EXIT_FATAL 2      // Worker could not start (bind failed...): not restarted
+#define WORKER_RESPAWN_DELAY 1   // Seconds: a worker dying faster than this is restarted after a pause
+
+/**
+ * Entry point of a worker: runs one event loop on servers, returns the exit status
+ */
+typedef int (*WorkerMain)(const std::vector<ServerConfig>& servers, bool reuse_port);
+
+/**
+ * Master of the worker mode (./webserv -w N)
+ * 
+ * The config is parsed once by main(); the master forks N workers that each
+ * bind their own SO_REUSEPORT listeners and run an independent event loop,
+ * so the kernel spreads connections over N cores.
+ * 
+ * Example: ./webserv -w 4 config/default.conf
+ * master (pid 100) → workers 101, 102, 103, 104, all listening on :8080
+ * worker 102 crashes → master logs it and forks a new worker in slot 1
+ * SIGTERM to 100 → forwarded to 101..104, each drains its clients,
+ *                  master exits once they are all gone
+ */
+class MasterProcess
+{
+public:
+	MasterProcess(const std::vector<ServerConfig>& servers, int workers, WorkerMain worker_main);
+	
+	int run();
+	
+private:
+	std::vector<ServerConfig> _servers;
+	WorkerMain _worker_main;
+	std::vector<pid_t> _pids;     // slot → worker pid, -1 while not running
+	std::vector<time_t> _started; // slot → time of the last fork
+	bool _stopping;
+	int _exit_status;
+	
+	static volatile sig_atomic_t _signal;
+	static void handleSignal(int signum);
+	static void handleChild(int signum);
+	
+	void installSignalHandlers(sigset_t& wait_mask);
+	void spawn(size_t slot);
+	void reap();
+	void signalWorkers(int signum);
+	size_t running() const;
+};
+
+#endif
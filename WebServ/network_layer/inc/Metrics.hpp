@@ -0,0 +1,93 @@
+#pragma once
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include "Webserv.hpp"
+
+#define HISTOGRAM_SUB_BUCKETS 16  // Linear buckets per power of two: ~6% precision
+#define HISTOGRAM_BUCKETS 528     // 0..15us exact, then 16 per power of two up to 2^36us (~19h)
+#define METRICS_MAX_STATUS 600
+#define STATUS_PAGE_PATH "/__status"  // Served by servers with "status_page on;"
+
+enum MetricPhase
+{
+	PHASE_ACCEPT,      // accept() + registering the connection
+	PHASE_PARSE,       // Time spent in HttpRequest::feed() for one request
+	PHASE_RESOLVE,     // Location match, method checks, path building
+	PHASE_FILE_READ,   // Static file lookup (FileCache: stat, open, read)
+	PHASE_CGI_FIRST,   // CGI fork() to first byte of output
+	PHASE_WRITE,       // Response ready to last byte handed to the socket
+	METRIC_PHASES
+};
+
+/**
+ * HDR-style latency histogram in microseconds
+ *
+ * Log-linear buckets: exact below 16us, then each power of two is split in
+ * 16 equal buckets. Recording is one clz and one increment, whatever the value.
+ *
+ * Example: 1000us → 2^9 <= 1000 < 2^10 → bucket of [992, 1024)
+ * percentile(0.99) returns the upper bound of the bucket holding the 99th value
+ */
+struct Histogram
+{
+	uint64_t count;
+	uint64_t sum;
+	uint64_t max;
+	uint64_t buckets[HISTOGRAM_BUCKETS];
+
+	void record(uint64_t us);
+	void merge(const Histogram& other);
+	uint64_t percentile(double q) const;
+};
+
+/**
+ * Counters of one process, written by that process only
+ */
+struct MetricsSlot
+{
+	pid_t pid;
+	uint64_t accepted;
+	uint64_t active;
+	uint64_t requests;
+	uint64_t bytes_in;
+	uint64_t bytes_out;
+	uint64_t status[METRICS_MAX_STATUS];
+	Histogram phases[METRIC_PHASES];
+};
+
+/**
+ * Server-wide counters and latency histograms, served on GET /__status
+ *
+ * init() maps one MetricsSlot per process in shared memory before the
+ * workers are forked; each worker attach()es to its slot and is the only
+ * writer of it. Counters are plain loads/stores (single writer, aligned
+ * 64-bit: never torn), so recording takes no lock and no atomic RMW.
+ * report() sums every slot: any worker answers for the whole server.
+ *
+ * Example: ./webserv -w 4
+ * init(4) → 4 slots; worker 2 → attach(2) → add(_local->requests)...
+ * GET /__status on any worker → totals of the 4 slots
+ * A restarted worker takes over its slot: counters keep growing
+ */
+class Metrics
+{
+public:
+	static bool init(size_t slots);
+	static void attach(size_t slot);
+	static void record(MetricPhase phase, uint64_t us);
+	static void connectionOpened();
+	static void connectionClosed();
+	static void bytesIn(size_t bytes);
+	static void bytesOut(size_t bytes);
+	static void response(int status);
+	static std::string report();
+
+private:
+	static MetricsSlot* _slots;
+	static size_t _count;
+	static MetricsSlot* _local;  // NULL before attach() (benches, master): nothing recorded
+	static time_t _started;
+};
+
+#endif
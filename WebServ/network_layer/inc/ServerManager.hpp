@@ -6,7 +6,16 @@
 #include "ServerConfig.hpp"
 #include "ConfigParser.hpp"
 #include "Client.hpp"
-#include "FdSetManager.hpp"
+#include "ClientPool.hpp"
+#include "EventLoop.hpp"
+#include "DispatchTable.hpp"
+#include "TimerWheel.hpp"
+#include "CgiPool.hpp"
+#include "ChildRegistry.hpp"
+#include "FilePool.hpp"
+#include <csignal>
+
+#define DRAIN_TIMEOUT 10  // Seconds given to requests in flight after SIGTERM
 
 class ServerManager
 {
@@ -16,16 +25,28 @@ public:
 	
 	void addServer(const ServerConfig& config);
 	void loadConfig(const std::string& config_file);
+	void openListeners(bool reuse_port);
 	void run();
+	void requestStop();
 	void stop();
 	
 private:
 	bool _running;
+	bool _stopped;
+	volatile sig_atomic_t _stop_requested;  // Set by the signal handler
+	bool _draining;                          // Listeners closed, finishing requests in flight
+	time_t _drain_deadline;
 	std::vector<ServerConfig> _servers;
-	std::map<int, Client> _clients;
-	FdSetManager _fd_manager;
-	fd_set _read_set;
-	fd_set _write_set;
+	std::map<int, Client*> _clients;  // fd → Client owned by _client_pool
+	ClientPool _client_pool;
+	EventLoop* _loop;
+	std::vector<IoEvent> _events;
+	std::vector<size_t> _accept_pending;  // Listeners (server index) that used their ACCEPT_BATCH, edge-triggered
+	DispatchTable _dispatch;
+	TimerWheel _timers;  // One timer per client: deadline of its current phase
+	CgiPool _cgi_pool;   // Persistent interpreters of "cgi_pool" locations
+	ChildRegistry _children;  // Forked CGIs and interpreters, reaped on SIGCHLD
+	FilePool _file_pool;  // Disk work of static requests ("aio_threads"), off the event loop
 	
 	// Connection statistics
 	size_t _total_connections;
@@ -33,21 +54,49 @@ private:
 	
 	void initSets();
 	void processEvents();
-	void handleServerSocket(ServerConfig& server);
+	void handleServerSocket(size_t server_index);
+	void resumeAccepts();
 	void handleClientRead(int fd);
+	void clientInput(int fd, ssize_t bytes);
 	void handleClientWrite(int fd);
+	bool sendHead(int fd);
+	bool sendFileBody(int fd);
+	bool pullBody(int fd);
+	void processRequest(int fd);
+	ServerConfig* selectServer(Client& client);
+	void routeBody(Client& client);
+	void startResponse(int fd);
+	void startFilePool();
+	void completeFileJobs();
+	void finishResponse(int fd);
 	void handleCgiRead(int pipe_fd);
 	void handleCgiWrite(int pipe_fd);
 	void sendCgiBody(int client_fd);
 	void readCgiResponse(int client_fd);
+	void finishCgiResponse(int client_fd);
+	void completeCgiResponse(int client_fd, short error_code);
+	void abortCgi(int client_fd, short error_code);
+	void reapChildren();
+	void watchCgiPipes(int client_fd);
+	void queuePooledCgi(int client_fd);
+	void runCgiQueue(const std::string& interpreter);
+	void startPooledCgi(int client_fd, CgiWorker* worker);
+	void finishPooledCgi(int client_fd, bool completed);
+	void detachPooledCgi(Client& client);
 	void checkTimeouts();
+	void setPhase(Client& client, TimeoutPhase phase);
+	void refreshTimeout(Client& client);
+	void logAccess(Client& client);
+	void recordResponse(Client& client);
 	void closeClient(int fd);
-	void acceptNewConnection(ServerConfig& server);
+	void beginDrain();
+	void closeListeners();
+	void closeCgiPipe(int pipe_fd);
+	void detachCgiPipe(int pipe_fd);
+	bool acceptNewConnection(ServerConfig& server);
+	size_t maxBodySize(int listen_fd) const;
 	ssize_t readFromSocket(int fd, std::string& buffer);
 	ssize_t writeToSocket(int fd, const std::string& buffer, size_t& offset);
-	
-	// Helper to find client by pipe fd
-	int findClientByPipe(int pipe_fd, bool is_read_pipe);
 };
 
 #endif
@@ -3,6 +3,10 @@
 #define SOCKETOPS_HPP
 
 #include "Webserv.hpp"
+#include <sys/uio.h>
+
+// Upper bound for one sendfile() call, keeps one big file from starving other clients
+#define SENDFILE_CHUNK (1024 * 1024)
 
 namespace SocketOps
 {
@@ -13,6 +17,8 @@ namespace SocketOps
 	void listenSocket(int fd, int backlog = 128);
 	int acceptConnection(int server_fd, struct sockaddr_in& client_addr);
 	void closeSocket(int fd);
+	ssize_t sendFile(int sock_fd, int file_fd, off_t& offset, size_t count);
+	ssize_t sendVector(int sock_fd, struct iovec* iov, int count, bool more);
 }
 
 #endif
@@ -0,0 +1,63 @@
+#pragma once
+#ifndef TIMERWHEEL_HPP
+#define TIMERWHEEL_HPP
+
+#include "Webserv.hpp"
+
+#define TIMER_WHEEL_SLOTS 512  // One slot per second: deadlines up to 512s ahead never wrap
+
+/**
+ * Intrusive list node embedded in each Client: arming a timer allocates nothing
+ *
+ * Example: fd=10 must send its headers before 12:00:30
+ * node = {deadline: 12:00:30, fd: 10} linked in slot (12:00:30 % 512)
+ */
+struct TimerNode
+{
+	TimerNode* prev;
+	TimerNode* next;
+	time_t deadline;
+	int fd;
+
+	TimerNode();
+	bool armed() const;
+};
+
+/**
+ * Hashed timing wheel with one-second ticks
+ *
+ * Each slot is a circular doubly-linked list of the timers expiring at
+ * that second (modulo TIMER_WHEEL_SLOTS), so arming, re-arming and
+ * cancelling are O(1) pointer updates. expire() only visits the slots of
+ * the seconds that have passed since the previous call.
+ *
+ * Example: 10000 keep-alive clients, one expires this second
+ * Old checkTimeouts(): 10000 isTimedOut() calls every loop turn
+ * expire(): 1 slot visited, 1 node unlinked, fd returned
+ *
+ * A deadline more than TIMER_WHEEL_SLOTS seconds away shares its slot with
+ * nearer ones: it is skipped when the slot comes round too early
+ */
+class TimerWheel
+{
+public:
+	TimerWheel();
+
+	time_t now() const;
+	void schedule(TimerNode& node, time_t deadline);
+	void cancel(TimerNode& node);
+	void expire(time_t now, std::vector<int>& expired);
+	size_t size() const;
+
+private:
+	std::vector<TimerNode> _slots;  // List heads (sentinels)
+	time_t _now;                    // Last second processed by expire()
+	size_t _size;
+
+	TimerWheel(const TimerWheel&);
+	TimerWheel& operator=(const TimerWheel&);
+
+	static void unlink(TimerNode& node);
+};
+
+#endif
@@ -22,17 +22,20 @@
 #include <fcntl.h>
 #include <signal.h>
 
-#define CONNECTION_TIMEOUT 60
 #define MESSAGE_BUFFER 40000
+#define CLIENT_READ_BATCH (4 * MESSAGE_BUFFER)  // Unparsed input handed to the parser mid-drain (edge-triggered)
+#define PIPELINE_BUFFER_MAX CLIENT_READ_BATCH  // Pipelined input buffered while a response is pending: reading pauses beyond
+#define ACCEPT_BATCH 64  // Connections accepted per listener per loop turn (the rest wait for the next turn)
 #define MAX_CONNECTIONS 1024
+#define MAX_WORKERS 256  // Upper bound for -w N (and for -w auto on very large machines)
 #define MAX_URI_LENGTH 4096
 #define MAX_CONTENT_LENGTH 30000000
 
 std::string statusCodeString(short);
 std::string getErrorPage(short);
-int buildHtmlIndex(std::string &, std::vector<uint8_t> &, size_t &);
 int ft_stoi(std::string str);
 unsigned int fromHexToDec(const std::string& nb);
+uint64_t monotonicMicros();
 
 template <typename T>
 std::string toString(const T val)
@@ -0,0 +1,247 @@
+#include "CgiPool.hpp"
+#include "Logger.hpp"
+#include <sys/wait.h>
+#include <poll.h>
+#include <csignal>
+
+CgiPool::CgiPool()
+{
+}
+
+CgiPool::~CgiPool()
+{
+	shutdown();
+}
+
+/**
+ * Starts one interpreter running the pool runner
+ *
+ * Example: spawn("/usr/bin/python3")
+ * → fork() + execve("/usr/bin/python3", {"/usr/bin/python3", "cgi-pool/worker.py"})
+ * its stdin/stdout are pipes; our ends are non-blocking and close-on-exec
+ * Returns NULL if pipe() or fork() fails
+ */
+CgiWorker* CgiPool::spawn(const std::string& interpreter)
+{
+	int in[2];
+	int out[2];
+
+	if (pipe(in) < 0)
+		return NULL;
+	if (pipe(out) < 0)
+	{
+		close(in[0]);
+		close(in[1]);
+		return NULL;
+	}
+	for (int i = 0; i < 2; ++i)
+	{
+		fcntl(in[i], F_SETFD, FD_CLOEXEC);
+		fcntl(out[i], F_SETFD, FD_CLOEXEC);
+	}
+
+	// Built before fork(): only async-signal-safe calls in the child
+	char* argv[] = {const_cast<char*>(interpreter.c_str()), const_cast<char*>(CGI_POOL_WORKER), NULL};
+	sigset_t no_signals;
+	sigemptyset(&no_signals);
+	pid_t pid = fork();
+	if (pid == 0)
+	{
+		sigprocmask(SIG_SETMASK, &no_signals, NULL);  // SIGCHLD is blocked for the signalfd
+		dup2(in[0], STDIN_FILENO);
+		dup2(out[1], STDOUT_FILENO);
+		execve(argv[0], argv, environ);
+		_exit(127);
+	}
+	close(in[0]);
+	close(out[1]);
+	if (pid < 0)
+	{
+		Logger::error("CGI pool: fork() failed: " + std::string(strerror(errno)));
+		close(in[1]);
+		close(out[0]);
+		return NULL;
+	}
+	fcntl(in[1], F_SETFL, fcntl(in[1], F_GETFL, 0) | O_NONBLOCK);
+	fcntl(out[0], F_SETFL, fcntl(out[0], F_GETFL, 0) | O_NONBLOCK);
+
+	CgiWorker* worker = new CgiWorker;
+	worker->pid = pid;
+	worker->to_worker = in[1];
+	worker->from_worker = out[0];
+	worker->served = 0;
+	worker->busy = false;
+	worker->interpreter = interpreter;
+	LOG_INFO("CGI pool: started " + interpreter + " (pid " + toString(pid) + ")");
+	return worker;
+}
+
+/**
+ * Health check of an idle worker before it gets a request
+ *
+ * Still running, and nothing to read on its stdout: an idle runner never
+ * writes, so readable data or a hang-up means it is broken or gone
+ */
+bool CgiPool::healthy(const CgiWorker& worker) const
+{
+	struct pollfd pfd;
+
+	pfd.fd = worker.from_worker;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	return poll(&pfd, 1, 0) == 0 && kill(worker.pid, 0) == 0;
+}
+
+/**
+ * Closes our ends of its pipes and forgets the worker; it is reaped
+ * with the other children (ServerManager's ChildRegistry)
+ *
+ * signal = 0: graceful (EOF on its stdin ends the runner's loop)
+ * signal = SIGKILL: a request was in flight (timeout, client gone, protocol error)
+ */
+void CgiPool::retire(CgiWorker* worker, int signal)
+{
+	close(worker->to_worker);
+	close(worker->from_worker);
+	if (signal)
+		kill(worker->pid, signal);
+	delete worker;
+}
+
+/**
+ * Idle healthy worker of this interpreter, or a new one while the pool is
+ * below size, marked busy. NULL: every worker is busy (or none could start)
+ */
+CgiWorker* CgiPool::acquire(const std::string& interpreter)
+{
+	std::vector<CgiWorker*>& workers = _pools[interpreter].workers;
+	size_t size = _pools[interpreter].size;
+
+	for (size_t i = 0; i < workers.size(); )
+	{
+		CgiWorker* worker = workers[i];
+		if (worker->busy)
+		{
+			++i;
+			continue;
+		}
+		if (healthy(*worker))
+		{
+			worker->busy = true;
+			worker->reader.reset();
+			return worker;
+		}
+		Logger::warn("CGI pool: worker pid " + toString(worker->pid) + " is not healthy, replacing it");
+		workers.erase(workers.begin() + i);
+		retire(worker, SIGKILL);
+	}
+	if (workers.size() >= size)
+		return NULL;
+	CgiWorker* worker = spawn(interpreter);
+	if (worker)
+	{
+		worker->busy = true;
+		workers.push_back(worker);
+	}
+	return worker;
+}
+
+/**
+ * Request completed: the worker goes back to the idle set,
+ * or is retired once it has served max_requests requests
+ */
+void CgiPool::release(CgiWorker* worker, size_t max_requests)
+{
+	worker->busy = false;
+	if (++worker->served < max_requests)
+		return;
+	LOG_INFO("CGI pool: recycling pid " + toString(worker->pid) + " after " + toString(worker->served) + " requests");
+	std::vector<CgiWorker*>& workers = _pools[worker->interpreter].workers;
+	workers.erase(std::find(workers.begin(), workers.end(), worker));
+	retire(worker, 0);
+}
+
+/**
+ * Worker in an unknown state (request aborted mid-way): killed, not reused
+ */
+void CgiPool::discard(CgiWorker* worker)
+{
+	std::vector<CgiWorker*>& workers = _pools[worker->interpreter].workers;
+	workers.erase(std::find(workers.begin(), workers.end(), worker));
+	retire(worker, SIGKILL);
+}
+
+/**
+ * Returns false when the queue is full: the request gets a 503
+ */
+bool CgiPool::enqueue(const std::string& interpreter, size_t size, int client_fd)
+{
+	Pool& pool = _pools[interpreter];
+
+	pool.size = size;
+	if (pool.waiting.size() >= CGI_POOL_QUEUE)
+		return false;
+	pool.waiting.push_back(client_fd);
+	return true;
+}
+
+bool CgiPool::hasWaiting(const std::string& interpreter) const
+{
+	std::map<std::string, Pool>::const_iterator it = _pools.find(interpreter);
+	return it != _pools.end() && !it->second.waiting.empty();
+}
+
+int CgiPool::popWaiting(const std::string& interpreter)
+{
+	std::deque<int>& waiting = _pools[interpreter].waiting;
+
+	if (waiting.empty())
+		return -1;
+	int client_fd = waiting.front();
+	waiting.pop_front();
+	return client_fd;
+}
+
+/**
+ * Client closed while waiting for a worker
+ */
+void CgiPool::forget(const std::string& interpreter, int client_fd)
+{
+	std::deque<int>& waiting = _pools[interpreter].waiting;
+	std::deque<int>::iterator it = std::find(waiting.begin(), waiting.end(), client_fd);
+
+	if (it != waiting.end())
+		waiting.erase(it);
+}
+
+size_t CgiPool::busy(const std::string& interpreter) const
+{
+	std::map<std::string, Pool>::const_iterator it = _pools.find(interpreter);
+	size_t count = 0;
+
+	if (it == _pools.end())
+		return 0;
+	for (size_t i = 0; i < it->second.workers.size(); ++i)
+		count += it->second.workers[i]->busy;
+	return count;
+}
+
+/**
+ * Stops every interpreter and waits for them (server shutdown)
+ */
+void CgiPool::shutdown()
+{
+	std::vector<pid_t> pids;
+
+	for (std::map<std::string, Pool>::iterator it = _pools.begin(); it != _pools.end(); ++it)
+	{
+		for (size_t i = 0; i < it->second.workers.size(); ++i)
+		{
+			pids.push_back(it->second.workers[i]->pid);
+			retire(it->second.workers[i], SIGTERM);
+		}
+	}
+	_pools.clear();
+	for (size_t i = 0; i < pids.size(); ++i)
+		waitpid(pids[i], NULL, 0);
+}
@@ -0,0 +1,94 @@
+#include "CgiStdin.hpp"
+#include "FastCgi.hpp"
+
+CgiStdin::CgiStdin()
+{
+	reset();
+}
+
+void CgiStdin::reset()
+{
+	_body = NULL;
+	_frame.clear();
+	_frame_sent = 0;
+	_body_sent = 0;
+	_record_left = 0;
+	_fastcgi = false;
+	_end_framed = false;
+}
+
+/**
+ * Forked CGI: the raw body, then EOF (the caller closes the pipe)
+ */
+void CgiStdin::start(const BodySink& body)
+{
+	reset();
+	_body = &body;
+}
+
+/**
+ * Pool interpreter: head (FastCgi::encodeHead()), then the body as STDIN records
+ */
+void CgiStdin::start(const BodySink& body, const std::string& head)
+{
+	reset();
+	_body = &body;
+	_frame = head;
+	_fastcgi = true;
+}
+
+/**
+ * Writes until the pipe is full or everything is sent
+ *
+ * Example: forked CGI, 50KB body, pipe takes 16KB per write
+ * write(16KB) → _body_sent=16384, write(16KB), write(16KB), EAGAIN
+ * → STDIN_BLOCKED; next call: write(2KB) → STDIN_DONE
+ * Returns STDIN_CLOSED if the reader went away (EPIPE): the rest is dropped
+ */
+CgiStdin::Status CgiStdin::send(int fd)
+{
+	while (true)
+	{
+		ssize_t bytes;
+
+		if (_frame_sent < _frame.size())
+			bytes = write(fd, _frame.data() + _frame_sent, _frame.size() - _frame_sent);
+		else
+		{
+			size_t left = _body ? _body->size() - _body_sent : 0;
+
+			if (_fastcgi && _record_left == 0)
+			{
+				if (_end_framed)
+					return STDIN_DONE;
+				_record_left = std::min(left, (size_t)FCGI_MAX_CONTENT);
+				_end_framed = (left == 0);
+				_frame.clear();
+				_frame_sent = 0;
+				FastCgi::appendHeader(_frame, FCGI_STDIN, _record_left);
+				continue;
+			}
+			if (left == 0)
+				return STDIN_DONE;
+			bytes = _body->writeTo(fd, _body_sent, _fastcgi ? _record_left : left);
+			if (bytes > 0)
+			{
+				_body_sent += bytes;
+				if (_fastcgi)
+					_record_left -= bytes;
+				continue;
+			}
+		}
+
+		if (bytes > 0)
+		{
+			_frame_sent += bytes;
+			continue;
+		}
+		if (bytes < 0 && errno == EINTR)
+			continue;
+		if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			return STDIN_BLOCKED;
+		return STDIN_CLOSED;
+	}
+}
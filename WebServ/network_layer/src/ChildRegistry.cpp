@@ -0,0 +1,144 @@
+#include "ChildRegistry.hpp"
+#include "Logger.hpp"
+#include <sys/wait.h>
+#ifdef __linux__
+# include <sys/signalfd.h>
+#endif
+
+int ChildRegistry::_signal_fd = -1;
+
+ChildRegistry::ChildRegistry() : _fd(-1), _notify_fd(-1)
+{
+}
+
+ChildRegistry::~ChildRegistry()
+{
+	if (_fd >= 0)
+		close(_fd);
+	if (_notify_fd >= 0)
+	{
+		signal(SIGCHLD, SIG_DFL);
+		_signal_fd = -1;
+		close(_notify_fd);
+	}
+}
+
+/**
+ * Self-pipe variant: one byte per SIGCHLD (a full pipe already says "reap")
+ */
+void ChildRegistry::handleChild(int signum)
+{
+	int saved_errno = errno;
+
+	(void)signum;
+	if (_signal_fd >= 0)
+	{
+		ssize_t written = write(_signal_fd, "", 1);
+		(void)written;
+	}
+	errno = saved_errno;
+}
+
+/**
+ * Creates the SIGCHLD fd; call before any thread is started (signal mask)
+ *
+ * Example (Linux): SIGCHLD blocked → signalfd(SIGCHLD) = fd 4, non-blocking
+ * Children get a clean mask back before execve() (see CgiHandler, CgiPool)
+ * Returns false if the fd cannot be created
+ */
+bool ChildRegistry::open()
+{
+	sigset_t mask;
+
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGCHLD);
+#ifdef __linux__
+	sigprocmask(SIG_BLOCK, &mask, NULL);
+	_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+	return _fd >= 0;
+#else
+	int fds[2];
+	struct sigaction sa;
+
+	if (pipe(fds) < 0)
+		return false;
+	for (int i = 0; i < 2; ++i)
+	{
+		fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+		fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL, 0) | O_NONBLOCK);
+	}
+	_fd = fds[0];
+	_notify_fd = fds[1];
+	_signal_fd = _notify_fd;
+	memset(&sa, 0, sizeof(sa));
+	sigemptyset(&sa.sa_mask);
+	sa.sa_handler = handleChild;
+	sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+	sigaction(SIGCHLD, &sa, NULL);
+	sigprocmask(SIG_UNBLOCK, &mask, NULL);
+	return true;
+#endif
+}
+
+int ChildRegistry::fd() const
+{
+	return _fd;
+}
+
+void ChildRegistry::track(pid_t pid, int owner)
+{
+	_owners[pid] = owner;
+}
+
+/**
+ * Its client is gone: the child is still reaped, nobody is told
+ */
+void ChildRegistry::disown(pid_t pid)
+{
+	std::map<pid_t, int>::iterator it = _owners.find(pid);
+
+	if (it != _owners.end())
+		it->second = -1;
+}
+
+/**
+ * Empties the notification fd, then collects every exited child
+ *
+ * Example: 3 CGIs exit at once → one signalfd read (signals coalesce)
+ * → waitpid(-1, WNOHANG) returns 300, 301, 302, then 0 → 3 entries
+ */
+void ChildRegistry::reap(std::vector<ChildExit>& exited)
+{
+	char buffer[128];
+	pid_t pid;
+	int status;
+
+	exited.clear();
+	while (read(_fd, buffer, sizeof(buffer)) > 0)
+		;
+	while ((pid = waitpid(-1, &status, WNOHANG)) > 0)
+	{
+		ChildExit child;
+		std::map<pid_t, int>::iterator it = _owners.find(pid);
+
+		child.pid = pid;
+		child.owner = -1;
+		child.status = status;
+		if (it != _owners.end())
+		{
+			child.owner = it->second;
+			_owners.erase(it);
+		}
+		exited.push_back(child);
+	}
+}
+
+/**
+ * Server shutdown: waits for the children still tracked (killed by then)
+ */
+void ChildRegistry::waitAll()
+{
+	for (std::map<pid_t, int>::iterator it = _owners.begin(); it != _owners.end(); ++it)
+		waitpid(it->first, NULL, 0);
+	_owners.clear();
+}
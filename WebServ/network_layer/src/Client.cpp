@@ -1,13 +1,21 @@
 #include "Client.hpp"
 
 /**
- * Default constructor (unused, for map compatibility)
+ * Default constructor (ClientPool slabs: bound to a socket later by reset())
  */
-Client::Client() : socket_fd(-1), last_activity(0), write_offset(0), parse_offset(0)
+Client::Client() : socket_fd(-1), write_offset(0), head_offset(0), file_offset(0), parse_offset(0), response_pending(false), file_job(false), close_pending(false), read_paused(false), cgi_paused(false)
 {
 	memset(&address, 0, sizeof(address));
 	listen_fd_owner = -1;
 	server_config = NULL;
+	phase = TIMEOUT_HEADER;
+	bytes_sent = 0;
+	parse_us = 0;
+	cgi_start = 0;
+	write_start = 0;
+	cgi_worker = NULL;
+	cgi_exit = -1;
+	cgi_output = 0;
 }
 
 /**
@@ -18,56 +26,68 @@ Client::Client() : socket_fd(-1), last_activity(0), write_offset(0), parse_offse
  * Creates:
  * - socket_fd = 10
  * - read_buffer = "" (empty, will fill when data arrives)
- * - write_buffer = "" (empty, will fill with response)
- * - write_offset = 0 (no data sent yet)
- * - last_activity = current timestamp
+ * - write_buffer = "" (empty, will fill with streamed body slices)
+ * - write_offset = head_offset = 0 (no data sent yet)
+ * - phase = TIMEOUT_HEADER (timer armed by ServerManager)
  */
 Client::Client(int fd, const struct sockaddr_in& addr) 
-	: socket_fd(fd), address(addr), last_activity(time(NULL)), write_offset(0), parse_offset(0)
+	: socket_fd(fd), address(addr), write_offset(0), head_offset(0), file_offset(0), parse_offset(0), response_pending(false), file_job(false), close_pending(false), read_paused(false), cgi_paused(false)
 {
 	listen_fd_owner = -1;
 	server_config = NULL;
+	timer.fd = fd;
+	phase = TIMEOUT_HEADER;
+	bytes_sent = 0;
+	parse_us = 0;
+	cgi_start = 0;
+	write_start = 0;
+	cgi_worker = NULL;
+	cgi_exit = -1;
+	cgi_output = 0;
 }
 
 /**
- * Updates last activity timestamp (called on every read/write)
+ * Rebinds a recycled Client to a new connection (see ClientPool)
  * 
- * Example: Browser sends data or we send response
- * last_activity = 1234567890 → 1234567920 (updated to now)
- * Prevents timeout for active connections
+ * Example: slot used by fd=10 is handed to fd=13
+ * socket_fd=13, address=new peer, buffers emptied but not freed,
+ * request/response cleared, listener and server config forgotten,
+ * back to the header phase (the timer is disarmed by closeClient())
  */
-void Client::updateActivity()
+void Client::reset(int fd, const struct sockaddr_in& addr)
 {
-	last_activity = time(NULL);
-}
-
-/**
- * Checks if client has been idle too long
- * 
- * Example: Check if fd=10 timed out
- * last_activity = 1234567890
- * current_time = 1234567950
- * timeout = 60
- * Returns: (1234567950 - 1234567890) > 60 = false (still ok)
- * 
- * If 61+ seconds pass → returns true → close connection
- */
-bool Client::isTimedOut(time_t current_time, int timeout) const
-{
-	return (current_time - last_activity) > timeout;
+	socket_fd = fd;
+	address = addr;
+	read_buffer.clear();
+	clear();
+	response.cgi_obj.clear();
+	listen_fd_owner = -1;
+	server_config = NULL;
+	timer.fd = fd;
+	phase = TIMEOUT_HEADER;
+	cgi_worker = NULL;
+	file_job = false;
+	close_pending = false;
+	read_paused = false;
 }
 
 /**
  * Resets client for connection reuse (keep-alive)
  * 
  * Example: After sending banana.jpg, prepare for next request
- * Before: read_buffer="GET /banana.jpg...", write_buffer="HTTP/1.1 200..."
- * After:  read_buffer="", write_buffer="", write_offset=0
+ * Before: read_buffer="GET /banana.jpg...GET /style.css...", parse_offset=40
+ *         head_offset=180, file_offset=50000
+ * After:  read_buffer="GET /style.css..." (pipelined request kept)
+ *         write_buffer="", head_offset=0, file_offset=0, parse_offset=0
  * 
+ * The connection itself (socket, listener, server config) is kept
  * Also shrinks buffers if they grew too large (memory optimization)
  */
 void Client::clear()
 {
+	read_buffer.erase(0, parse_offset);
+	write_buffer.clear();
+	
 	// Optimize memory usage by shrinking buffers if they're too large (C++98 compatible)
 	if (read_buffer.capacity() > MESSAGE_BUFFER * 2)
 	{
@@ -76,18 +96,25 @@ void Client::clear()
 	}
 	if (write_buffer.capacity() > MESSAGE_BUFFER * 2)
 	{
-		std::string tmp = write_buffer;
+		std::string tmp;
 		write_buffer.swap(tmp);
 	}
 	
-	read_buffer.clear();
-	write_buffer.clear();
 	write_offset = 0;
+	head_offset = 0;
+	file_offset = 0;
 	parse_offset = 0;
+	bytes_sent = 0;
+	parse_us = 0;
+	cgi_start = 0;
+	write_start = 0;
+	cgi_exit = -1;
+	cgi_output = 0;
+	cgi_stdin.reset();
+	response_pending = false;
+	cgi_paused = false;
 	request.clear();
 	response.clear();
-	listen_fd_owner = -1;
-	server_config = NULL;
 }
 
 /**
@@ -0,0 +1,65 @@
+#include "ClientPool.hpp"
+
+ClientPool::ClientPool() : _in_use(0)
+{
+}
+
+ClientPool::~ClientPool()
+{
+	for (size_t i = 0; i < _slabs.size(); ++i)
+		delete[] _slabs[i];
+}
+
+/**
+ * Hands out a Client for a new connection
+ * 
+ * Example: accept() returned fd=10 from 127.0.0.1:54321
+ * Free list empty → grow() allocates 64 Clients
+ * Returns a Client reset for fd=10 (socket_fd=10, empty buffers)
+ */
+Client* ClientPool::acquire(int fd, const struct sockaddr_in& addr)
+{
+	if (_free.empty())
+		grow();
+	Client* client = _free.back();
+	_free.pop_back();
+	client->reset(fd, addr);
+	_in_use++;
+	return client;
+}
+
+/**
+ * Takes back the Client of a closed connection
+ * 
+ * Example: fd=10 closed
+ * Response file and body producer are released, request cleared,
+ * the object goes back on the free list (memory kept for the next connection)
+ */
+void ClientPool::release(Client* client)
+{
+	if (!client)
+		return;
+	client->reset(-1, client->address);
+	_free.push_back(client);
+	_in_use--;
+}
+
+size_t ClientPool::inUse() const
+{
+	return _in_use;
+}
+
+/**
+ * Adds one slab to the pool
+ * 
+ * Example: first connection
+ * _slabs = {[64 Clients]}, _free = 64 pointers into it
+ */
+void ClientPool::grow()
+{
+	Client* slab = new Client[CLIENT_SLAB_SIZE];
+	_slabs.push_back(slab);
+	_free.reserve(_free.size() + CLIENT_SLAB_SIZE);
+	for (int i = CLIENT_SLAB_SIZE - 1; i >= 0; --i)
+		_free.push_back(&slab[i]);
+}
@@ -0,0 +1,59 @@
+#include "DispatchTable.hpp"
+
+DispatchTable::DispatchTable()
+{
+	_none.role = FD_NONE;
+	_none.owner = -1;
+}
+
+/**
+ * Records the role and owner of fd (grows the table on demand)
+ * 
+ * Example: CGI for client 10 opens pipe_out[0]=15
+ * set(15, FD_CGI_STDOUT, 10) → _slots[15] = {FD_CGI_STDOUT, 10}
+ */
+void DispatchTable::set(int fd, FdRole role, int owner)
+{
+	if (fd < 0)
+		return;
+	if ((size_t)fd >= _slots.size())
+		_slots.resize(fd + 1, _none);
+	_slots[fd].role = role;
+	_slots[fd].owner = owner;
+}
+
+/**
+ * Forgets fd (call when it is closed)
+ * 
+ * Example: close(15) → clear(15) → _slots[15] = {FD_NONE, -1}
+ */
+void DispatchTable::clear(int fd)
+{
+	if (fd >= 0 && (size_t)fd < _slots.size())
+		_slots[fd] = _none;
+}
+
+/**
+ * Constant-time lookup of the handler for fd
+ * 
+ * Example: wait() reports fd=15 readable
+ * get(15) → {FD_CGI_STDOUT, 10} → read CGI output of client 10
+ */
+const FdSlot& DispatchTable::get(int fd) const
+{
+	if (fd < 0 || (size_t)fd >= _slots.size())
+		return _none;
+	return _slots[fd];
+}
+
+/**
+ * Checks that fd is still open with the given role and owner
+ * 
+ * Example: client 10 closes while its CGI stdin pipe 16 is open
+ * is(16, FD_CGI_STDIN, 10) → true → pipe must be closed too
+ */
+bool DispatchTable::is(int fd, FdRole role, int owner) const
+{
+	const FdSlot& slot = get(fd);
+	return slot.role == role && slot.owner == owner;
+}
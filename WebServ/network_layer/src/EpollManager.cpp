@@ -0,0 +1,191 @@
+#include "EpollManager.hpp"
+#include "FdSetManager.hpp"
+
+#ifdef __linux__
+
+#define EPOLL_BATCH 1024
+
+/**
+ * Creates the epoll instance used by the event loop
+ * 
+ * Example: epoll_create1() returns epfd=3
+ * Every socket/pipe we monitor is registered on fd=3
+ */
+EpollManager::EpollManager() : _epfd(-1), _ready(EPOLL_BATCH)
+{
+	_epfd = epoll_create1(EPOLL_CLOEXEC);
+	if (_epfd < 0)
+		throw std::runtime_error("Failed to create epoll instance: " + std::string(strerror(errno)));
+}
+
+EpollManager::~EpollManager()
+{
+	if (_epfd >= 0)
+		close(_epfd);
+}
+
+/**
+ * Registers / updates / removes fd in the epoll interest list
+ * 
+ * Example: fd=10 is read-only and starts writing a response
+ * Before: _interest[10] = IO_READ
+ * After:  _interest[10] = IO_READ | IO_WRITE → EPOLL_CTL_MOD
+ * 
+ * All fds are edge-triggered (EPOLLET): one notification per new
+ * readiness, so handlers drain until EAGAIN
+ */
+bool EpollManager::setInterest(int fd, int mask)
+{
+	if (fd < 0)
+		return false;
+	if ((size_t)fd >= _interest.size())
+		_interest.resize(fd + 1, 0);
+	
+	int old_mask = _interest[fd];
+	if (old_mask == mask)
+		return true;
+	
+	if (mask == 0)
+	{
+		epoll_ctl(_epfd, EPOLL_CTL_DEL, fd, NULL);
+		_interest[fd] = 0;
+		return true;
+	}
+	
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLET | EPOLLRDHUP;
+	if (mask & IO_READ)
+		ev.events |= EPOLLIN;
+	if (mask & IO_WRITE)
+		ev.events |= EPOLLOUT;
+	ev.data.fd = fd;
+	
+	int op = old_mask ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+	if (epoll_ctl(_epfd, op, fd, &ev) < 0)
+	{
+		// fd was closed and reused behind our back: register it again
+		if (op == EPOLL_CTL_MOD && errno == ENOENT)
+			op = EPOLL_CTL_ADD;
+		else if (op == EPOLL_CTL_ADD && errno == EEXIST)
+			op = EPOLL_CTL_MOD;
+		else
+			return false;
+		if (epoll_ctl(_epfd, op, fd, &ev) < 0)
+			return false;
+	}
+	_interest[fd] = mask;
+	return true;
+}
+
+bool EpollManager::addRead(int fd)
+{
+	int mask = (fd >= 0 && (size_t)fd < _interest.size()) ? _interest[fd] : 0;
+	return setInterest(fd, mask | IO_READ);
+}
+
+bool EpollManager::addWrite(int fd)
+{
+	int mask = (fd >= 0 && (size_t)fd < _interest.size()) ? _interest[fd] : 0;
+	return setInterest(fd, mask | IO_WRITE);
+}
+
+void EpollManager::removeRead(int fd)
+{
+	if (fd >= 0 && (size_t)fd < _interest.size())
+		setInterest(fd, _interest[fd] & ~IO_READ);
+}
+
+void EpollManager::removeWrite(int fd)
+{
+	if (fd >= 0 && (size_t)fd < _interest.size())
+		setInterest(fd, _interest[fd] & ~IO_WRITE);
+}
+
+/**
+ * Forgets fd entirely (call BEFORE close())
+ * 
+ * Example: closeClient(10) → removeFd(10) → close(10)
+ * The kernel also drops closed fds, but _interest must be reset
+ * so a future socket reusing fd=10 is registered with EPOLL_CTL_ADD
+ */
+void EpollManager::removeFd(int fd)
+{
+	if (fd >= 0 && (size_t)fd < _interest.size())
+		setInterest(fd, 0);
+}
+
+bool EpollManager::isWriting(int fd) const
+{
+	return fd >= 0 && (size_t)fd < _interest.size() && (_interest[fd] & IO_WRITE);
+}
+
+/**
+ * Waits for readiness and converts epoll events to IoEvents
+ * 
+ * Example: 50000 idle keep-alive clients, 3 send data
+ * epoll_wait() returns 3 → events = [{fd:12,READ}, {fd:9001,READ}, {fd:40000,READ}]
+ * Cost is O(ready fds), not O(max_fd) like select()
+ * 
+ * Hang-ups and errors are reported as IO_READ (and IO_WRITE when the fd
+ * is writing) so the handler sees EOF/error from recv()/send()
+ */
+int EpollManager::wait(std::vector<IoEvent>& events, int timeout_ms)
+{
+	events.clear();
+	int ready = epoll_wait(_epfd, &_ready[0], _ready.size(), timeout_ms);
+	if (ready < 0)
+		return (errno == EINTR) ? 0 : -1;
+	
+	for (int i = 0; i < ready; ++i)
+	{
+		IoEvent ev;
+		int fd = _ready[i].data.fd;
+		uint32_t flags = _ready[i].events;
+		int mask = ((size_t)fd < _interest.size()) ? _interest[fd] : 0;
+		
+		ev.fd = fd;
+		ev.events = 0;
+		if (flags & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+			ev.events |= IO_READ;
+		if (flags & EPOLLOUT)
+			ev.events |= IO_WRITE;
+		if ((flags & (EPOLLHUP | EPOLLERR)) && (mask & IO_WRITE))
+			ev.events |= IO_WRITE;
+		ev.events &= mask;
+		if (ev.events)
+			events.push_back(ev);
+	}
+	
+	// A full batch means more fds may be ready: grow for the next call
+	if ((size_t)ready == _ready.size())
+		_ready.resize(_ready.size() * 2);
+	return events.size();
+}
+
+bool EpollManager::edgeTriggered() const
+{
+	return true;
+}
+
+const char* EpollManager::name() const
+{
+	return "epoll";
+}
+
+#endif
+
+/**
+ * Picks the best readiness backend for this platform
+ * 
+ * Linux → epoll (edge-triggered, no FD_SETSIZE limit)
+ * Other → select (portable fallback)
+ */
+EventLoop* EventLoop::create()
+{
+#ifdef __linux__
+	return new EpollManager();
+#else
+	return new FdSetManager();
+#endif
+}
@@ -0,0 +1,149 @@
+#include "FastCgi.hpp"
+#include "Logger.hpp"
+
+/**
+ * Appends one record, content split if it exceeds 65535 bytes
+ *
+ * Example: appendRecord(out, FCGI_STDIN, body, 100000)
+ * → STDIN record of 65535 bytes, then one of 34465
+ * len = 0 → a single empty record (end of that stream)
+ */
+void FastCgi::appendRecord(std::string& out, FastCgiType type, const char* data, size_t len)
+{
+	do
+	{
+		size_t chunk = std::min(len, (size_t)FCGI_MAX_CONTENT);
+		appendHeader(out, type, chunk);
+		out.append(data, chunk);
+		data += chunk;
+		len -= chunk;
+	} while (len > 0);
+}
+
+/**
+ * Header of a record of len bytes (at most FCGI_MAX_CONTENT, no padding);
+ * its content is written separately (CgiStdin streams STDIN from the body)
+ */
+void FastCgi::appendHeader(std::string& out, FastCgiType type, size_t len)
+{
+	unsigned char header[FCGI_HEADER_LEN] = {
+		FCGI_VERSION_1, (unsigned char)type, 0, FCGI_REQUEST_ID,
+		(unsigned char)(len >> 8), (unsigned char)(len & 0xff), 0, 0
+	};
+	out.append(reinterpret_cast<char*>(header), FCGI_HEADER_LEN);
+}
+
+/**
+ * Name-value pair length: 1 byte below 128, else 4 bytes with the high bit set
+ */
+void FastCgi::appendLength(std::string& out, size_t len)
+{
+	if (len < 128)
+	{
+		out += (char)len;
+		return;
+	}
+	out += (char)((len >> 24) | 0x80);
+	out += (char)((len >> 16) & 0xff);
+	out += (char)((len >> 8) & 0xff);
+	out += (char)(len & 0xff);
+}
+
+/**
+ * Start of a request, up to its body: BEGIN_REQUEST and the PARAMS stream
+ *
+ * envp is the one built by CgiHandler ("NAME=value" strings, NULL
+ * terminated), split at the first '=' into name-value pairs.
+ * The script to run travels as the WEBSERV_SCRIPT parameter (removed from
+ * the environment the script sees). The STDIN stream follows, written by
+ * CgiStdin straight from the request body
+ */
+std::string FastCgi::encodeHead(const std::string& script, char* const* envp)
+{
+	static const char begin[FCGI_HEADER_LEN] = {0, FCGI_RESPONDER, FCGI_KEEP_CONN, 0, 0, 0, 0, 0};
+	std::string pairs;
+	std::string out;
+
+	appendLength(pairs, 14);
+	appendLength(pairs, script.size());
+	pairs.append("WEBSERV_SCRIPT").append(script);
+	for (size_t i = 0; envp && envp[i]; ++i)
+	{
+		const char* sep = strchr(envp[i], '=');
+		size_t name_len = sep ? (size_t)(sep - envp[i]) : strlen(envp[i]);
+		const char* value = sep ? sep + 1 : "";
+		size_t value_len = strlen(value);
+
+		appendLength(pairs, name_len);
+		appendLength(pairs, value_len);
+		pairs.append(envp[i], name_len).append(value, value_len);
+	}
+
+	out.reserve(pairs.size() + 4 * FCGI_HEADER_LEN + FCGI_HEADER_LEN);
+	appendRecord(out, FCGI_BEGIN_REQUEST, begin, sizeof(begin));
+	appendRecord(out, FCGI_PARAMS, pairs.data(), pairs.size());
+	appendRecord(out, FCGI_PARAMS, "", 0);
+	return out;
+}
+
+FastCgiReader::FastCgiReader() : _app_status(0)
+{
+}
+
+void FastCgiReader::reset()
+{
+	_pending.clear();
+	_app_status = 0;
+}
+
+int FastCgiReader::appStatus() const
+{
+	return _app_status;
+}
+
+/**
+ * Consumes every complete record in _pending + data
+ *
+ * Returns FEED_END after END_REQUEST, FEED_ERROR on a malformed record
+ * (the interpreter is out of sync: it must be discarded)
+ */
+FastCgiReader::Status FastCgiReader::feed(const char* data, size_t len, StreamSource& out)
+{
+	size_t offset = 0;
+
+	_pending.append(data, len);
+	while (_pending.size() - offset >= FCGI_HEADER_LEN)
+	{
+		const unsigned char* header = reinterpret_cast<const unsigned char*>(_pending.data() + offset);
+		size_t content = (header[4] << 8) | header[5];
+		size_t record = FCGI_HEADER_LEN + content + header[6];
+
+		if (header[0] != FCGI_VERSION_1)
+			return FEED_ERROR;
+		if (_pending.size() - offset < record)
+			break;
+
+		const char* body = _pending.data() + offset + FCGI_HEADER_LEN;
+		switch (header[1])
+		{
+			case FCGI_STDOUT:
+				out.append(body, content);
+				break;
+			case FCGI_STDERR:
+				Logger::warn("CGI stderr: " + std::string(body, content));
+				break;
+			case FCGI_END_REQUEST:
+				if (content < 4)
+					return FEED_ERROR;
+				_app_status = ((unsigned char)body[0] << 24) | ((unsigned char)body[1] << 16)
+					| ((unsigned char)body[2] << 8) | (unsigned char)body[3];
+				_pending.clear();
+				return FEED_END;
+			default:
+				return FEED_ERROR;
+		}
+		offset += record;
+	}
+	_pending.erase(0, offset);
+	return FEED_MORE;
+}
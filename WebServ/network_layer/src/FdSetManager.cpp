@@ -1,6 +1,10 @@
 #include "FdSetManager.hpp"
 
-FdSetManager::FdSetManager() : _max_fd(0) {}
+FdSetManager::FdSetManager() : _max_fd(0)
+{
+	FD_ZERO(&_read_set);
+	FD_ZERO(&_write_set);
+}
 
 /**
  * Adds file descriptor to fd_set for select() monitoring
@@ -77,3 +81,98 @@ int FdSetManager::getMaxFd() const
 	return _max_fd;
 }
 
+
+/**
+ * EventLoop backend: monitors fd for reading in the internal read set
+ * 
+ * Example: New client fd=10 → addRead(10) → next wait() reports it
+ * Returns false when fd cannot be stored in an fd_set (fd >= FD_SETSIZE),
+ * caller must then drop the connection
+ */
+bool FdSetManager::addRead(int fd)
+{
+	if (fd < 0 || fd >= FD_SETSIZE)
+		return false;
+	add(fd, _read_set);
+	return true;
+}
+
+bool FdSetManager::addWrite(int fd)
+{
+	if (fd < 0 || fd >= FD_SETSIZE)
+		return false;
+	add(fd, _write_set);
+	return true;
+}
+
+void FdSetManager::removeRead(int fd)
+{
+	if (fd >= 0 && fd < FD_SETSIZE)
+		remove(fd, _read_set);
+}
+
+void FdSetManager::removeWrite(int fd)
+{
+	if (fd >= 0 && fd < FD_SETSIZE)
+		remove(fd, _write_set);
+}
+
+void FdSetManager::removeFd(int fd)
+{
+	removeRead(fd);
+	removeWrite(fd);
+}
+
+bool FdSetManager::isWriting(int fd) const
+{
+	return fd >= 0 && fd < FD_SETSIZE && isSet(fd, _write_set);
+}
+
+/**
+ * Calls select() on copies of the sets and collects ready fds
+ * 
+ * Example: _read_set = {5, 10}, browser sends data on fd=10
+ * select() returns 1 → events = [{fd:10, events:IO_READ}]
+ * 
+ * Cost is O(max_fd) per call: every fd up to _max_fd is tested
+ */
+int FdSetManager::wait(std::vector<IoEvent>& events, int timeout_ms)
+{
+	fd_set read_cpy = _read_set;
+	fd_set write_cpy = _write_set;
+	struct timeval timeout;
+	
+	timeout.tv_sec = timeout_ms / 1000;
+	timeout.tv_usec = (timeout_ms % 1000) * 1000;
+	events.clear();
+	
+	int ready = select(_max_fd + 1, &read_cpy, &write_cpy, NULL, &timeout);
+	if (ready < 0)
+		return (errno == EINTR) ? 0 : -1;
+	if (ready == 0)
+		return 0;
+	
+	for (int fd = 0; fd <= _max_fd; ++fd)
+	{
+		IoEvent ev;
+		ev.fd = fd;
+		ev.events = 0;
+		if (isSet(fd, read_cpy))
+			ev.events |= IO_READ;
+		if (isSet(fd, write_cpy))
+			ev.events |= IO_WRITE;
+		if (ev.events)
+			events.push_back(ev);
+	}
+	return events.size();
+}
+
+bool FdSetManager::edgeTriggered() const
+{
+	return false;
+}
+
+const char* FdSetManager::name() const
+{
+	return "select";
+}
@@ -0,0 +1,178 @@
+#include "FilePool.hpp"
+#include "Response.hpp"
+#ifdef __linux__
+# include <sys/eventfd.h>
+#endif
+
+FilePool::FilePool() : _stopping(false), _fd(-1), _notify_fd(-1)
+{
+	pthread_mutex_init(&_lock, NULL);
+	pthread_cond_init(&_wake, NULL);
+}
+
+FilePool::~FilePool()
+{
+	shutdown();
+	if (_fd >= 0)
+		close(_fd);
+	if (_notify_fd >= 0)
+		close(_notify_fd);
+	pthread_cond_destroy(&_wake);
+	pthread_mutex_destroy(&_lock);
+}
+
+/**
+ * Creates the completion fd and starts the threads
+ *
+ * Example (Linux): start(4) → eventfd = fd 7, non-blocking, 4 threads waiting
+ * Threads block every signal: SIGTERM, SIGCHLD... stay with the event loop
+ * Returns false if the fd or the first thread cannot be created
+ */
+bool FilePool::start(size_t threads)
+{
+#ifdef __linux__
+	_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (_fd < 0)
+		return false;
+#else
+	int fds[2];
+
+	if (pipe(fds) < 0)
+		return false;
+	for (int i = 0; i < 2; ++i)
+	{
+		fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+		fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL, 0) | O_NONBLOCK);
+	}
+	_fd = fds[0];
+	_notify_fd = fds[1];
+#endif
+	sigset_t all;
+	sigset_t saved;
+
+	sigfillset(&all);
+	pthread_sigmask(SIG_BLOCK, &all, &saved);
+	for (size_t i = 0; i < threads; ++i)
+	{
+		pthread_t thread;
+		if (pthread_create(&thread, NULL, worker, this) != 0)
+			break;
+		_threads.push_back(thread);
+	}
+	pthread_sigmask(SIG_SETMASK, &saved, NULL);
+	return !_threads.empty();
+}
+
+bool FilePool::running() const
+{
+	return !_threads.empty();
+}
+
+int FilePool::fd() const
+{
+	return _fd;
+}
+
+/**
+ * Queues the disk work of one response, picked by the first free thread
+ *
+ * Example: post(10, &client.response) → a thread runs resolveBody()
+ * Until collect() returns 10, nothing else may use that request or response
+ */
+void FilePool::post(int owner, Response* response)
+{
+	Job job;
+
+	job.owner = owner;
+	job.response = response;
+	pthread_mutex_lock(&_lock);
+	_queue.push_back(job);
+	pthread_cond_signal(&_wake);
+	pthread_mutex_unlock(&_lock);
+}
+
+/**
+ * Finished jobs since the last call, oldest first (fd readable)
+ *
+ * Example: 3 jobs done → eventfd counter 3 → read() resets it → done = {10, 14, 11}
+ */
+void FilePool::collect(std::vector<int>& done)
+{
+#ifdef __linux__
+	uint64_t count;
+	ssize_t got = read(_fd, &count, sizeof(count));
+	(void)got;
+#else
+	char drain[64];
+	while (read(_fd, drain, sizeof(drain)) > 0)
+		;
+#endif
+	pthread_mutex_lock(&_lock);
+	done.swap(_done);
+	_done.clear();
+	pthread_mutex_unlock(&_lock);
+}
+
+/**
+ * Stops the threads once their current job is done; jobs not started are
+ * dropped (their clients are being closed)
+ *
+ * Example: stop() with fd=10 in progress, fd=14 queued
+ * → thread finishes fd=10 and exits, fd=14 never runs
+ */
+void FilePool::shutdown()
+{
+	pthread_mutex_lock(&_lock);
+	_stopping = true;
+	pthread_cond_broadcast(&_wake);
+	pthread_mutex_unlock(&_lock);
+	for (size_t i = 0; i < _threads.size(); ++i)
+		pthread_join(_threads[i], NULL);
+	_threads.clear();
+	_queue.clear();
+}
+
+void* FilePool::worker(void* pool)
+{
+	static_cast<FilePool*>(pool)->runJobs();
+	return NULL;
+}
+
+/**
+ * Thread body: one job at a time, the lock is never held while it runs
+ */
+void FilePool::runJobs()
+{
+	pthread_mutex_lock(&_lock);
+	while (true)
+	{
+		while (_queue.empty() && !_stopping)
+			pthread_cond_wait(&_wake, &_lock);
+		if (_stopping)
+			break;
+		Job job = _queue.front();
+		_queue.pop_front();
+		pthread_mutex_unlock(&_lock);
+
+		job.response->resolveBody();
+
+		pthread_mutex_lock(&_lock);
+		_done.push_back(job.owner);
+		notify();
+	}
+	pthread_mutex_unlock(&_lock);
+}
+
+/**
+ * Makes the completion fd readable (lock held)
+ */
+void FilePool::notify()
+{
+#ifdef __linux__
+	uint64_t one = 1;
+	ssize_t written = write(_fd, &one, sizeof(one));
+#else
+	ssize_t written = write(_notify_fd, "", 1);
+#endif
+	(void)written;
+}
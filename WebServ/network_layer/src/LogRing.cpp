@@ -0,0 +1,101 @@
+#include "LogRing.hpp"
+#include <sys/uio.h>
+#include <cstring>
+
+LogRing::LogRing(int fd) : _buf(LOG_RING_SIZE), _head(0), _tail(0), _dropped(0), _fd(fd)
+{
+}
+
+int LogRing::fd() const
+{
+	return _fd;
+}
+
+/**
+ * Producer side: queues one line, or drops it if the ring is full
+ *
+ * Example: 300 bytes free, 120-byte line → copied, _head += 120
+ * 300 bytes free, 500-byte line → dropped, _dropped = 1
+ * Next push with room: "[logger] 1 line(s) dropped\n" goes in first
+ */
+bool LogRing::push(const char* data, size_t len)
+{
+	if (_dropped > 0)
+	{
+		std::string notice = "[logger] " + toString(_dropped) + " line(s) dropped\n";
+		if (!copyIn(notice.data(), notice.size()))
+		{
+			_dropped++;
+			return false;
+		}
+		_dropped = 0;
+	}
+	if (!copyIn(data, len))
+	{
+		_dropped++;
+		return false;
+	}
+	return true;
+}
+
+bool LogRing::copyIn(const char* data, size_t len)
+{
+	size_t head = _head;
+	size_t tail = __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+
+	if (len > _buf.size() - (head - tail))
+		return false;
+
+	size_t pos = head & (_buf.size() - 1);
+	size_t first = std::min(len, _buf.size() - pos);
+	memcpy(&_buf[pos], data, first);
+	memcpy(&_buf[0], data + first, len - first);
+	__atomic_store_n(&_head, head + len, __ATOMIC_RELEASE);
+	return true;
+}
+
+/**
+ * Consumer side: writes every pending byte with a single writev()
+ *
+ * Example: ring of 1MB, _tail at 1048000, _head at 1048776 (wrapped)
+ * iov[0] = 576 bytes at the end of the buffer, iov[1] = 200 bytes at the start
+ * Returns the number of bytes consumed (0: nothing was pending)
+ *
+ * Bytes that cannot be written (closed stdout, full disk) are discarded:
+ * logging must never stall the server
+ */
+size_t LogRing::drain()
+{
+	size_t head = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+	size_t tail = _tail;
+	size_t done = 0;
+
+	while (tail + done < head)
+	{
+		size_t pending = head - tail - done;
+		size_t pos = (tail + done) & (_buf.size() - 1);
+		struct iovec iov[2];
+		int count = 1;
+
+		iov[0].iov_base = &_buf[pos];
+		iov[0].iov_len = std::min(pending, _buf.size() - pos);
+		if (iov[0].iov_len < pending)
+		{
+			iov[1].iov_base = &_buf[0];
+			iov[1].iov_len = pending - iov[0].iov_len;
+			count = 2;
+		}
+
+		ssize_t written = writev(_fd, iov, count);
+		if (written < 0 && errno == EINTR)
+			continue;
+		if (written <= 0)
+		{
+			done = head - tail;
+			break;
+		}
+		done += written;
+	}
+	__atomic_store_n(&_tail, tail + done, __ATOMIC_RELEASE);
+	return done;
+}
@@ -0,0 +1,177 @@
+#include "MasterProcess.hpp"
+#include "Logger.hpp"
+#include "Metrics.hpp"
+#include <sys/wait.h>
+#include <cstring>
+
+volatile sig_atomic_t MasterProcess::_signal = 0;
+
+MasterProcess::MasterProcess(const std::vector<ServerConfig>& servers, int workers, WorkerMain worker_main)
+	: _servers(servers), _worker_main(worker_main), _pids(workers, -1), _started(workers, 0),
+	  _stopping(false), _exit_status(0)
+{
+}
+
+void MasterProcess::handleSignal(int signum)
+{
+	_signal = signum;
+}
+
+void MasterProcess::handleChild(int signum)
+{
+	(void)signum;
+}
+
+/**
+ * Installs the master's handlers and blocks the signals it waits for
+ * 
+ * Example: SIGTERM arrives while the master is busy forking
+ * → stays pending (blocked) → sigsuspend(wait_mask) returns right away
+ * No signal can slip between "check _signal" and "sleep"
+ */
+void MasterProcess::installSignalHandlers(sigset_t& wait_mask)
+{
+	struct sigaction sa;
+	sigset_t block;
+	
+	memset(&sa, 0, sizeof(sa));
+	sigemptyset(&sa.sa_mask);
+	sa.sa_handler = handleSignal;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+	sa.sa_handler = handleChild;
+	sigaction(SIGCHLD, &sa, NULL);
+	
+	sigemptyset(&block);
+	sigaddset(&block, SIGINT);
+	sigaddset(&block, SIGTERM);
+	sigaddset(&block, SIGCHLD);
+	sigprocmask(SIG_BLOCK, &block, &wait_mask);
+	sigdelset(&wait_mask, SIGINT);
+	sigdelset(&wait_mask, SIGTERM);
+	sigdelset(&wait_mask, SIGCHLD);
+}
+
+/**
+ * Forks all workers, then supervises them until they have all exited
+ * 
+ * Example: ./webserv -w 2, then kill -TERM <master>
+ * spawn(0), spawn(1) → sigsuspend() ... SIGTERM → SIGTERM to both workers
+ * → both drain and exit → reap() → running() == 0 → return 0
+ */
+int MasterProcess::run()
+{
+	sigset_t wait_mask;
+	
+	installSignalHandlers(wait_mask);
+	Logger::setProcessTag("master");
+	Logger::info("Master pid=" + toString(getpid()) + ": starting " + toString(_pids.size()) + " worker(s)");
+	for (size_t slot = 0; slot < _pids.size(); ++slot)
+		spawn(slot);
+	
+	while (running() > 0)
+	{
+		sigsuspend(&wait_mask);
+		if (_signal && !_stopping)
+		{
+			Logger::info("Received signal " + toString((int)_signal) + ", stopping workers");
+			_stopping = true;
+			signalWorkers(SIGTERM);
+		}
+		reap();
+	}
+	Logger::info("All workers exited");
+	return _exit_status;
+}
+
+/**
+ * Forks the worker of one slot
+ * 
+ * Example: spawn(1) → child runs _worker_main(servers, reuse_port=true)
+ * and exits with its return value; parent records _pids[1] = child pid
+ * The child starts with SIGINT/SIGTERM/SIGCHLD still blocked: the worker
+ * unblocks them once its own handlers are installed
+ */
+void MasterProcess::spawn(size_t slot)
+{
+	pid_t pid = fork();
+	
+	if (pid < 0)
+	{
+		Logger::error("fork() failed for worker " + toString(slot) + ": " + strerror(errno));
+		return;
+	}
+	if (pid == 0)
+	{
+		signal(SIGCHLD, SIG_DFL);
+		Logger::setProcessTag("worker " + toString(slot));
+		Metrics::attach(slot);
+		exit(_worker_main(_servers, true));
+	}
+	_pids[slot] = pid;
+	_started[slot] = time(NULL);
+	Logger::info("Worker " + toString(slot) + " started (pid " + toString(pid) + ")");
+}
+
+/**
+ * Collects exited workers and restarts them unless shutting down
+ * 
+ * Example: worker 1 (pid 102) killed by SIGSEGV
+ * → "Worker 1 (pid 102) killed by signal 11, restarting" → spawn(1)
+ * A worker that exits with WORKER_EXIT_FATAL (port already in use...)
+ * would fail again: the whole server is stopped instead
+ */
+void MasterProcess::reap()
+{
+	int status;
+	pid_t pid;
+	
+	while ((pid = waitpid(-1, &status, WNOHANG)) > 0)
+	{
+		size_t slot = 0;
+		while (slot < _pids.size() && _pids[slot] != pid)
+			++slot;
+		if (slot == _pids.size())
+			continue;
+		_pids[slot] = -1;
+		if (_stopping)
+			continue;
+		
+		if (WIFEXITED(status) && WEXITSTATUS(status) == WORKER_EXIT_FATAL)
+		{
+			Logger::error("Worker " + toString(slot) + " could not start, stopping");
+			_exit_status = 1;
+			_stopping = true;
+			signalWorkers(SIGTERM);
+			continue;
+		}
+		std::string reason = WIFSIGNALED(status)
+			? "killed by signal " + toString(WTERMSIG(status))
+			: "exited with status " + toString(WEXITSTATUS(status));
+		Logger::warn("Worker " + toString(slot) + " (pid " + toString(pid) + ") " + reason + ", restarting");
+		if (time(NULL) - _started[slot] < WORKER_RESPAWN_DELAY)
+			sleep(WORKER_RESPAWN_DELAY);
+		spawn(slot);
+	}
+}
+
+void MasterProcess::signalWorkers(int signum)
+{
+	for (size_t slot = 0; slot < _pids.size(); ++slot)
+	{
+		if (_pids[slot] > 0)
+			kill(_pids[slot], signum);
+	}
+}
+
+size_t MasterProcess::running() const
+{
+	size_t count = 0;
+	
+	for (size_t slot = 0; slot < _pids.size(); ++slot)
+	{
+		if (_pids[slot] > 0)
+			count++;
+	}
+	return count;
+}
@@ -0,0 +1,224 @@
+#include "Metrics.hpp"
+#include <sys/mman.h>
+#include <cstring>
+#include <cmath>
+#include <sstream>
+
+MetricsSlot* Metrics::_slots = NULL;
+size_t Metrics::_count = 0;
+MetricsSlot* Metrics::_local = NULL;
+time_t Metrics::_started = 0;
+
+/**
+ * Single-writer increment: the owning process is the only one storing to
+ * the counter, other workers only read it while building a report
+ */
+static inline void add(uint64_t& counter, uint64_t n)
+{
+	__atomic_store_n(&counter, __atomic_load_n(&counter, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
+}
+
+static inline uint64_t load(const uint64_t& counter)
+{
+	return __atomic_load_n(&counter, __ATOMIC_RELAXED);
+}
+
+/**
+ * Example: 5 → bucket 5, 16 → 16, 1000 → e=9, (9-3)*16 + (1000>>5 & 15) = 111
+ */
+static size_t bucketIndex(uint64_t us)
+{
+	if (us < HISTOGRAM_SUB_BUCKETS)
+		return us;
+	int e = 63 - __builtin_clzl(us);
+	size_t index = (e - 3) * HISTOGRAM_SUB_BUCKETS + ((us >> (e - 4)) & (HISTOGRAM_SUB_BUCKETS - 1));
+	return std::min(index, (size_t)HISTOGRAM_BUCKETS - 1);
+}
+
+/**
+ * Example: bucket 111 → values [992, 1024) → 1023
+ */
+static uint64_t bucketUpperBound(size_t index)
+{
+	if (index < HISTOGRAM_SUB_BUCKETS)
+		return index;
+	int e = index / HISTOGRAM_SUB_BUCKETS + 3;
+	uint64_t lower = (uint64_t)(HISTOGRAM_SUB_BUCKETS + index % HISTOGRAM_SUB_BUCKETS) << (e - 4);
+	return lower + ((uint64_t)1 << (e - 4)) - 1;
+}
+
+void Histogram::record(uint64_t us)
+{
+	add(buckets[bucketIndex(us)], 1);
+	add(count, 1);
+	add(sum, us);
+	if (us > load(max))
+		__atomic_store_n(&max, us, __ATOMIC_RELAXED);
+}
+
+void Histogram::merge(const Histogram& other)
+{
+	count += load(other.count);
+	sum += load(other.sum);
+	max = std::max(max, load(other.max));
+	for (size_t i = 0; i < HISTOGRAM_BUCKETS; ++i)
+		buckets[i] += load(other.buckets[i]);
+}
+
+/**
+ * Example: count 1000, q = 0.99 → walks the buckets until 990 values
+ * are covered, returns that bucket's upper bound (capped by max)
+ */
+uint64_t Histogram::percentile(double q) const
+{
+	if (count == 0)
+		return 0;
+	uint64_t rank = (uint64_t)ceil(q * count);
+	uint64_t seen = 0;
+	for (size_t i = 0; i < HISTOGRAM_BUCKETS; ++i)
+	{
+		seen += buckets[i];
+		if (seen >= rank)
+			return std::min(bucketUpperBound(i), max);
+	}
+	return max;
+}
+
+/**
+ * Maps the slots shared by every process, before the workers are forked
+ *
+ * Example: init(4) → 4 zeroed slots visible to the master and the 4 workers
+ */
+bool Metrics::init(size_t slots)
+{
+	void* mem = mmap(NULL, slots * sizeof(MetricsSlot), PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+	if (mem == MAP_FAILED)
+		return false;
+	memset(mem, 0, slots * sizeof(MetricsSlot));
+	_slots = static_cast<MetricsSlot*>(mem);
+	_count = slots;
+	_started = time(NULL);
+	return true;
+}
+
+/**
+ * Makes the calling process the writer of one slot
+ *
+ * A respawned worker takes the slot of the one it replaces: its counters
+ * keep growing, only "active" is reset (the dead worker's connections are gone)
+ */
+void Metrics::attach(size_t slot)
+{
+	if (slot >= _count)
+		return;
+	_local = &_slots[slot];
+	__atomic_store_n(&_local->pid, getpid(), __ATOMIC_RELAXED);
+	__atomic_store_n(&_local->active, 0, __ATOMIC_RELAXED);
+}
+
+void Metrics::record(MetricPhase phase, uint64_t us)
+{
+	if (_local)
+		_local->phases[phase].record(us);
+}
+
+void Metrics::connectionOpened()
+{
+	if (!_local)
+		return;
+	add(_local->accepted, 1);
+	add(_local->active, 1);
+}
+
+void Metrics::connectionClosed()
+{
+	if (_local && load(_local->active) > 0)
+		__atomic_store_n(&_local->active, load(_local->active) - 1, __ATOMIC_RELAXED);
+}
+
+void Metrics::bytesIn(size_t bytes)
+{
+	if (_local)
+		add(_local->bytes_in, bytes);
+}
+
+void Metrics::bytesOut(size_t bytes)
+{
+	if (_local)
+		add(_local->bytes_out, bytes);
+}
+
+void Metrics::response(int status)
+{
+	if (!_local)
+		return;
+	add(_local->requests, 1);
+	if (status > 0 && status < METRICS_MAX_STATUS)
+		add(_local->status[status], 1);
+}
+
+/**
+ * JSON snapshot of the whole server (every slot summed)
+ *
+ * Example:
+ * {"uptime":120,"workers":2,"connections":{"accepted":5230,"active":12},
+ *  "requests":10211,"bytes_in":1530100,"bytes_out":98200311,
+ *  "status":{"200":10002,"404":209},
+ *  "latency_us":{"parse":{"count":10211,"mean":14,"p50":11,"p90":23,"p99":95,"p999":311,"max":1520},...}}
+ */
+std::string Metrics::report()
+{
+	static const char* names[METRIC_PHASES] = {
+		"accept", "parse", "resolve", "file_read", "cgi_first_byte", "write"
+	};
+	uint64_t accepted = 0, active = 0, requests = 0, bytes_in = 0, bytes_out = 0;
+	size_t workers = 0;
+	std::vector<uint64_t> status(METRICS_MAX_STATUS, 0);
+	std::vector<Histogram> phases(METRIC_PHASES);
+
+	memset(&phases[0], 0, METRIC_PHASES * sizeof(Histogram));
+	for (size_t i = 0; i < _count; ++i)
+	{
+		const MetricsSlot& slot = _slots[i];
+		if (__atomic_load_n(&slot.pid, __ATOMIC_RELAXED) == 0)
+			continue;
+		workers++;
+		accepted += load(slot.accepted);
+		active += load(slot.active);
+		requests += load(slot.requests);
+		bytes_in += load(slot.bytes_in);
+		bytes_out += load(slot.bytes_out);
+		for (int s = 0; s < METRICS_MAX_STATUS; ++s)
+			status[s] += load(slot.status[s]);
+		for (int p = 0; p < METRIC_PHASES; ++p)
+			phases[p].merge(slot.phases[p]);
+	}
+
+	std::ostringstream json;
+	json << "{\"uptime\":" << (time(NULL) - _started) << ",\"workers\":" << workers
+		<< ",\"connections\":{\"accepted\":" << accepted << ",\"active\":" << active << "}"
+		<< ",\"requests\":" << requests << ",\"bytes_in\":" << bytes_in
+		<< ",\"bytes_out\":" << bytes_out << ",\"status\":{";
+	bool first = true;
+	for (int s = 0; s < METRICS_MAX_STATUS; ++s)
+	{
+		if (status[s] == 0)
+			continue;
+		json << (first ? "" : ",") << "\"" << s << "\":" << status[s];
+		first = false;
+	}
+	json << "},\"latency_us\":{";
+	for (int p = 0; p < METRIC_PHASES; ++p)
+	{
+		const Histogram& h = phases[p];
+		json << (p ? "," : "") << "\"" << names[p] << "\":{\"count\":" << h.count
+			<< ",\"mean\":" << (h.count ? h.sum / h.count : 0)
+			<< ",\"p50\":" << h.percentile(0.5) << ",\"p90\":" << h.percentile(0.9)
+			<< ",\"p99\":" << h.percentile(0.99) << ",\"p999\":" << h.percentile(0.999)
+			<< ",\"max\":" << h.max << "}";
+	}
+	json << "}}\n";
+	return json.str();
+}
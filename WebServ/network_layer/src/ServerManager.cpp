@@ -3,24 +3,28 @@
 #include "Logger.hpp"
 #include <map>
 #include <utility>
+#include <stdexcept>
 
 /**
- * Initializes ServerManager with empty fd_sets
+ * Initializes ServerManager with an empty event loop
  * 
  * Example: Creates manager with:
- * - _read_set = {} (empty)
- * - _write_set = {} (empty)
+ * - _loop = epoll backend on Linux, select elsewhere (nothing monitored)
  * - _clients = {} (no clients yet)
+ * - _children = SIGCHLD fd (before the log thread starts: it sets the signal mask)
  */
-ServerManager::ServerManager() : _running(false), _total_connections(0), _active_connections(0)
+ServerManager::ServerManager() : _running(false), _stopped(false), _stop_requested(0), _draining(false), _drain_deadline(0),
+	_loop(NULL), _total_connections(0), _active_connections(0)
 {
-	_fd_manager.clear(_read_set);
-	_fd_manager.clear(_write_set);
+	if (!_children.open())
+		throw std::runtime_error(std::string("Cannot watch child processes: ") + strerror(errno));
+	_loop = EventLoop::create();
 }
 
 ServerManager::~ServerManager()
 {
 	stop();
+	delete _loop;
 }
 
 void ServerManager::addServer(const ServerConfig& config)
@@ -47,142 +51,271 @@ void ServerManager::loadConfig(const std::string& config_file)
 		_servers = parser.getServers();
 		
 		Logger::info("Loaded " + toString(_servers.size()) + " server(s) from config");
-		
-		// Group servers by (host, port) for virtual hosts
-		std::map<std::pair<in_addr_t, uint16_t>, int> socket_map;
-		
-		for (size_t i = 0; i < _servers.size(); ++i)
-		{
-			std::pair<in_addr_t, uint16_t> key(_servers[i].getHost(), _servers[i].getPort());
-			
-			// If socket already exists for this (host, port), reuse it
-			if (socket_map.find(key) != socket_map.end())
-			{
-				_servers[i].setFd(socket_map[key]);
-				Logger::info("Server " + toString(i) + ": " + _servers[i].getServerName() + 
-					" sharing socket on " + toString(_servers[i].getPort()));
-			}
-			else
-			{
-				// Create new socket for this (host, port) combination
-				_servers[i].setupServer();
-				socket_map[key] = _servers[i].getFd();
-				Logger::info("Server " + toString(i) + ": " + _servers[i].getServerName() + 
-					" listening on " + toString(_servers[i].getPort()));
-			}
-		}
 	}
 	catch (std::exception& e)
 	{
 		Logger::error("Config parsing failed: " + std::string(e.what()));
 		throw;
 	}
+	openListeners(false);
+}
+
+/**
+ * Creates one listening socket per (host, port)
+ * 
+ * Example: servers a.com:8080, b.com:8080, c.com:8081
+ * - a.com: fd=5 bound to 8080
+ * - b.com: shares fd=5 (virtual host, chosen later by Host header)
+ * - c.com: fd=6 bound to 8081
+ * 
+ * reuse_port=true (worker mode): SO_REUSEPORT, so every worker binds
+ * its own socket on the same port and the kernel spreads connections
+ */
+void ServerManager::openListeners(bool reuse_port)
+{
+	// Group servers by (host, port) for virtual hosts
+	std::map<std::pair<in_addr_t, uint16_t>, int> socket_map;
+	
+	for (size_t i = 0; i < _servers.size(); ++i)
+	{
+		std::pair<in_addr_t, uint16_t> key(_servers[i].getHost(), _servers[i].getPort());
+		
+		// If socket already exists for this (host, port), reuse it
+		if (socket_map.find(key) != socket_map.end())
+		{
+			_servers[i].setFd(socket_map[key]);
+			Logger::info("Server " + toString(i) + ": " + _servers[i].getServerName() + 
+				" sharing socket on " + toString(_servers[i].getPort()));
+		}
+		else
+		{
+			// Create new socket for this (host, port) combination
+			_servers[i].setupServer(reuse_port);
+			socket_map[key] = _servers[i].getFd();
+			Logger::info("Server " + toString(i) + ": " + _servers[i].getServerName() + 
+				" listening on " + toString(_servers[i].getPort()));
+		}
+	}
 }
 
 /**
- * Adds all server listening sockets to read_set for select()
+ * Registers all server listening sockets for reading
  * 
  * Example: After loadConfig()
- * Before: _read_set = {}
- * After:  _read_set = {5, 6}  (monitoring both server sockets)
- * _max_fd = 6
+ * Before: monitored = {}
+ * After:  monitored = {4, 5, 6}  (SIGCHLD fd, both server sockets)
+ *         _dispatch[4] = {FD_CHILDREN, -1}
+ *         _dispatch[5] = {FD_LISTENER, 0}, _dispatch[6] = {FD_LISTENER, 1}
+ * 
+ * Virtual hosts sharing a socket map to the first server that owns it
  */
 void ServerManager::initSets()
 {
+	_dispatch.set(_children.fd(), FD_CHILDREN, -1);
+	_loop->addRead(_children.fd());
+	if (_file_pool.running())
+	{
+		_dispatch.set(_file_pool.fd(), FD_FILE_IO, -1);
+		_loop->addRead(_file_pool.fd());
+	}
 	for (size_t i = 0; i < _servers.size(); ++i)
 	{
 		int fd = _servers[i].getFd();
-		_fd_manager.add(fd, _read_set);
-		_fd_manager.updateMaxFd(fd);
+		if (_dispatch.get(fd).role == FD_LISTENER)
+			continue;
+		_dispatch.set(fd, FD_LISTENER, i);
+		_loop->addRead(fd);
 	}
 }
 
+/**
+ * Starts the disk threads if a server asked for them (in the worker process:
+ * threads do not survive fork())
+ * 
+ * Example: server A "aio_threads 4", server B none → one pool of 4 threads,
+ * used by A's static requests; B keeps doing its disk work in the loop
+ */
+void ServerManager::startFilePool()
+{
+	size_t threads = 0;
+	
+	for (size_t i = 0; i < _servers.size(); ++i)
+		threads = std::max(threads, _servers[i].getAioThreads());
+	if (threads == 0)
+		return;
+	if (_file_pool.start(threads))
+		Logger::info("File I/O pool: " + toString(threads) + " thread(s)");
+	else
+		Logger::warn("Cannot start the file I/O pool, disk work stays in the event loop");
+}
+
 void ServerManager::run()
 {
-	Logger::info("Starting ServerManager...");
+	Logger::info(std::string("Starting ServerManager (") + _loop->name() + " backend)...");
+	startFilePool();
 	initSets();
 	_running = true;
 	
 	while (_running)
 	{
 		processEvents();
-		checkTimeouts();
+		if (_stop_requested && !_draining)
+			beginDrain();
+		if (_draining && (_clients.empty() || _timers.now() >= _drain_deadline))
+			_running = false;
 	}
+	stop();
 }
 
+/**
+ * Asks the event loop to shut down gracefully (safe in a signal handler)
+ * 
+ * Example: SIGTERM → requestStop() → next loop turn calls beginDrain()
+ */
+void ServerManager::requestStop()
+{
+	_stop_requested = 1;
+}
+
+/**
+ * Graceful shutdown: stop accepting, let requests in flight finish
+ * 
+ * Example: SIGTERM with clients fd=10 (idle keep-alive), fd=11 (downloading)
+ * 1. Listeners closed → new connections go to the other workers (or are refused)
+ * 2. fd=10 closed now, fd=11 closed once its response is sent
+ * 3. run() returns when no client is left, or after DRAIN_TIMEOUT seconds
+ */
+void ServerManager::beginDrain()
+{
+	_draining = true;
+	_drain_deadline = time(NULL) + DRAIN_TIMEOUT;
+	Logger::info("Shutting down: draining " + toString(_clients.size()) + " connection(s)");
+	
+	closeListeners();
+	
+	std::vector<int> idle;
+	for (std::map<int, Client*>::iterator it = _clients.begin(); it != _clients.end(); ++it)
+	{
+		if (!it->second->response_pending && it->second->read_buffer.empty())
+			idle.push_back(it->first);
+	}
+	for (size_t i = 0; i < idle.size(); ++i)
+		closeClient(idle[i]);
+}
+
+/**
+ * Closes every listening socket once (virtual hosts share one)
+ * 
+ * Example: servers a.com:8080 (fd=5), b.com:8080 (fd=5), c.com:8081 (fd=6)
+ * close(5), close(6) → all getFd() return -1
+ */
+void ServerManager::closeListeners()
+{
+	for (size_t i = 0; i < _servers.size(); ++i)
+	{
+		int fd = _servers[i].getFd();
+		if (fd < 0)
+			continue;
+		_loop->removeFd(fd);
+		_dispatch.clear(fd);
+		SocketOps::closeSocket(fd);
+		for (size_t j = i; j < _servers.size(); ++j)
+		{
+			if (_servers[j].getFd() == fd)
+				_servers[j].setFd(-1);
+		}
+	}
+}
+
+/**
+ * Closes every connection and listener (runs once)
+ * 
+ * Example: end of run(), or ~ServerManager() if run() never started
+ */
 void ServerManager::stop()
 {
 	_running = false;
+	if (_stopped)
+		return;
+	_stopped = true;
 	
-	for (std::map<int, Client>::iterator it = _clients.begin(); it != _clients.end(); ++it)
-		SocketOps::closeSocket(it->first);
-	_clients.clear();
+	// Threads done first: no request or response is in use after this
+	_file_pool.shutdown();
+	std::vector<int> fds;
+	for (std::map<int, Client*>::iterator it = _clients.begin(); it != _clients.end(); ++it)
+	{
+		it->second->file_job = false;
+		fds.push_back(it->first);
+	}
+	for (size_t i = 0; i < fds.size(); ++i)
+		closeClient(fds[i]);
 	
-	for (size_t i = 0; i < _servers.size(); ++i)
-		SocketOps::closeSocket(_servers[i].getFd());
+	closeListeners();
+	_cgi_pool.shutdown();
+	_children.waitAll();
 	
 	Logger::info("ServerManager stopped");
 }
 
 /**
- * Main event loop: calls select() and dispatches events
+ * Main event loop: waits for readiness and dispatches events
  * 
  * Example flow for "GET /banana.jpg":
- * 1. select() waits for activity on {5, 6, 10}
+ * 1. wait() blocks until activity on {5, 6, 10}
  * 2. Browser sends request → fd=10 becomes readable
- * 3. read_cpy = {10}, write_cpy = {}
- * 4. Loop finds fd=10 in read_cpy
- * 5. fd=10 is in _clients → calls handleClientRead(10)
- * 6. After parsing, fd=10 added to write_set
- * 7. Next select(): write_cpy = {10}
- * 8. Loop finds fd=10 in write_cpy → calls handleClientWrite(10)
+ * 3. events = [{fd:10, IO_READ}]
+ * 4. _dispatch[10] = {FD_CLIENT, 10} → calls handleClientRead(10)
+ * 5. After parsing, fd=10 registered for writing
+ * 6. Next wait(): events = [{fd:10, IO_WRITE}]
+ * 7. calls handleClientWrite(10)
+ * 
+ * Only ready fds are visited and each one resolves to its handler
+ * through the dispatch table in O(1); expired timers are handled first
+ *
+ * A listener that used its ACCEPT_BATCH is resumed after the events:
+ * wait() does not block then, so the other clients and the rest of the
+ * accept queue take turns
  */
 void ServerManager::processEvents()
 {
-	fd_set read_cpy = _read_set;
-	fd_set write_cpy = _write_set;
-	
-	struct timeval timeout;
-	timeout.tv_sec = 1;
-	timeout.tv_usec = 0;
-	
-	int ready = select(_fd_manager.getMaxFd() + 1, &read_cpy, &write_cpy, NULL, &timeout);
+	int ready = _loop->wait(_events, _accept_pending.empty() ? 1000 : 0);
 	
 	if (ready < 0)
 	{
 		_running = false;
 		return;
 	}
+	// Also moves the clock new deadlines are computed from to "now"
+	checkTimeouts();
 	
-	if (ready == 0)
-		return;
-	
-	for (int fd = 0; fd <= _fd_manager.getMaxFd(); ++fd)
+	for (size_t e = 0; e < _events.size(); ++e)
 	{
-		if (_fd_manager.isSet(fd, read_cpy))
+		int fd = _events[e].fd;
+		
+		if (_events[e].events & IO_READ)
 		{
-			for (size_t i = 0; i < _servers.size(); ++i)
-			{
-				if (_servers[i].getFd() == fd)
-				{
-					handleServerSocket(_servers[i]);
-					break;
-				}
-			}
-			
-			if (_clients.find(fd) != _clients.end())
+			const FdSlot& slot = _dispatch.get(fd);
+			if (slot.role == FD_LISTENER)
+				handleServerSocket(slot.owner);
+			else if (slot.role == FD_CLIENT)
 				handleClientRead(fd);
-			else
+			else if (slot.role == FD_CGI_STDOUT)
 				handleCgiRead(fd);
+			else if (slot.role == FD_CHILDREN)
+				reapChildren();
+			else if (slot.role == FD_FILE_IO)
+				completeFileJobs();
 		}
 		
-		if (_fd_manager.isSet(fd, write_cpy))
+		// Slot is looked up again: the read handler may have closed fd
+		if (_events[e].events & IO_WRITE)
 		{
-			if (_clients.find(fd) != _clients.end())
+			const FdSlot& slot = _dispatch.get(fd);
+			if (slot.role == FD_CLIENT)
 				handleClientWrite(fd);
-			else
+			else if (slot.role == FD_CGI_STDIN)
 				handleCgiWrite(fd);
 		}
 	}
+	resumeAccepts();
 }
-
@@ -1,230 +1,659 @@
 #include "ServerManager.hpp"
 #include "SocketOps.hpp"
 #include "Logger.hpp"
+#include "Metrics.hpp"
 #include <sys/wait.h>
 #include <cstring>
 
-void ServerManager::handleServerSocket(ServerConfig& server)
+/**
+ * Listener readable: accepts up to ACCEPT_BATCH connections
+ *
+ * Example: edge-triggered, 200 connections queued after a deploy
+ * turn 1: 64 accepted, listener 0 queued in _accept_pending
+ * turns 2-4: resumeAccepts() takes 64, 64, then the last 8 (EAGAIN)
+ * A level-triggered backend reports the listener again by itself
+ */
+void ServerManager::handleServerSocket(size_t server_index)
 {
-	acceptNewConnection(server);
+	if (acceptNewConnection(_servers[server_index]) && _loop->edgeTriggered() &&
+		std::find(_accept_pending.begin(), _accept_pending.end(), server_index) == _accept_pending.end())
+		_accept_pending.push_back(server_index);
+}
+
+/**
+ * Continues the accept queues left at the end of the previous turn
+ * (no new edge will come for them); skipped once listeners are closed
+ */
+void ServerManager::resumeAccepts()
+{
+	if (_accept_pending.empty())
+		return;
+
+	std::vector<size_t> pending;
+	pending.swap(_accept_pending);
+	for (size_t i = 0; i < pending.size(); ++i)
+	{
+		if (_servers[pending[i]].getFd() >= 0)
+			handleServerSocket(pending[i]);
+	}
 }
 
 /**
- * Accepts new client connection and adds to monitoring
+ * Accepts new client connections and adds them to monitoring
  * 
  * Example: Browser connects to request /banana.jpg
  * Input: server_fd=5 (listening socket)
- * 1. accept() creates client_fd=10
- * 2. Set fd=10 to non-blocking
- * 3. Create Client object with empty buffers
- * 4. Add fd=10 to _read_set (monitor for incoming data)
- * 5. _clients[10] = {socket_fd:10, read_buffer:"", write_buffer:""}
+ * 1. accept4() creates client_fd=10, already non-blocking
+ * 2. Take a Client from the pool (recycled, buffers empty)
+ * 3. Register fd=10 for reading (monitor for incoming data)
+ *    and arm its client_header_timeout
+ * 4. _clients[10] = &{socket_fd:10, read_buffer:"", write_buffer:""}
  * 
- * Now select() will notify us when browser sends HTTP request
+ * Drains the accept queue, at most ACCEPT_BATCH connections per call:
+ * returns true if the budget ran out before EAGAIN (more may be waiting)
  */
-void ServerManager::acceptNewConnection(ServerConfig& server)
+bool ServerManager::acceptNewConnection(ServerConfig& server)
 {
-	struct sockaddr_in client_addr;
-	int client_fd = SocketOps::acceptConnection(server.getFd(), client_addr);
+	for (int accepted = 0; accepted < ACCEPT_BATCH; ++accepted)
+	{
+		struct sockaddr_in client_addr;
+		uint64_t start = monotonicMicros();
+		int client_fd = SocketOps::acceptConnection(server.getFd(), client_addr);
 
-	if (client_fd < 0)
-		return;
+		if (client_fd < 0)
+			return false;
+
+		if (!_loop->addRead(client_fd))
+		{
+			Logger::warn("Cannot monitor fd=" + toString(client_fd) + " with " + _loop->name() + ", dropping connection");
+			SocketOps::closeSocket(client_fd);
+			continue;
+		}
 
-	SocketOps::setNonBlocking(client_fd);
+		Client& client = *_client_pool.acquire(client_fd, client_addr);
+		client.listen_fd_owner = server.getFd();
+		client.server_config = &server;
+		client.request.setBodyBuffer(server.getClientBodyBufferSize(), server.getClientBodyTempPath());
+		client.request.setMaxBodySize(maxBodySize(server.getFd()));
+		_clients[client_fd] = &client;
+		_dispatch.set(client_fd, FD_CLIENT, client_fd);
+		setPhase(client, TIMEOUT_HEADER);
 
-	Client client(client_fd, client_addr);
-	client.listen_fd_owner = server.getFd();
-	client.server_config = &server;
-	_clients[client_fd] = client;
-	_fd_manager.add(client_fd, _read_set);
-	_fd_manager.updateMaxFd(client_fd);
+		_total_connections++;
+		_active_connections++;
+		Metrics::connectionOpened();
+		Metrics::record(PHASE_ACCEPT, monotonicMicros() - start);
 
-	_total_connections++;
-	_active_connections++;
+		LOG_INFO("New connection: fd=" + toString(client_fd) + " from " + client.getAddressString() +
+			" (Total: " + toString(_total_connections) + ", Active: " + toString(_active_connections) + ")");
+	}
+	return true;
+}
+
+/**
+ * Largest client_max_body_size among the servers sharing a listening socket
+ *
+ * The body arrives before Host picks the virtual host, so the parser can only
+ * enforce this bound; Response applies the chosen server/location limit after
+ * Example: :8080 shared by a (1 MB) and b (50 MB) → 50 MB while receiving
+ */
+size_t ServerManager::maxBodySize(int listen_fd) const
+{
+	size_t limit = 0;
 
-	Logger::info("New connection: fd=" + toString(client_fd) + " from " + client.getAddressString() +
-		" (Total: " + toString(_total_connections) + ", Active: " + toString(_active_connections) + ")");
+	for (size_t i = 0; i < _servers.size(); ++i)
+	{
+		if (_servers[i].getFd() == listen_fd)
+			limit = std::max(limit, _servers[i].getClientMaxBodySize());
+	}
+	return limit;
 }
 
 /**
  * Reads HTTP request from client socket
  * 
  * Example: Browser sends "GET /banana.jpg HTTP/1.1\r\n..."
- * Input: fd=10 (readable according to select)
+ * Input: fd=10 (readable according to wait())
  * 1. recv() reads data into client.read_buffer
  * 2. read_buffer = "GET /banana.jpg HTTP/1.1\r\nHost: localhost\r\n\r\n"
  * 3. Feed to HTTP parser
  * 4. Parser extracts: method=GET, path=/banana.jpg
  * 5. Build response (read banana.jpg file)
- * 6. Add fd=10 to write_set (ready to send response)
+ * 6. Register fd=10 for writing (ready to send response)
  * 
- * Next select() will notify when fd=10 is writable
+ * Next wait() will notify when fd=10 is writable
+ * With the edge-triggered backend the socket is drained until EAGAIN
+ * While a response is pending, at most PIPELINE_BUFFER_MAX unparsed bytes are
+ * buffered: read interest is then dropped until the response is finished
  */
 void ServerManager::handleClientRead(int fd)
 {
-	Client& client = _clients[fd];
+	Client& client = *_clients[fd];
 	std::string& buffer = client.read_buffer;
+	ssize_t total = 0;
 
-	ssize_t bytes = readFromSocket(fd, buffer);
-
-	if (bytes < 0)
+	while (true)
 	{
+		ssize_t bytes = readFromSocket(fd, buffer);
+
+		if (bytes > 0)
+		{
+			total += bytes;
+			// Pipelined requests behind a response still being sent: buffer a
+			// bounded amount, then stop reading until finishResponse() re-arms
+			if (client.response_pending && buffer.size() - client.parse_offset >= PIPELINE_BUFFER_MAX)
+			{
+				_loop->removeRead(fd);
+				client.read_paused = true;
+				break;
+			}
+			if (!_loop->edgeTriggered())
+				break;
+			// Body arriving faster than we drain: parse it as it comes, so it
+			// goes to the request's BodySink instead of piling up in read_buffer
+			if (buffer.size() - client.parse_offset >= CLIENT_READ_BATCH && !client.response_pending)
+			{
+				clientInput(fd, total);
+				total = 0;
+			}
+			continue;
+		}
+
+		if (bytes == 0)
+		{
+			LOG_INFO("Connection closed by client: fd=" + toString(fd));
+			closeClient(fd);
+			return;
+		}
+
+		if (errno == EINTR)
+			continue;
+		if (errno == EAGAIN || errno == EWOULDBLOCK)
+			break;
+
 		Logger::error("Read error on fd=" + toString(fd));
 		closeClient(fd);
 		return;
 	}
 
-	if (bytes == 0)
-	{
-		Logger::info("Connection closed by client: fd=" + toString(fd));
-		closeClient(fd);
+	if (total == 0)
 		return;
-	}
+	clientInput(fd, total);
+}
 
-	client.updateActivity();
+/**
+ * New bytes in read_buffer: timeout phase, then the parser
+ */
+void ServerManager::clientInput(int fd, ssize_t bytes)
+{
+	Client& client = *_clients[fd];
+
+	Metrics::bytesIn(bytes);
+	if (client.phase == TIMEOUT_KEEPALIVE)
+		setPhase(client, TIMEOUT_HEADER);
+	else if (client.phase == TIMEOUT_BODY)
+		refreshTimeout(client);
+	processRequest(fd);
+}
+
+/**
+ * Feeds unparsed bytes to the HTTP parser and builds the response
+ * 
+ * Example: keep-alive client pipelines two requests in one packet
+ * read_buffer = "GET /a.html HTTP/1.1\r\n\r\nGET /b.css HTTP/1.1\r\n\r\n"
+ * 1. feed() stops after the first request → parse_offset = 26
+ * 2. Response for /a.html is built, response_pending = true
+ * 3. "GET /b.css..." stays in read_buffer until finishResponse()
+ * 
+ * While a response is pending, new bytes are only buffered
+ * 
+ * Timeout phase: header → body (head parsed, body incoming)
+ * → CGI (script running) or send (response ready)
+ */
+void ServerManager::processRequest(int fd)
+{
+	Client& client = *_clients[fd];
+	std::string& buffer = client.read_buffer;
+
+	if (client.response_pending)
+		return;
 
 	// Feed ONLY new data to HTTP parser (not the entire buffer)
 	size_t new_data_size = buffer.size() - client.parse_offset;
 	if (new_data_size > 0)
 	{
-		client.request.feed((char*)buffer.c_str() + client.parse_offset, new_data_size);
-		client.parse_offset = buffer.size();
+		bool head_done = client.request.headersCompleted();
+		uint64_t start = monotonicMicros();
+		client.parse_offset += client.request.feed((char*)buffer.c_str() + client.parse_offset, new_data_size);
+		client.parse_us += monotonicMicros() - start;
+		// feed() stops right after the head: the body is routed before any of it is parsed
+		if (!head_done && client.request.headersCompleted() && !client.request.errorCode())
+		{
+			routeBody(client);
+			start = monotonicMicros();
+			if (!client.requestComplete())
+				client.parse_offset += client.request.feed((char*)buffer.c_str() + client.parse_offset, buffer.size() - client.parse_offset);
+			client.parse_us += monotonicMicros() - start;
+		}
+	}
+
+	// Body bytes already handed to the request's BodySink or upload: not kept twice
+	if (!client.requestComplete() && client.request.headersCompleted())
+	{
+		buffer.erase(0, client.parse_offset);
+		client.parse_offset = 0;
 	}
 
 	// If request is complete, build response
 	if (client.requestComplete())
 	{
-		// Select server based on listening socket and Host header
-		ServerConfig* server_config = client.server_config;
+		client.response_pending = true;
+		Metrics::record(PHASE_PARSE, client.parse_us);
+		ServerConfig* server_config = selectServer(client);
 		if (server_config)
 		{
-			// If multiple servers share same (host,port), try match by server_name from Host header
-			std::string host_name = client.request.getServerName();
-			if (!host_name.empty())
-			{
-				in_addr_t host = server_config->getHost();
-				uint16_t port = server_config->getPort();
-				for (size_t i = 0; i < _servers.size(); ++i)
-				{
-					if (_servers[i].getHost() == host && _servers[i].getPort() == port)
-					{
-						if (_servers[i].getServerName() == host_name)
-						{
-							server_config = &_servers[i];
-							break;
-						}
-					}
-				}
-			}
 			client.response.setRequest(client.request);
 			client.response.setServer(*server_config);
-			client.response.buildResponse();
-
-			// If CGI is active, add pipes to select sets
-			if (client.response.getCgiState() == 1)
+			if (server_config->getStatusPage() && client.request.getMethod() == GET
+				&& client.request.getPath() == STATUS_PAGE_PATH)
+				client.response.setGeneratedResponse(Metrics::report(), STATUS_PAGE_PATH ".json");
+			else if (_file_pool.running() && server_config->getAioThreads() && client.response.offloadable())
 			{
-				// Add pipe_in[1] to write_set (to send POST body to CGI)
-				// Add pipe_out[0] to read_set (to read CGI response)
-				_fd_manager.add(client.response.cgi_obj.pipe_in[1], _write_set);
-				_fd_manager.add(client.response.cgi_obj.pipe_out[0], _read_set);
-				Logger::info("CGI detected, pipes added to select sets for fd=" + toString(fd) +
-					" (pipe_out[0]=" + toString(client.response.cgi_obj.pipe_out[0]) +
-					", pipe_in[1]=" + toString(client.response.cgi_obj.pipe_in[1]) + ")");
+				// Disk work in a FilePool thread, resumed by completeFileJobs()
+				client.file_job = true;
+				setPhase(client, TIMEOUT_SEND);
+				_file_pool.post(fd, &client.response);
+				return;
 			}
 			else
-			{
-				client.write_buffer = client.response.getRes();
-				_fd_manager.add(fd, _write_set);
-				Logger::info("Request parsed, response ready for fd=" + toString(fd));
-			}
+				client.response.buildResponse();
+			startResponse(fd);
 		}
 	}
+	else if (client.phase == TIMEOUT_HEADER && client.request.headersCompleted())
+		setPhase(client, TIMEOUT_BODY);
+}
+
+/**
+ * Server for the request: the listener's default, or the server of the same
+ * (host, port) whose server_name matches the Host header
+ * 
+ * Example: two servers on :8080, "Host: b.local:8080" → the one with server_name b.local
+ */
+ServerConfig* ServerManager::selectServer(Client& client)
+{
+	ServerConfig* server_config = client.server_config;
+	if (!server_config)
+		return NULL;
+	std::string host_name = client.request.getServerName();
+	if (host_name.empty())
+		return server_config;
+	in_addr_t host = server_config->getHost();
+	uint16_t port = server_config->getPort();
+	for (size_t i = 0; i < _servers.size(); ++i)
+	{
+		if (_servers[i].getHost() == host && _servers[i].getPort() == port
+			&& _servers[i].getServerName() == host_name)
+			return &_servers[i];
+	}
+	return server_config;
+}
+
+/**
+ * Head parsed, body not fed yet: a multipart upload to a location without
+ * scripts is cut into its files as it arrives (Response::streamUpload());
+ * any other body, CGI input included, goes to the request's BodySink
+ * 
+ * Example: POST /upload/ multipart/form-data, 300 MB → each file written once,
+ * next to its destination, instead of a 300 MB client_body_temp_path file
+ * re-read and parsed once the body is complete
+ */
+void ServerManager::routeBody(Client& client)
+{
+	if (client.request.getMethod() != POST || !client.request.getMultiformFlag())
+		return;
+	ServerConfig* server_config = selectServer(client);
+	if (!server_config)
+		return;
+	client.response.setRequest(client.request);
+	client.response.setServer(*server_config);
+	client.response.streamUpload();
+}
+
+/**
+ * Response built: watch the CGI's pipes, or the socket for writing
+ * 
+ * Example: GET /cgi-bin/time.py → pipes of the forked script (pooled:
+ * once an interpreter is free); GET /index.html → fd=10 watched for writing
+ */
+void ServerManager::startResponse(int fd)
+{
+	Client& client = *_clients[fd];
+
+	if (client.response.getCgiState() == 1)
+	{
+		setPhase(client, TIMEOUT_CGI);
+		client.cgi_start = monotonicMicros();
+		if (client.response.cgi_obj.pooled())
+			queuePooledCgi(fd);
+		else
+		{
+			_children.track(client.response.cgi_obj.getCgiPid(), fd);
+			client.cgi_stdin.start(client.request.getBody());
+			watchCgiPipes(fd);
+		}
+	}
+	else
+	{
+		_loop->addWrite(fd);
+		setPhase(client, TIMEOUT_SEND);
+		client.write_start = monotonicMicros();
+		LOG_INFO("Request parsed, response ready for fd=" + toString(fd));
+	}
+}
+
+/**
+ * FilePool fd readable: resumes the clients whose disk work is done
+ * 
+ * Example: GET /a.html (fd=10) and DELETE /old.txt (fd=14) finished
+ * collect() = {10, 14} → headers built here (Date, metrics stay on this
+ * thread) → both watched for writing
+ * A client closed meanwhile (timeout, peer gone) is only released now
+ */
+void ServerManager::completeFileJobs()
+{
+	std::vector<int> done;
+
+	_file_pool.collect(done);
+	for (size_t i = 0; i < done.size(); ++i)
+	{
+		int fd = done[i];
+		std::map<int, Client*>::iterator it = _clients.find(fd);
+		if (it == _clients.end())
+			continue;
+		Client& client = *it->second;
+		client.file_job = false;
+		if (client.close_pending)
+		{
+			closeClient(fd);
+			continue;
+		}
+		client.response.buildHead();
+		startResponse(fd);
+	}
 }
 
 /**
  * Sends HTTP response to client socket
  * 
  * Example: Sending banana.jpg to browser
- * Input: fd=10 (writable according to select)
- * 1. write_buffer = "HTTP/1.1 200 OK\r\n...Content-Length: 50000\r\n\r\n[50KB of JPEG data]"
- * 2. send() writes data, may be partial: bytes=8192
- * 3. write_offset = 8192 (track progress)
- * 4. Still more data? Keep fd=10 in write_set
- * 5. Next select() → write again from offset 8192
- * 6. When write_offset >= 50000 → complete!
- * 7. Remove from write_set, close connection
+ * Input: fd=10 (writable according to wait())
+ * 1. sendHead() writes "HTTP/1.1 200 OK\r\n...Content-Length: 50000\r\n\r\n"
+ *    straight from the response's header buffer, may be partial: bytes=100
+ * 2. head_offset = 100 (track progress)
+ * 3. Socket full (EAGAIN)? Keep fd=10 registered for writing
+ * 4. Next wait() → write again from offset 100
+ * 5. Headers done → sendFileBody() streams the 50KB from the file fd
+ * 6. Streamed bodies (autoindex, CGI) go through write_buffer instead
+ * 7. Stop monitoring writes, keep connection for the next request
+ *    (or close it: "Connection: close", HTTP/1.0, CGI)
  * 
  * Browser now displays banana.jpg
  */
 void ServerManager::handleClientWrite(int fd)
 {
-	Client& client = _clients[fd];
-
-	ssize_t bytes = writeToSocket(fd, client.write_buffer, client.write_offset);
+	Client& client = *_clients[fd];
 
-	if (bytes < 0)
-	{
-		Logger::error("Write error on fd=" + toString(fd));
-		closeClient(fd);
+	if (!sendHead(fd))
 		return;
+	while (true)
+	{
+		while (client.write_offset < client.write_buffer.size())
+		{
+			ssize_t bytes = writeToSocket(fd, client.write_buffer, client.write_offset);
+
+			if (bytes < 0)
+			{
+				if (errno == EINTR)
+					continue;
+				if (errno == EAGAIN || errno == EWOULDBLOCK)
+					return;
+				Logger::error("Write error on fd=" + toString(fd));
+				closeClient(fd);
+				return;
+			}
+
+			client.bytes_sent += bytes;
+			refreshTimeout(client);
+			if (!_loop->edgeTriggered())
+				break;
+		}
+
+		if (client.write_offset < client.write_buffer.size())
+			return;
+		if (!client.response.hasBodySource())
+			break;
+		if (!pullBody(fd))
+			return;
+		if (client.write_buffer.empty())
+			break;
+		if (!_loop->edgeTriggered())
+			return;
 	}
 
-	client.updateActivity();
+	if (!sendFileBody(fd))
+		return;
 
-	if (client.write_offset >= client.write_buffer.size())
+	_loop->removeWrite(fd);
+	finishResponse(fd);
+}
+
+/**
+ * Sends the response headers and in-memory body with one writev()
+ * 
+ * Example: GET /index.html (4096 bytes, cached)
+ * iov = {"HTTP/1.1 200 OK\r\n...\r\n\r\n" (180), body (4096)}
+ * → sendmsg() → 4276 bytes, head_offset=4276: no copy, no concatenation
+ * 
+ * Partial write (socket full): head_offset=3000 → the next call resumes
+ * inside the body, the header segment is skipped
+ * 
+ * A sendfile() body follows → MSG_MORE, headers and the first file bytes
+ * share a packet despite TCP_NODELAY
+ * 
+ * Returns true once everything is sent, false if more is pending
+ * (or the client was closed)
+ */
+bool ServerManager::sendHead(int fd)
+{
+	Client& client = *_clients[fd];
+	bool more = client.response.getFileFd() >= 0;
+
+	while (client.head_offset < client.response.getLen())
 	{
-		_fd_manager.remove(fd, _write_set);
+		struct iovec iov[2];
+		int count = client.response.getVector(iov, client.head_offset);
+		ssize_t bytes = SocketOps::sendVector(fd, iov, count, more);
 
-		// If CGI is still active (state == 1), keep connection open
-		// select() will notify us when more data is available on pipe
-		if (client.response.getCgiState() == 1)
-			return;
+		if (bytes < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return false;
+			Logger::error("Write error on fd=" + toString(fd));
+			closeClient(fd);
+			return false;
+		}
+		client.head_offset += bytes;
+		client.bytes_sent += bytes;
+		refreshTimeout(client);
+		if (!_loop->edgeTriggered() && client.head_offset < client.response.getLen())
+			return false;
+	}
+	return true;
+}
+
+/**
+ * Refills write_buffer with the next slice of a streamed body
+ * 
+ * Example: autoindex of a 10000-entry directory, output_buffer_size 65536
+ * 1. write_buffer drained → pullBody() → next ~64KB of HTML (chunked)
+ * 2. Repeat until the listing ends with "0\r\n\r\n"
+ * Memory per connection stays around one slice, whatever the body size
+ * 
+ * CGI output: slices come from the script's buffered stdout
+ * - Nothing buffered yet → stop write events until readCgiResponse() has more
+ * - Buffer drained below half the high-water mark → resume reading the pipe
+ * 
+ * Returns false if nothing can be sent now (or the client was closed)
+ */
+bool ServerManager::pullBody(int fd)
+{
+	Client& client = *_clients[fd];
+	size_t high_water = client.response.getBufferSize();
+
+	client.write_buffer.clear();
+	client.write_offset = 0;
+	BodySource::Status status = client.response.pullBody(client.write_buffer, high_water);
 
-			// CGI is done (state == 2), safe to close or keep-alive
-			// For CGI responses, it's safer to close the connection to ensure browsers receive all data
-			// Some browsers may buffer responses and wait for connection close
+	StreamSource* cgi_out = client.response.cgiStream();
+	if (client.cgi_paused && cgi_out && cgi_out->buffered() <= high_water / 2)
+	{
+		client.cgi_paused = false;
+		_loop->addRead(client.response.cgi_obj.pipe_out[0]);
+	}
+
+	if (status == BodySource::BODY_ERROR)
+	{
+		Logger::error("Response body failed on fd=" + toString(fd));
 		closeClient(fd);
+		return false;
+	}
+	if (status == BodySource::BODY_AGAIN && client.write_buffer.empty())
+	{
+		_loop->removeWrite(fd);
+		return false;
 	}
+	return true;
 }
 
 /**
- * Finds which client owns a CGI pipe
+ * Streams a static file body after the headers, kernel to socket
  * 
- * Example: CGI script for client fd=10 has pipes
- * - pipe_out[0] = 15 (read CGI output)
- * - pipe_in[1] = 16 (write POST data to CGI)
+ * Example: GET /banana.jpg (50000 bytes), headers already written
+ * 1. sendfile() 50000 bytes from the cached fd → file_offset=50000
+ * 2. Socket buffer full → EAGAIN, wait for the next write event
  * 
- * When select() says fd=15 is readable:
- * findClientByPipe(15, true) → returns 10
- * We know client 10's CGI has output ready
+ * Returns true when the body is complete (or there is none),
+ * false if more is pending or the client was closed
  */
-int ServerManager::findClientByPipe(int pipe_fd, bool is_read_pipe)
+bool ServerManager::sendFileBody(int fd)
 {
-	for (std::map<int, Client>::iterator it = _clients.begin(); it != _clients.end(); ++it)
+	Client& client = *_clients[fd];
+	int file_fd = client.response.getFileFd();
+	off_t size = client.response.getFileSize();
+
+	if (file_fd < 0)
+		return true;
+	while (client.file_offset < size)
 	{
-		if (it->second.response.getCgiState() == 1)
+		size_t chunk = static_cast<size_t>(size - client.file_offset);
+		if (chunk > SENDFILE_CHUNK)
+			chunk = SENDFILE_CHUNK;
+		ssize_t bytes = SocketOps::sendFile(fd, file_fd, client.file_offset, chunk);
+
+		if (bytes < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return false;
+			Logger::error("sendfile error on fd=" + toString(fd));
+			closeClient(fd);
+			return false;
+		}
+		if (bytes == 0)
 		{
-			if (is_read_pipe && it->second.response.cgi_obj.pipe_out[0] == pipe_fd)
-				return it->first;
-			if (!is_read_pipe && it->second.response.cgi_obj.pipe_in[1] == pipe_fd)
-				return it->first;
+			// File shrank since stat(): Content-Length can no longer be honoured
+			Logger::error("File truncated while sending on fd=" + toString(fd));
+			closeClient(fd);
+			return false;
 		}
+		client.bytes_sent += bytes;
+		refreshTimeout(client);
+		if (!_loop->edgeTriggered() && client.file_offset < size)
+			return false;
+	}
+	return true;
+}
+
+/**
+ * Response fully sent: recycle the connection or close it
+ * 
+ * Example: keep-alive client fetched /a.html, /b.css is pipelined
+ * 1. response.keepAlive() → true (HTTP/1.1, no "Connection: close")
+ * 2. client.clear() → read_buffer = "GET /b.css...", buffers reset
+ * 3. processRequest() parses /b.css immediately
+ *    (nothing pipelined: keepalive_timeout starts instead)
+ * 
+ * Closed instead when the client asked for it (Connection: close, HTTP/1.0
+ * without keep-alive), after a request error, while draining, or when the
+ * body had no length: a streamed body (CGI, autoindex) is relayed chunked
+ * to HTTP/1.1 clients and keeps the connection, but an HTTP/1.0 client
+ * only sees its end when the connection closes
+ */
+void ServerManager::finishResponse(int fd)
+{
+	Client& client = *_clients[fd];
+
+	if (Logger::accessEnabled())
+		logAccess(client);
+	recordResponse(client);
+	if (!client.response.keepAlive() || _draining)
+	{
+		closeClient(fd);
+		return;
+	}
+
+	client.clear();
+	if (client.read_paused)
+	{
+		// Re-arming also reports input already waiting (edge-triggered included)
+		_loop->addRead(fd);
+		client.read_paused = false;
+	}
+	if (client.read_buffer.empty())
+		setPhase(client, TIMEOUT_KEEPALIVE);
+	else
+	{
+		setPhase(client, TIMEOUT_HEADER);
+		processRequest(fd);
 	}
-	return -1;
 }
 
+/**
+ * CGI stdout pipe is readable: forward to its client
+ * 
+ * Example: CGI script for client fd=10 has pipes
+ * - pipe_out[0] = 15 (read CGI output)
+ * - pipe_in[1] = 16 (write POST data to CGI)
+ * 
+ * When wait() says fd=15 is readable:
+ * _dispatch[15] = {FD_CGI_STDOUT, 10} → readCgiResponse(10)
+ */
 void ServerManager::handleCgiRead(int pipe_fd)
 {
-	int client_fd = findClientByPipe(pipe_fd, true);
-	if (client_fd >= 0)
-		readCgiResponse(client_fd);
+	const FdSlot& slot = _dispatch.get(pipe_fd);
+	if (slot.role == FD_CGI_STDOUT)
+		readCgiResponse(slot.owner);
 }
 
 void ServerManager::handleCgiWrite(int pipe_fd)
 {
-	int client_fd = findClientByPipe(pipe_fd, false);
-	if (client_fd >= 0)
-		sendCgiBody(client_fd);
+	const FdSlot& slot = _dispatch.get(pipe_fd);
+	if (slot.role == FD_CGI_STDIN)
+		sendCgiBody(slot.owner);
 }
 
 /**
@@ -232,199 +661,390 @@ void ServerManager::handleCgiWrite(int pipe_fd)
  * 
  * Example: POST request uploading banana image
  * Client fd=10, pipe_in[1]=16
- * 1. req_body = "[50KB of image data]"
- * 2. write(16, data, 50000) → bytes_sent=8192 (partial)
- * 3. req_body = req_body.substr(8192) (remaining 41808 bytes)
- * 4. Keep pipe_in[1]=16 in write_set
- * 5. Next select() → write more data
- * 6. When all sent → close(16), remove from write_set
+ * 1. Body = 50KB of image data (in memory, or in a temp file if large)
+ * 2. cgi_stdin.send(16) → write() until the pipe is full: 49152 bytes sent
+ * 3. Keep pipe_in[1]=16 registered for writing
+ * 4. Next wait() → send() resumes at offset 49152 (nothing is copied)
+ * 5. When all sent → close(16), stop monitoring it
  * 
  * CGI script now has full POST body via stdin
  */
 void ServerManager::sendCgiBody(int client_fd)
 {
-	Client& client = _clients[client_fd];
+	Client& client = *_clients[client_fd];
 	CgiHandler& cgi = client.response.cgi_obj;
-	std::string& req_body = client.request.getBody();
-
-	if (req_body.length() == 0)
-	{
-		// No body to send, close pipe and remove from write set
-		_fd_manager.remove(cgi.pipe_in[1], _write_set);
-		close(cgi.pipe_in[1]);
-		return;
-	}
-
-	ssize_t bytes_sent = write(cgi.pipe_in[1], req_body.c_str(), req_body.length());
 
-	if (bytes_sent < 0)
-	{
-		client.updateActivity();
+	// STDIN_CLOSED: CGI closed its stdin (EPIPE), the rest of the body is dropped
+	if (client.cgi_stdin.send(cgi.pipe_in[1]) == CgiStdin::STDIN_BLOCKED)
 		return;
-	}
-	else if ((size_t)bytes_sent == req_body.length())
-	{
-		// All body sent, close pipe and remove from write set
-		_fd_manager.remove(cgi.pipe_in[1], _write_set);
-		close(cgi.pipe_in[1]);
-		req_body.clear();
-	}
+	// Body sent, close pipe and stop monitoring it
+	// (a pool interpreter's stdin stays open for its next request)
+	if (client.cgi_worker)
+		detachCgiPipe(cgi.pipe_in[1]);
 	else
-	{
-		// Partial send, update body
-		req_body = req_body.substr(bytes_sent);
-		client.updateActivity();
-	}
+		closeCgiPipe(cgi.pipe_in[1]);
 }
 
 /**
- * Reads CGI script output via pipe and sends to client
- * 
- * Example: CGI generates dynamic HTML for /banana.php
- * Client fd=10, pipe_out[0]=15
- * 1. CGI writes "HTTP/1.1 200 OK\r\n...HTML content..."
- * 2. select() says fd=15 readable
- * 3. read(15, buffer, 80000) → bytes_read=4096
- * 4. Append to response_content
- * 5. Check if headers complete (\r\n\r\n found)
- * 6. Start sending to client (add fd=10 to write_set)
- * 7. Continue reading until EOF
- * 8. When EOF → close(15), wait for CGI process
- * 9. Final response sent via handleClientWrite()
+ * Reads CGI script output via pipe and streams it to the client
+ * 
+ * Example: CGI generates dynamic HTML for /cgi-bin/time.py
+ * Client fd=10, pipe_out[0]=15, output_buffer_size 65536
+ * 1. wait() says fd=15 readable
+ * 2. read(15, ...) → appended to the response's StreamSource
+ * 3. Headers complete (blank line found)? Register fd=10 for writing,
+ *    handleClientWrite() pulls the output slice by slice: the script's
+ *    headers become the response head once, the body goes out chunked
+ * 4. 64KB buffered and the client is slow? Stop reading fd=15 (backpressure),
+ *    pullBody() resumes it once the client has drained half
+ * 5. EOF → close(15), mark the stream finished once the script has exited
+ * 
+ * A script exiting with an error before anything was sent becomes a 502;
+ * one producing more than cgi_max_output bytes is killed (abortCgi())
  */
 void ServerManager::readCgiResponse(int client_fd)
 {
-	Client& client = _clients[client_fd];
+	Client& client = *_clients[client_fd];
 	CgiHandler& cgi = client.response.cgi_obj;
+	StreamSource* cgi_out = client.response.cgiStream();
+	size_t high_water = client.response.getBufferSize();
 
 	char buffer[MESSAGE_BUFFER * 2];
 	ssize_t bytes_read;
 
-	// Try to read as much data as possible in one go (non-blocking)
-	// Keep reading until we get EAGAIN or EOF
+	if (!cgi_out)
+		return;
 	while (true)
 	{
-		bytes_read = read(cgi.pipe_out[0], buffer, MESSAGE_BUFFER * 2);
+		if (cgi_out->buffered() >= high_water)
+		{
+			// Client is slower than the script: leave the rest in the pipe
+			_loop->removeRead(cgi.pipe_out[0]);
+			client.cgi_paused = true;
+			break;
+		}
+
+		size_t room = std::min(sizeof(buffer), high_water - cgi_out->buffered());
+		bytes_read = read(cgi.pipe_out[0], buffer, room);
 
 		if (bytes_read > 0)
 		{
-			// Append data to response
-			client.response.response_content.append(buffer, bytes_read);
-			client.updateActivity();
-			// Clear buffer (C++98 compatible - no memset)
-			for (size_t i = 0; i < sizeof(buffer); ++i)
-				buffer[i] = 0;
-
-			// If we have data and response starts with HTTP headers, we can start sending
-			// Check if we have at least the status line and headers (look for \r\n\r\n)
-			size_t header_end = client.response.response_content.find("\r\n\r\n");
-			if (header_end != std::string::npos)
+			client.cgi_output += bytes_read;
+			if (client.cgi_output > client.server_config->getCgiMaxOutput())
 			{
-				// Headers are complete, we can start sending
-				// Update write_buffer if we're not already sending
-				if (client.write_offset == 0)
-				{
-					// Ensure we have HTTP status line
-					if (client.response.response_content.find("HTTP/1.1") == std::string::npos)
-					{
-						client.response.response_content.insert(0, "HTTP/1.1 200 OK\r\n");
-					}
-					// Update write_buffer with current response_content
-					client.write_buffer = client.response.getRes();
-
-					// Add to write_set if not already there
-					if (!_fd_manager.isSet(client_fd, _write_set))
-					{
-						_fd_manager.add(client_fd, _write_set);
-						Logger::info("CGI headers complete, starting to send response for fd=" + toString(client_fd));
-					}
-				}
-				else
-				{
-					// Already sending, but update buffer with new data
-					// This is important: the CGI script may write more data after we started sending
-					std::string new_buffer = client.response.getRes();
-					if (new_buffer.size() > client.write_buffer.size())
-					{
-						// More data arrived, update buffer
-						// Keep the current offset so we don't resend what we already sent
-						client.write_buffer = new_buffer;
-
-						// Always ensure client is in write_set when we have new data
-						if (!_fd_manager.isSet(client_fd, _write_set))
-						{
-							_fd_manager.add(client_fd, _write_set);
-						}
-					}
-				}
+				Logger::warn("CGI output over cgi_max_output for fd=" + toString(client_fd) + ", killing it");
+				abortCgi(client_fd, 502);
+				return;
 			}
-
-			// Continue reading to get all available data
-			continue;
+			if (client.cgi_start)
+			{
+				client.write_start = monotonicMicros();
+				Metrics::record(PHASE_CGI_FIRST, client.write_start - client.cgi_start);
+				client.cgi_start = 0;
+			}
+			if (!client.cgi_worker)
+			{
+				cgi_out->append(buffer, bytes_read);
+				continue;
+			}
+			FastCgiReader::Status status = client.cgi_worker->reader.feed(buffer, bytes_read, *cgi_out);
+			if (status == FastCgiReader::FEED_MORE)
+				continue;
+			finishPooledCgi(client_fd, status == FastCgiReader::FEED_END);
+			return;
 		}
-		else if (bytes_read == 0)
+		if (bytes_read == 0)
 		{
-			// EOF: CGI finished writing
-			_fd_manager.remove(cgi.pipe_out[0], _read_set);
-			close(cgi.pipe_out[0]);
+			// Pooled: the interpreter died mid-request
+			if (client.cgi_worker)
+				finishPooledCgi(client_fd, false);
+			else
+				finishCgiResponse(client_fd);
+			return;
+		}
+		// bytes_read < 0: pipe drained (EAGAIN)
+		break;
+	}
 
-			// Wait for CGI process to finish (non-blocking check first)
-			int status;
-			pid_t wait_result = waitpid(cgi.getCgiPid(), &status, WNOHANG);
+	if (client.response.cgiReady() && !_loop->isWriting(client_fd))
+		_loop->addWrite(client_fd);
+}
 
-			// If process hasn't finished yet, wait for it (should be quick since pipe is closed)
-			if (wait_result == 0)
-			{
-				waitpid(cgi.getCgiPid(), &status, 0);
-			}
+/**
+ * Exit status of a forked CGI → error page to send instead of its output
+ * 
+ * Example: calc.py raised an exception → exit(1) → 502; exit(0) → 0 (none)
+ */
+static short cgiExitError(int status)
+{
+	return (WIFEXITED(status) && WEXITSTATUS(status) != 0) ? 502 : 0;
+}
 
-			if (wait_result > 0 && WIFEXITED(status) && WEXITSTATUS(status) != 0)
-			{
-				client.response.setErrorResponse(502);
-			}
+/**
+ * CGI closed its stdout: the response ends once the script has exited too
+ * 
+ * Example: time.py printed its page and exited with status 0
+ * 1. close(15)
+ * 2. Already reaped (SIGCHLD came first) → completeCgiResponse() now;
+ *    still running → reapChildren() completes it when it exits
+ * 
+ * Nothing waits here: a script that closes stdout and keeps running
+ * only holds its own client, until cgi_timeout kills it
+ */
+void ServerManager::finishCgiResponse(int client_fd)
+{
+	Client& client = *_clients[client_fd];
 
-			client.response.setCgiState(2);
+	closeCgiPipe(client.response.cgi_obj.pipe_out[0]);
+	if (client.cgi_exit >= 0)
+		completeCgiResponse(client_fd, cgiExitError(client.cgi_exit));
+}
 
-			// If response doesn't start with HTTP/1.1, add status line
-			if (client.response.response_content.find("HTTP/1.1") == std::string::npos)
-			{
-				client.response.response_content.insert(0, "HTTP/1.1 200 OK\r\n");
-			}
+/**
+ * SIGCHLD fd readable: collects the exited children, never blocks
+ * 
+ * Example: time.py (pid 300) of client fd=10 exits
+ * - stdout already at EOF → completeCgiResponse(10) now
+ * - output still in the pipe → status kept in cgi_exit, EOF completes it
+ * Children without a client (killed at timeout, client gone, retired
+ * pool interpreters) are just reaped
+ */
+void ServerManager::reapChildren()
+{
+	std::vector<ChildExit> exited;
 
-			// Update write_buffer with final response
-			std::string final_buffer = client.response.getRes();
-			client.write_buffer = final_buffer;
+	_children.reap(exited);
+	for (size_t i = 0; i < exited.size(); ++i)
+	{
+		std::map<int, Client*>::iterator it = _clients.find(exited[i].owner);
+		if (it == _clients.end())
+			continue;
+		Client& client = *it->second;
+		CgiHandler& cgi = client.response.cgi_obj;
+		if (client.cgi_worker || cgi.getCgiPid() != exited[i].pid || client.response.getCgiState() != 1)
+			continue;
+		client.cgi_exit = exited[i].status;
+		if (!_dispatch.is(cgi.pipe_out[0], FD_CGI_STDOUT, it->first))
+			completeCgiResponse(it->first, cgiExitError(client.cgi_exit));
+	}
+}
 
-			// Check if we need to send more data
-			if (client.write_offset < final_buffer.size())
-			{
-				// There's still data to send
-				// Keep current offset - we've already sent up to that point
-
-				// Ensure client is in write_set to continue sending
-				if (!_fd_manager.isSet(client_fd, _write_set))
-				{
-					_fd_manager.add(client_fd, _write_set);
-				}
-			}
-			else
-			{
-				// All data already sent - close connection immediately
-				// This ensures browsers receive the complete response
-				Logger::info("CGI response complete for fd=" + toString(client_fd) + " (size: " + toString(client.write_buffer.size()) + " bytes) - closing connection");
-				_fd_manager.remove(client_fd, _write_set);
-				closeClient(client_fd);
-				return;
-			}
+/**
+ * Stops a CGI over its limits: cgi_timeout (504), cgi_max_output (502)
+ * 
+ * Example: sleep.py of fd=10 still running after cgi_timeout, nothing sent yet
+ * 1. kill(pid, SIGKILL), pipes closed; reapChildren() collects it later
+ *    (pooled: its interpreter is killed, or the request leaves the queue)
+ * 2. 504 page sent, the other connections were never held up
+ * 
+ * Part of the output already sent: the status line cannot change, the
+ * connection is closed. Script that closed its output but did not exit:
+ * the output is complete, killed and sent as is
+ */
+void ServerManager::abortCgi(int client_fd, short error_code)
+{
+	Client& client = *_clients[client_fd];
+	CgiHandler& cgi = client.response.cgi_obj;
+	StreamSource* cgi_out = client.response.cgiStream();
+	std::string pool_to_resume;
 
-			Logger::info("CGI response complete for fd=" + toString(client_fd) + " (size: " + toString(client.write_buffer.size()) + " bytes)");
-			return;
+	if (CgiWorker* worker = client.cgi_worker)
+	{
+		pool_to_resume = worker->interpreter;
+		detachPooledCgi(client);
+		_cgi_pool.discard(worker);
+	}
+	else if (cgi.pooled())
+		_cgi_pool.forget(cgi.getInterpreter(), client_fd);
+	else
+	{
+		if (!_dispatch.is(cgi.pipe_out[0], FD_CGI_STDOUT, client_fd))
+			error_code = 0;
+		if (client.cgi_exit < 0 && cgi.getCgiPid() > 0)
+		{
+			kill(cgi.getCgiPid(), SIGKILL);
+			_children.disown(cgi.getCgiPid());
 		}
-		else // bytes_read < 0
+		if (_dispatch.is(cgi.pipe_in[1], FD_CGI_STDIN, client_fd))
+			closeCgiPipe(cgi.pipe_in[1]);
+		if (_dispatch.is(cgi.pipe_out[0], FD_CGI_STDOUT, client_fd))
+			closeCgiPipe(cgi.pipe_out[0]);
+	}
+	if (error_code && cgi_out && cgi_out->pulled())
+		closeClient(client_fd);
+	else
+		completeCgiResponse(client_fd, error_code);
+	if (!pool_to_resume.empty())
+		runCgiQueue(pool_to_resume);
+}
+
+/**
+ * Script output complete (fork or pool): the last slice can go out
+ * 
+ * 1. Stream marked finished → pullBody() ends with BODY_END
+ * 2. error_code (script failed, limit hit) and nothing sent yet
+ *    → replaced by that error page
+ * 
+ * The connection may be kept alive (chunked output): a body the script
+ * never read has nobody left to read it, its pipe is closed now
+ */
+void ServerManager::completeCgiResponse(int client_fd, short error_code)
+{
+	Client& client = *_clients[client_fd];
+	StreamSource* cgi_out = client.response.cgiStream();
+	int cgi_stdin = client.response.cgi_obj.pipe_in[1];
+
+	if (!client.cgi_worker && _dispatch.is(cgi_stdin, FD_CGI_STDIN, client_fd))
+		closeCgiPipe(cgi_stdin);
+	client.response.setCgiState(2);
+	client.cgi_start = 0;
+	if (error_code && !(cgi_out && cgi_out->pulled()))
+	{
+		client.response.setErrorResponse(error_code);
+		client.write_buffer.clear();
+		client.write_offset = 0;
+		client.head_offset = 0;
+	}
+	else if (cgi_out)
+		cgi_out->finish();
+
+	LOG_INFO("CGI output complete for fd=" + toString(client_fd));
+	if (!client.write_start)
+		client.write_start = monotonicMicros();
+	setPhase(client, TIMEOUT_SEND);
+	if (!_loop->isWriting(client_fd))
+		_loop->addWrite(client_fd);
+}
+
+/**
+ * Registers the CGI's pipes with the event loop
+ * 
+ * Watch pipe_in[1] for writing (to send POST body to CGI)
+ * Watch pipe_out[0] for reading (to read CGI response)
+ */
+void ServerManager::watchCgiPipes(int client_fd)
+{
+	CgiHandler& cgi = _clients[client_fd]->response.cgi_obj;
+
+	_dispatch.set(cgi.pipe_in[1], FD_CGI_STDIN, client_fd);
+	_dispatch.set(cgi.pipe_out[0], FD_CGI_STDOUT, client_fd);
+	_loop->addWrite(cgi.pipe_in[1]);
+	_loop->addRead(cgi.pipe_out[0]);
+	LOG_INFO("CGI detected, pipes added to event loop for fd=" + toString(client_fd) +
+		" (pipe_out[0]=" + toString(cgi.pipe_out[0]) + ", pipe_in[1]=" + toString(cgi.pipe_in[1]) + ")");
+}
+
+/**
+ * Pooled CGI: waits for an interpreter of its pool
+ * 
+ * Example: cgi_pool 2, both interpreters busy
+ * fd=12 queued (its cgi_timeout keeps running) → started by runCgiQueue()
+ * when one finishes. CGI_POOL_QUEUE clients already waiting → 503 now
+ */
+void ServerManager::queuePooledCgi(int client_fd)
+{
+	Client& client = *_clients[client_fd];
+	std::string interpreter = client.response.cgi_obj.getInterpreter();
+
+	if (_cgi_pool.enqueue(interpreter, client.response.cgi_obj.getPoolSize(), client_fd))
+	{
+		runCgiQueue(interpreter);
+		return;
+	}
+	Logger::warn("CGI pool " + interpreter + " saturated, rejecting fd=" + toString(client_fd));
+	client.cgi_start = 0;
+	client.response.setCgiState(2);
+	client.response.setErrorResponse(503);
+	_loop->addWrite(client_fd);
+	setPhase(client, TIMEOUT_SEND);
+	client.write_start = monotonicMicros();
+}
+
+/**
+ * Hands free interpreters to the clients waiting for them, oldest first
+ * 
+ * No interpreter can be started and none is busy (fork() failing, bad
+ * interpreter path): nothing would ever free one, the waiting clients get a 502
+ */
+void ServerManager::runCgiQueue(const std::string& interpreter)
+{
+	while (_cgi_pool.hasWaiting(interpreter))
+	{
+		CgiWorker* worker = _cgi_pool.acquire(interpreter);
+		if (!worker && _cgi_pool.busy(interpreter) > 0)
+			return;  // Every interpreter busy: the next release resumes the queue
+
+		int client_fd = _cgi_pool.popWaiting(interpreter);
+		if (worker)
+			startPooledCgi(client_fd, worker);
+		else
 		{
-			client.updateActivity();
-			return;
+			Logger::error("CGI pool " + interpreter + ": no interpreter could be started");
+			completeCgiResponse(client_fd, 502);
 		}
 	}
 }
 
+/**
+ * Sends a queued request to a pool interpreter
+ * 
+ * Example: fd=12 gets interpreter pid 300 (stdin pipe 20, stdout pipe 21)
+ * cgi.pipe_in[1] = 20, cgi.pipe_out[0] = 21 → same handlers as a forked CGI;
+ * cgi_stdin frames the request (params, then the body as STDIN records)
+ */
+void ServerManager::startPooledCgi(int client_fd, CgiWorker* worker)
+{
+	Client& client = *_clients[client_fd];
+	CgiHandler& cgi = client.response.cgi_obj;
+
+	client.cgi_worker = worker;
+	cgi.pipe_in[1] = worker->to_worker;
+	cgi.pipe_out[0] = worker->from_worker;
+	cgi.setCgiPid(worker->pid);
+	client.cgi_stdin.start(client.request.getBody(), FastCgi::encodeHead(cgi.getCgiPath(), cgi.getEnv()));
+	watchCgiPipes(client_fd);
+}
+
+/**
+ * Pooled CGI answered END_REQUEST (completed), or its interpreter broke
+ * 
+ * The interpreter goes back to its pool only if the exchange ended cleanly:
+ * request fully written, END_REQUEST read. Anything else (died, garbled
+ * record, answered before reading its whole body) → killed, not reused.
+ * A non-zero script exit status is handled like a forked CGI's (502)
+ */
+void ServerManager::finishPooledCgi(int client_fd, bool completed)
+{
+	Client& client = *_clients[client_fd];
+	CgiHandler& cgi = client.response.cgi_obj;
+	CgiWorker* worker = client.cgi_worker;
+	std::string interpreter = worker->interpreter;
+	bool in_sync = completed && !_dispatch.is(cgi.pipe_in[1], FD_CGI_STDIN, client_fd);
+	bool failed = !completed || worker->reader.appStatus() != 0;
+
+	if (!in_sync)
+		Logger::warn("CGI pool: interpreter pid " + toString(worker->pid) + " failed on fd=" + toString(client_fd));
+	detachPooledCgi(client);
+	if (in_sync)
+		_cgi_pool.release(worker, cgi.getPoolMaxRequests());
+	else
+		_cgi_pool.discard(worker);
+	completeCgiResponse(client_fd, failed ? 502 : 0);
+	runCgiQueue(interpreter);
+}
+
+/**
+ * Unhooks a client from its pool interpreter (pipes stay open, owned by the pool)
+ */
+void ServerManager::detachPooledCgi(Client& client)
+{
+	CgiHandler& cgi = client.response.cgi_obj;
+
+	if (_dispatch.is(cgi.pipe_in[1], FD_CGI_STDIN, client.socket_fd))
+		detachCgiPipe(cgi.pipe_in[1]);
+	if (_dispatch.is(cgi.pipe_out[0], FD_CGI_STDOUT, client.socket_fd))
+		detachCgiPipe(cgi.pipe_out[0]);
+	cgi.pipe_in[1] = -1;
+	cgi.pipe_out[0] = -1;
+	client.cgi_worker = NULL;
+}
@@ -1,6 +1,8 @@
 #include "ServerManager.hpp"
 #include "SocketOps.hpp"
 #include "Logger.hpp"
+#include "Metrics.hpp"
+#include <csignal>
 
 /**
  * Reads data from socket into buffer (non-blocking)
@@ -51,53 +53,194 @@ ssize_t ServerManager::writeToSocket(int fd, const std::string& buffer, size_t&
 	return bytes;
 }
 
+static const char* phaseName(TimeoutPhase phase)
+{
+	static const char* names[TIMEOUT_PHASES] = {"header", "body", "send", "keep-alive", "CGI"};
+	return names[phase];
+}
+
 /**
- * Closes idle clients that haven't sent/received data in 60 seconds
+ * Closes the clients whose current phase has run out of time
  * 
- * Example: Client fd=10 connected but inactive
- * - last_activity = 1234567890
- * - now = 1234567950 (60 seconds later)
- * - Timeout! Close fd=10 to free resources
+ * Example: 10000 keep-alive clients, fd=10 idle since 12:00:00, keepalive_timeout 15
+ * now = 12:00:15 → the wheel visits the single slot of 12:00:15 → expired = {10}
+ * → "Client timeout (keep-alive): fd=10" → closeClient(10)
+ * The other 9999 clients are not looked at
  * 
- * Prevents resource exhaustion from abandoned connections
+ * A CGI that overran cgi_timeout is killed instead: its client gets a 504
  */
 void ServerManager::checkTimeouts()
 {
-	time_t now = time(NULL);
-	std::vector<int> to_close;
+	std::vector<int> expired;
 	
-	for (std::map<int, Client>::iterator it = _clients.begin(); it != _clients.end(); ++it)
+	_timers.expire(time(NULL), expired);
+	for (size_t i = 0; i < expired.size(); ++i)
 	{
-		if (it->second.isTimedOut(now, CONNECTION_TIMEOUT))
-		{
-			Logger::warn("Client timeout: fd=" + toString(it->first));
-			to_close.push_back(it->first);
-		}
+		int fd = expired[i];
+		std::map<int, Client*>::iterator it = _clients.find(fd);
+		if (it == _clients.end())
+			continue;
+		Client& client = *it->second;
+		Logger::warn(std::string("Client timeout (") + phaseName(client.phase) + "): fd=" + toString(fd));
+		if (client.phase == TIMEOUT_CGI && client.response.getCgiState() == 1)
+			abortCgi(fd, 504);
+		else
+			closeClient(fd);
 	}
+}
+
+/**
+ * Enters a new phase: its timeout starts now
+ * 
+ * Example: response to fd=10 fully sent at 12:00:00.4, keepalive_timeout 15
+ * setPhase(client, TIMEOUT_KEEPALIVE) → timer moved to 12:00:16 (O(1))
+ * The extra second covers the part of the current second already gone:
+ * a timer never fires before its full timeout
+ * Timeouts come from the server block the client connected to
+ */
+void ServerManager::setPhase(Client& client, TimeoutPhase phase)
+{
+	time_t timeout = client.server_config ? client.server_config->getTimeout(phase) : CLIENT_HEADER_TIMEOUT;
 	
-	for (size_t i = 0; i < to_close.size(); ++i)
-		closeClient(to_close[i]);
+	client.phase = phase;
+	_timers.schedule(client.timer, _timers.now() + timeout + 1);
+	// A request starts with its header phase: start of its access-log duration
+	if (phase == TIMEOUT_HEADER && Logger::accessEnabled())
+		gettimeofday(&client.request_start, NULL);
+}
+
+/**
+ * Counts a fully sent response in the metrics
+ * 
+ * Example: GET /banana.jpg, ready at t=1000us, last byte sent at t=1800us
+ * → status[200]++, bytes_out += 50213, write histogram gets 800us
+ */
+void ServerManager::recordResponse(Client& client)
+{
+	Metrics::response(client.response.getCode());
+	Metrics::bytesOut(client.bytes_sent);
+	if (client.write_start)
+		Metrics::record(PHASE_WRITE, monotonicMicros() - client.write_start);
+}
+
+/**
+ * Writes the access log line of a response that has been fully sent
+ * 
+ * Example: keep-alive GET /banana.jpg
+ * → 127.0.0.1 - - [20/Nov/2025:14:03:12 +0100] "GET /banana.jpg HTTP/1.1" 200 50213 0.002
+ */
+void ServerManager::logAccess(Client& client)
+{
+	HttpRequest& request = client.request;
+	std::string line = request.getMethodStr() + " " + request.getPath();
+	
+	if (!request.getQuery().empty())
+		line += "?" + request.getQuery();
+	line += request.isHttp11() ? " HTTP/1.1" : " HTTP/1.0";
+	std::string address = client.getAddressString();
+	Logger::access(address.substr(0, address.rfind(':')), line, client.response.getCode(),
+		client.bytes_sent, client.request_start);
+}
+
+/**
+ * Progress was made: pushes back an inactivity deadline (body read, send)
+ * 
+ * Example: 1GB upload, client_body_timeout 60 → each read gives 60 more seconds
+ * Header and CGI deadlines are not moved (a slow client cannot stretch them)
+ */
+void ServerManager::refreshTimeout(Client& client)
+{
+	if (client.phase == TIMEOUT_BODY || client.phase == TIMEOUT_SEND)
+		setPhase(client, client.phase);
 }
 
 /**
  * Cleans up client connection completely
  * 
  * Example: After sending banana.jpg, close fd=10
- * 1. Remove fd=10 from _read_set (stop monitoring reads)
- * 2. Remove fd=10 from _write_set (stop monitoring writes)
+ * 1. Close CGI pipes still owned by fd=10 (client left during CGI),
+ *    kill its CGI or pool interpreter, or take it out of the pool's queue,
+ *    hand the static file fd back to the cache, disarm its timer
+ * 2. Stop monitoring fd=10 (reads and writes)
  * 3. close(10) - OS releases socket
- * 4. Delete from _clients map (free memory)
+ * 4. Hand the Client back to the pool (buffers kept for the next connection)
  * 5. _active_connections-- (update stats)
  * 
  * fd=10 is now available for next connection
+ * 
+ * Request still with a FilePool thread: fd=10 is only silenced (no events,
+ * no timer) and really closed by completeFileJobs()
  */
 void ServerManager::closeClient(int fd)
 {
-	_fd_manager.remove(fd, _read_set);
-	_fd_manager.remove(fd, _write_set);
+	std::map<int, Client*>::iterator it = _clients.find(fd);
+	std::string pool_to_resume;
+	if (it != _clients.end() && it->second->file_job)
+	{
+		// A FilePool thread still uses the request: the socket stays open (its
+		// fd cannot be reused yet), silent, until completeFileJobs() closes it
+		it->second->close_pending = true;
+		_timers.cancel(it->second->timer);
+		_loop->removeFd(fd);
+		return;
+	}
+	if (it != _clients.end())
+	{
+		CgiHandler& cgi = it->second->response.cgi_obj;
+		if (CgiWorker* worker = it->second->cgi_worker)
+		{
+			// Interpreter mid-request: its output can no longer be trusted
+			pool_to_resume = worker->interpreter;
+			detachPooledCgi(*it->second);
+			_cgi_pool.discard(worker);
+		}
+		else if (cgi.pooled() && it->second->response.getCgiState() == 1)
+			_cgi_pool.forget(cgi.getInterpreter(), fd);
+		else if (it->second->response.getCgiState() == 1 && it->second->cgi_exit < 0 && cgi.getCgiPid() > 0)
+		{
+			// Forked CGI still running: killed, reaped later by reapChildren()
+			kill(cgi.getCgiPid(), SIGKILL);
+			_children.disown(cgi.getCgiPid());
+		}
+		if (_dispatch.is(cgi.pipe_in[1], FD_CGI_STDIN, fd))
+			closeCgiPipe(cgi.pipe_in[1]);
+		if (_dispatch.is(cgi.pipe_out[0], FD_CGI_STDOUT, fd))
+			closeCgiPipe(cgi.pipe_out[0]);
+		it->second->response.releaseFile();
+		_timers.cancel(it->second->timer);
+		_client_pool.release(it->second);
+		_clients.erase(it);
+	}
+	
+	_loop->removeFd(fd);
+	_dispatch.clear(fd);
 	SocketOps::closeSocket(fd);
-	_clients.erase(fd);
 	
 	_active_connections--;
+	Metrics::connectionClosed();
+	if (!pool_to_resume.empty())
+		runCgiQueue(pool_to_resume);
+}
+
+/**
+ * Closes one end of a CGI pipe and forgets it
+ * 
+ * Example: POST body fully written to pipe_in[1]=16
+ * closeCgiPipe(16) → stop monitoring, _dispatch[16] = FD_NONE, close(16)
+ * CGI script sees EOF on its stdin
+ */
+void ServerManager::closeCgiPipe(int pipe_fd)
+{
+	detachCgiPipe(pipe_fd);
+	close(pipe_fd);
 }
 
+/**
+ * Stops monitoring a CGI pipe without closing it (pool interpreter pipes
+ * are reused by the next request)
+ */
+void ServerManager::detachCgiPipe(int pipe_fd)
+{
+	_loop->removeFd(pipe_fd);
+	_dispatch.clear(pipe_fd);
+}
@@ -1,5 +1,8 @@
 #include "SocketOps.hpp"
 #include "Logger.hpp"
+#ifdef __linux__
+# include <sys/sendfile.h>
+#endif
 
 /**
  * Creates a TCP socket for server listening
@@ -12,6 +15,7 @@ int SocketOps::createSocket()
 	int fd = socket(AF_INET, SOCK_STREAM, 0);
 	if (fd < 0)
 		throw std::runtime_error("Failed to create socket: " + std::string(strerror(errno)));
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
 	return fd;
 }
 
@@ -78,11 +82,26 @@ void SocketOps::listenSocket(int fd, int backlog)
  * Input: server_fd=5
  * Returns: client_fd=10 (NEW socket just for this client)
  * client_addr filled with: {ip: 127.0.0.1, port: 54321}
+ * 
+ * The socket comes back non-blocking and close-on-exec in the same
+ * syscall (accept4): CGI processes (and the long-lived CGI pool
+ * interpreters) must not keep client sockets open after the server
+ * closes them. Returns -1 with errno EAGAIN once the queue is empty
  */
 int SocketOps::acceptConnection(int server_fd, struct sockaddr_in& client_addr)
 {
 	socklen_t addr_len = sizeof(client_addr);
-	return accept(server_fd, (struct sockaddr*)&client_addr, &addr_len);
+#ifdef __linux__
+	return accept4(server_fd, (struct sockaddr*)&client_addr, &addr_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+	int fd = accept(server_fd, (struct sockaddr*)&client_addr, &addr_len);
+	if (fd >= 0)
+	{
+		fcntl(fd, F_SETFD, FD_CLOEXEC);
+		setNonBlocking(fd);
+	}
+	return fd;
+#endif
 }
 
 /**
@@ -95,3 +114,59 @@ void SocketOps::closeSocket(int fd)
 	close(fd);
 }
 
+
+/**
+ * Sends up to count bytes of file_fd, starting at offset, to sock_fd
+ *
+ * Example: banana.jpg (50000 bytes) on client_fd=10
+ * sendFile(10, 12, offset=0, 50000) → returns 32768, offset=32768
+ * The kernel copies page cache → socket: no read() into user space
+ *
+ * Returns bytes sent (offset advanced), 0 if the file is shorter than
+ * expected, -1 on error (errno EAGAIN when the socket buffer is full)
+ */
+ssize_t SocketOps::sendFile(int sock_fd, int file_fd, off_t& offset, size_t count)
+{
+#ifdef __linux__
+	return sendfile(sock_fd, file_fd, &offset, count);
+#else
+	char buffer[MESSAGE_BUFFER];
+	if (count > sizeof(buffer))
+		count = sizeof(buffer);
+	ssize_t n = pread(file_fd, buffer, count, offset);
+	if (n <= 0)
+		return n;
+	ssize_t sent = send(sock_fd, buffer, n, 0);
+	if (sent > 0)
+		offset += sent;
+	return sent;
+#endif
+}
+
+/**
+ * Sends several buffers with one system call, without joining them first
+ *
+ * Example: 200 for /index.html (180 bytes of headers, 4096 bytes of body)
+ * sendVector(10, {head, body}, 2, false) → returns 4276, one TCP segment train
+ *
+ * more = true: a sendfile() body follows, MSG_MORE holds the headers back
+ * so they leave in the same packet as the first bytes of the file
+ *
+ * Returns bytes sent, -1 on error (errno EAGAIN when the socket buffer is full)
+ */
+ssize_t SocketOps::sendVector(int sock_fd, struct iovec* iov, int count, bool more)
+{
+	struct msghdr msg;
+	int flags = 0;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = count;
+#ifdef MSG_MORE
+	if (more)
+		flags |= MSG_MORE;
+#else
+	(void)more;
+#endif
+	return sendmsg(sock_fd, &msg, flags);
+}
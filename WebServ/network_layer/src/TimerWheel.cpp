@@ -0,0 +1,112 @@
+#include "TimerWheel.hpp"
+
+TimerNode::TimerNode() : prev(NULL), next(NULL), deadline(0), fd(-1)
+{
+}
+
+bool TimerNode::armed() const
+{
+	return next != NULL;
+}
+
+TimerWheel::TimerWheel() : _slots(TIMER_WHEEL_SLOTS), _now(time(NULL)), _size(0)
+{
+	for (size_t i = 0; i < _slots.size(); ++i)
+	{
+		_slots[i].prev = &_slots[i];
+		_slots[i].next = &_slots[i];
+	}
+}
+
+/**
+ * Current time as of the last expire() call (one time() per loop turn)
+ */
+time_t TimerWheel::now() const
+{
+	return _now;
+}
+
+/**
+ * Arms or re-arms a timer (moved to the slot of its new deadline)
+ *
+ * Example: fd=10 reads more body bytes at 12:00:05, client_body_timeout 60
+ * schedule(node, 12:01:05) → unlinked from slot 12:00:55, linked in slot 12:01:05
+ * A deadline already in the past fires on the next expire()
+ */
+void TimerWheel::schedule(TimerNode& node, time_t deadline)
+{
+	if (node.armed())
+		unlink(node);
+	else
+		_size++;
+	if (deadline <= _now)
+		deadline = _now + 1;
+	node.deadline = deadline;
+
+	TimerNode& head = _slots[deadline % TIMER_WHEEL_SLOTS];
+	node.prev = head.prev;
+	node.next = &head;
+	head.prev->next = &node;
+	head.prev = &node;
+}
+
+/**
+ * Disarms a timer (connection closed); no-op if it is not armed
+ */
+void TimerWheel::cancel(TimerNode& node)
+{
+	if (!node.armed())
+		return;
+	unlink(node);
+	_size--;
+}
+
+/**
+ * Collects the fds whose deadline has passed, in deadline order
+ *
+ * Example: last call at 12:00:04, now = 12:00:06
+ * Visits slots 12:00:05 and 12:00:06 → expired = {10, 14}
+ * The nodes are disarmed: the caller closes (or re-arms) each fd
+ *
+ * After a long pause (suspended process) each slot is visited once at most
+ */
+void TimerWheel::expire(time_t now, std::vector<int>& expired)
+{
+	if (now <= _now)
+		return;
+	time_t first = _now + 1;
+	if (now - first >= TIMER_WHEEL_SLOTS)
+		first = now - TIMER_WHEEL_SLOTS + 1;
+	_now = now;
+
+	for (time_t tick = first; tick <= now; ++tick)
+	{
+		TimerNode& head = _slots[tick % TIMER_WHEEL_SLOTS];
+		TimerNode* node = head.next;
+
+		while (node != &head)
+		{
+			TimerNode* next = node->next;
+			if (node->deadline <= now)
+			{
+				unlink(*node);
+				_size--;
+				expired.push_back(node->fd);
+			}
+			node = next;
+		}
+	}
+}
+
+size_t TimerWheel::size() const
+{
+	return _size;
+}
+
+void TimerWheel::unlink(TimerNode& node)
+{
+	node.prev->next = node.next;
+	node.next->prev = node.prev;
+	node.prev = NULL;
+	node.next = NULL;
+}
@@ -6,31 +6,32 @@
  * 
  * 1. STARTUP (main):
  *    - Load config → create server socket fd=5 on port 8080
- *    - Add fd=5 to _read_set
- *    - Enter event loop (select)
+ *      (with -w N: fork N workers, each with its own socket, see MasterProcess)
+ *    - Register fd=5 for reading
+ *    - Enter event loop (epoll on Linux, select elsewhere)
  * 
  * 2. CONNECTION (acceptNewConnection):
- *    - Browser connects → select() says fd=5 readable
+ *    - Browser connects → wait() says fd=5 readable
  *    - accept(5) → creates client socket fd=10
- *    - Add fd=10 to _read_set
+ *    - Register fd=10 for reading
  * 
  * 3. REQUEST (handleClientRead):
  *    - Browser sends "GET /banana.jpg HTTP/1.1\r\n\r\n"
- *    - select() says fd=10 readable
+ *    - wait() says fd=10 readable
  *    - recv(10) → read into client.read_buffer
  *    - Parse HTTP request
  *    - Build response (read banana.jpg file)
- *    - Add fd=10 to _write_set
+ *    - Register fd=10 for writing
  * 
  * 4. RESPONSE (handleClientWrite):
- *    - select() says fd=10 writable
+ *    - wait() says fd=10 writable
  *    - send(10, "HTTP/1.1 200 OK\r\n...[JPEG data]")
  *    - May take multiple calls if large file
  *    - Track progress with write_offset
  * 
  * 5. CLEANUP (closeClient):
  *    - All data sent → close(10)
- *    - Remove fd=10 from all sets
+ *    - Stop monitoring fd=10
  *    - Free memory
  * 
  * Person A's responsibility: Network & Client Management
@@ -38,53 +39,225 @@
  */
 
 #include "ServerManager.hpp"
+#include "MasterProcess.hpp"
 #include "Logger.hpp"
+#include "Metrics.hpp"
 #include <csignal>
+#include <cctype>
+#include <cstdlib>
+#include <sys/resource.h>
 
 static ServerManager* g_manager = NULL;
 
+/**
+ * SIGINT/SIGTERM: graceful stop (only sets a flag, see ServerManager::requestStop)
+ */
 void signalHandler(int signum)
 {
 	(void)signum;
-	Logger::info("Received signal, shutting down...");
 	if (g_manager)
-		g_manager->stop();
+		g_manager->requestStop();
 }
 
+/**
+ * Installs the handlers, then unblocks the signals
+ * (a worker is forked with them blocked by its master)
+ * SIGCHLD stays blocked: ServerManager reads it from a signalfd (ChildRegistry)
+ */
 void setupSignalHandlers()
 {
+	sigset_t unblock;
+	
 	signal(SIGINT, signalHandler);
 	signal(SIGTERM, signalHandler);
 	signal(SIGPIPE, SIG_IGN);
+	sigemptyset(&unblock);
+	sigaddset(&unblock, SIGINT);
+	sigaddset(&unblock, SIGTERM);
+	sigprocmask(SIG_UNBLOCK, &unblock, NULL);
 }
 
-int main(int argc, char** argv)
+/**
+ * Raises the open-files soft limit to the hard limit
+ * 
+ * Example: ulimit -n = 1024, hard limit = 1048576
+ * Soft limit becomes 1048576 → 50k+ keep-alive connections fit
+ */
+void raiseFdLimit()
 {
-	std::string config_file = "config/default.conf";
-	
-	if (argc > 1)
-		config_file = argv[1];
+	struct rlimit rl;
 	
-	Logger::info("Starting WebServ...");
-	Logger::info("Config file: " + config_file);
+	if (getrlimit(RLIMIT_NOFILE, &rl) < 0 || rl.rlim_cur == rl.rlim_max)
+		return;
+	rl.rlim_cur = rl.rlim_max;
+	if (setrlimit(RLIMIT_NOFILE, &rl) == 0)
+		Logger::info("Open files limit raised to " + toString(rl.rlim_cur));
+}
+
+/**
+ * Runs one event loop until SIGINT/SIGTERM: the whole server in
+ * single-process mode, or one worker in worker mode
+ * 
+ * Example: worker 2 of ./webserv -w 4
+ * serve(servers, true) → own SO_REUSEPORT listener on :8080 → run()
+ * Returns WORKER_EXIT_FATAL if the listeners cannot be opened
+ * 
+ * Logging goes through the writer thread while the loop runs (started
+ * here, after any fork(), and flushed before returning)
+ */
+int serve(const std::vector<ServerConfig>& servers, bool reuse_port)
+{
 	setupSignalHandlers();
-	
 	try
 	{
 		ServerManager manager;
 		g_manager = &manager;
 		
-		manager.loadConfig(config_file);
+		for (size_t i = 0; i < servers.size(); ++i)
+			manager.addServer(servers[i]);
+		try
+		{
+			manager.openListeners(reuse_port);
+		}
+		catch (const std::exception& e)
+		{
+			Logger::error(std::string("Cannot open listeners: ") + e.what());
+			g_manager = NULL;
+			return WORKER_EXIT_FATAL;
+		}
 		Logger::info("Server ready - starting event loop");
+		Logger::startAsync();
 		manager.run();
+		g_manager = NULL;
 	}
 	catch (const std::exception& e)
 	{
+		g_manager = NULL;
 		Logger::error(std::string("Fatal error: ") + e.what());
+		Logger::stopAsync();
 		return 1;
 	}
-	
-	Logger::info("WebServ shutdown complete");
+	Logger::stopAsync();
 	return 0;
 }
 
+/**
+ * Parses the -w value: "auto" (one worker per online core, within 1..MAX_WORKERS)
+ * or a plain decimal count in 1..MAX_WORKERS
+ * Example: "4" → 4, "auto" → 8 on 8 cores; "4x", "", "0", "-3", "99999" → false
+ */
+static bool parseWorkers(const std::string& value, int& workers)
+{
+	if (value == "auto")
+	{
+		long cores = sysconf(_SC_NPROCESSORS_ONLN);
+		workers = cores < 1 ? 1 : (cores > MAX_WORKERS ? MAX_WORKERS : cores);
+		return true;
+	}
+	char* end;
+	errno = 0;
+	long n = strtol(value.c_str(), &end, 10);
+	if (value.empty() || !isdigit(value[0]) || *end != '\0' || errno == ERANGE
+		|| n < 1 || n > MAX_WORKERS)
+		return false;
+	workers = n;
+	return true;
+}
+
+/**
+ * Parses the command line:
+ * - "-w N" / "--workers N" (N = count or "auto")
+ * - "-l LEVEL" / "--log-level LEVEL" (debug, info, warn, error, off)
+ * - "-a FILE" / "--access-log FILE" ("-" = stdout)
+ * - the config path
+ * 
+ * Example: ./webserv -w auto -l warn -a access.log config/default.conf on 8 cores
+ * → workers = 8, only warnings and errors, one access.log line per response
+ * Without -w: workers = 0 (single process, as before)
+ */
+static bool parseArgs(int argc, char** argv, int& workers, std::string& config_file)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "-w" || arg == "--workers")
+		{
+			if (i + 1 >= argc)
+				return false;
+			if (!parseWorkers(argv[++i], workers))
+			{
+				std::cerr << "Invalid worker count " << argv[i] << ": expected 1-" << MAX_WORKERS << " or auto" << std::endl;
+				return false;
+			}
+		}
+		else if (arg == "-l" || arg == "--log-level")
+		{
+			LogLevel level;
+			if (i + 1 >= argc || !Logger::parseLevel(argv[++i], level))
+				return false;
+			Logger::setLevel(level);
+		}
+		else if (arg == "-a" || arg == "--access-log")
+		{
+			if (i + 1 >= argc)
+				return false;
+			if (!Logger::openAccessLog(argv[++i]))
+			{
+				std::cerr << "Cannot open access log " << argv[i] << ": " << strerror(errno) << std::endl;
+				return false;
+			}
+		}
+		else
+			config_file = arg;
+	}
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	std::string config_file = "config/default.conf";
+	std::vector<ServerConfig> servers;
+	int workers = 0;
+	
+	if (!parseArgs(argc, argv, workers, config_file))
+	{
+		std::cerr << "Usage: " << argv[0] << " [-w N|auto] [-l debug|info|warn|error|off] [-a access_log] [config_file]" << std::endl;
+		return 1;
+	}
+	
+	Logger::info("Starting WebServ...");
+	Logger::info("Config file: " + config_file);
+	raiseFdLimit();
+	BodySink::captureUmask();
+	
+	try
+	{
+		ConfigParser parser;
+		parser.createCluster(config_file);
+		servers = parser.getServers();
+		Logger::info("Loaded " + toString(servers.size()) + " server(s) from config");
+	}
+	catch (const std::exception& e)
+	{
+		Logger::error("Config parsing failed: " + std::string(e.what()));
+		return 1;
+	}
+	
+	if (!Metrics::init(workers > 0 ? workers : 1))
+		Logger::warn("Metrics disabled: " + std::string(strerror(errno)));
+	
+	int status;
+	if (workers > 0)
+	{
+		MasterProcess master(servers, workers, serve);
+		status = master.run();
+	}
+	else
+	{
+		Metrics::attach(0);
+		status = serve(servers, false);
+	}
+	
+	Logger::info("WebServ shutdown complete");
+	return status;
+}